@@ -1,222 +1,772 @@
 #pragma once
 
+#include <atomic>
 #include <cstring>
+#include <utility>
+#include <immintrin.h>
 
 #include <Objects.hpp>
 #include <NumTypes.hpp>
 
+#include "GpuTopology.hpp"
+#include "ReplacementPolicy.hpp"
+#include "StridePrefetcher.hpp"
+
 enum class MESI : u8
 {
     Modified = 0,
     Exclusive = 1,
     Shared = 2,
-    Invalid = 3
+    Invalid = 3,
+    // Dirty and possibly shared, only used by ECoherenceProtocol::Moesi L0s. The owner writes the line back.
+    Owned = 4
 };
 
-template<uSys IndexBits>
-struct CacheLine final
+[[nodiscard]] inline bool IsDirty(const MESI state) noexcept { return state == MESI::Modified || state == MESI::Owned; }
+
+// Where a read was served from, this is what its latency is modeled on.
+enum class ECacheLevel : u8
 {
-    DEFAULT_DESTRUCT(CacheLine);
-    DELETE_CM(CacheLine);
-public:
-    MESI Mesi : 2;
-    u64 Tag : 61 - IndexBits; // 3 bits of offset, IndexBits bits of set index
-    u64 External : 1; // Was this from external memory?
-    u64 Pad : 8; // Because we're at a high level we'll pad the structure to be nice.
-    u32 Data[8]; // 32 bytes / 8 words per cache line.
-
-    CacheLine() noexcept
-        : Mesi(MESI::Invalid)
-        , Tag{ }
-        , External{ }
-        , Pad{ }
-        , Data{ }
-    { }
+    L0 = 0,
+    // Also used for lines supplied by another L0, that transfer happens over the L2's bus.
+    L2,
+    Memory
+};
 
-    void Reset()
-    {
-        Mesi = MESI::Invalid;
-        Tag = { };
-        External = { };
-        Pad = { };
-    }
+// How a load or store asks the caches to treat its line, this is encoded in the LoadStore instruction.
+enum class ECacheHint : u8
+{
+    Normal = 0,
+    // Data read through once, the line is allocated as the next victim and hits don't promote it.
+    Streaming,
+    // Data that won't be reused, a miss goes around the L0 without allocating. Hits are treated as Streaming.
+    NonTemporal,
+    // Reused data such as lookup tables, the line is passed over for eviction while its set has lines that aren't kept.
+    // The L2 keeps it too, it never sees the L0's hits so would otherwise age it out and back-invalidate it.
+    Keep
 };
 
-template<uSys IndexBits, uSys SetLineCount>
+// 32 bytes / 8 words per cache line.
+static inline constexpr uSys CACHE_LINE_WORD_COUNT = 8;
+
+/**
+ * \brief The tag store of a single set, the line data is kept separately.
+ *
+ *   Each way's tag and External bit are packed into a 64 bit key, and
+ * the keys of a set are contiguous so a lookup compares 4 ways per AVX2
+ * instruction instead of decoding a bitfield per line. The key array is
+ * padded to a multiple of 4 with INVALID_KEY, which no address produces.
+ */
+template<uSys SetLineCount>
 struct CacheSet final
 {
     DEFAULT_CONSTRUCT_PU(CacheSet);
     DEFAULT_DESTRUCT(CacheSet);
     DELETE_CM(CacheSet);
 public:
-    CacheLine<IndexBits> SetLines[SetLineCount];
+    static_assert(SetLineCount <= 32, "The tag match mask is 32 bits.");
+
+    static inline constexpr uSys KEY_COUNT = (SetLineCount + 3) & ~static_cast<uSys>(3);
+    // Tags are at most 61 bits, so the key never has every bit set.
+    static inline constexpr u64 INVALID_KEY = ~0ull;
+    // What FindWay returns when no way matches.
+    static inline constexpr uSys NO_WAY = 32;
+
+    alignas(32) u64 Keys[KEY_COUNT];
+    MESI States[SetLineCount];
+    // A bit for every way holding a dirty line.
+    u32 DirtyMask;
 
     void Reset()
     {
+        for(uSys i = 0; i < KEY_COUNT; ++i)
+        {
+            Keys[i] = INVALID_KEY;
+        }
+
         for(uSys i = 0; i < SetLineCount; ++i)
         {
-            SetLines[i].Reset();
+            States[i] = MESI::Invalid;
+        }
+
+        DirtyMask = 0;
+    }
+
+    // Returns whether the set still holds any dirty lines.
+    bool SetState(const uSys way, const MESI state) noexcept
+    {
+        States[way] = state;
+
+        if(IsDirty(state))
+        {
+            DirtyMask |= 1u << way;
+        }
+        else
+        {
+            DirtyMask &= ~(1u << way);
+        }
+
+        return DirtyMask != 0;
+    }
+
+    [[nodiscard]] static u64 MakeKey(const u64 tag, const bool external) noexcept { return (tag << 1) | (external ? 1 : 0); }
+    [[nodiscard]] static u64 KeyTag(const u64 key) noexcept { return key >> 1; }
+    [[nodiscard]] static bool KeyExternal(const u64 key) noexcept { return (key & 0x1) != 0; }
+
+    // A bit for every way whose key matches.
+    [[nodiscard]] u32 Match(const u64 key) const noexcept
+    {
+        const __m256i keyVector = _mm256_set1_epi64x(static_cast<long long>(key));
+
+        u32 matches = 0;
+
+        for(uSys i = 0; i < KEY_COUNT; i += 4)
+        {
+            const __m256i keys = _mm256_load_si256(reinterpret_cast<const __m256i*>(Keys + i));
+            const __m256i equal = _mm256_cmpeq_epi64(keys, keyVector);
+            matches |= static_cast<u32>(_mm256_movemask_pd(_mm256_castsi256_pd(equal))) << i;
+        }
+
+        return matches;
+    }
+
+    [[nodiscard]] uSys FindWay(const u64 key) const noexcept
+    {
+        // A set never holds the same key twice, and tzcnt of 0 is 32.
+        return _tzcnt_u32(Match(key));
+    }
+};
+
+/**
+ * \brief A bit for every set of a cache that holds dirty lines, so a flush skips the clean sets.
+ */
+template<uSys SetCount>
+struct DirtySetMap final
+{
+    DEFAULT_CONSTRUCT_PU(DirtySetMap);
+    DEFAULT_DESTRUCT(DirtySetMap);
+    DELETE_CM(DirtySetMap);
+public:
+    static inline constexpr uSys WORD_COUNT = (SetCount + 63) / 64;
+
+    u64 Words[WORD_COUNT];
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(Words, 0, sizeof(Words));
+    }
+
+    void Update(const u64 setIndex, const bool dirty) noexcept
+    {
+        const u64 setBit = 1ull << (setIndex & 63);
+
+        if(dirty)
+        {
+            Words[setIndex >> 6] |= setBit;
+        }
+        else
+        {
+            Words[setIndex >> 6] &= ~setBit;
+        }
+    }
+};
+
+/**
+ * \brief Counts the lines the L2 holds in each region of memory, so the host can see a range isn't cached without a lock.
+ *
+ *   Regions are hashed onto a fixed number of counters, a collision only
+ * makes a range look cached when it isn't. The L2 is inclusive, so a
+ * region without L2 lines has none in the L0s either. Only the thread
+ * driving the caches writes the counters, any thread may read them.
+ */
+struct ResidencyFilter final
+{
+    DEFAULT_CONSTRUCT_PU(ResidencyFilter);
+    DEFAULT_DESTRUCT(ResidencyFilter);
+    DELETE_CM(ResidencyFilter);
+public:
+    // 4 KiB regions.
+    static inline constexpr u64 REGION_WORD_BITS = 10;
+    static inline constexpr uSys COUNTER_COUNT = 4096;
+
+    ::std::atomic<u32> Counters[COUNTER_COUNT];
+
+    void Reset() noexcept
+    {
+        for(uSys i = 0; i < COUNTER_COUNT; ++i)
+        {
+            Counters[i].store(0, ::std::memory_order_relaxed);
         }
     }
+
+    // Called before the line is filled, so the fill can't read memory ahead of the count a racing host write checks.
+    void Add(const u64 address) noexcept
+    {
+        (void) Counters[CounterIndex(address)].fetch_add(1, ::std::memory_order_seq_cst);
+    }
+
+    // Called once the line is no longer cached anywhere and any dirty data has reached memory.
+    void Remove(const u64 address) noexcept
+    {
+        (void) Counters[CounterIndex(address)].fetch_sub(1, ::std::memory_order_release);
+    }
+
+    [[nodiscard]] bool MayHold(const u64 address, const u64 wordCount) const noexcept
+    {
+        if(wordCount == 0)
+        {
+            return false;
+        }
+
+        // Orders the check after the caller's own accesses to the range.
+        ::std::atomic_thread_fence(::std::memory_order_seq_cst);
+
+        const u64 firstRegion = address >> REGION_WORD_BITS;
+        const u64 endRegion = ((address + wordCount - 1) >> REGION_WORD_BITS) + 1;
+        const u64 regionCount = endRegion - firstRegion < COUNTER_COUNT ? endRegion - firstRegion : COUNTER_COUNT;
+
+        for(u64 i = 0; i < regionCount; ++i)
+        {
+            if(Counters[(firstRegion + i) % COUNTER_COUNT].load(::std::memory_order_seq_cst) != 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+private:
+    [[nodiscard]] static uSys CounterIndex(const u64 address) noexcept { return (address >> REGION_WORD_BITS) % COUNTER_COUNT; }
+};
+
+struct CacheStatistics final
+{
+    u64 ReadHits;
+    u64 ReadMisses;
+    // Lines written back into the cache from the level above.
+    u64 WriteHits;
+    u64 WriteMisses;
+    u64 Evictions;
+    // Dirty lines written to memory.
+    u64 MemoryWrites;
 };
 
 class CacheController;
 
-template<uSys IndexBits, uSys SetLineCount>
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
 class Cache final
 {
     DEFAULT_DESTRUCT(Cache);
     DELETE_CM(Cache);
+public:
+    using Set = CacheSet<SetLineCount>;
+    using Policy = ReplacementPolicy<Replacement, SetLineCount>;
 public:
     Cache(CacheController* const memoryManager, const u32 lineIndex) noexcept
         : m_MemoryManager(memoryManager)
         , m_LineIndex(lineIndex)
         , m_Sets{ }
-        , m_RollingSelector(0)
-    { }
+        , m_Data{ }
+        , m_Replacement{ }
+        , m_ReplacementStates{ }
+        , m_PrefetchedMasks{ }
+        , m_KeptMasks{ }
+    {
+        Reset();
+    }
 
     void Reset()
     {
-        m_RollingSelector = 0;
-
         for(uSys i = 0; i < ::std::size(m_Sets); ++i)
         {
             m_Sets[i].Reset();
         }
+
+        (void) ::std::memset(m_PrefetchedMasks, 0, sizeof(m_PrefetchedMasks));
+        (void) ::std::memset(m_KeptMasks, 0, sizeof(m_KeptMasks));
+        m_DirtySets.Reset();
+        ResetReplacement();
     }
 
-    [[nodiscard]] u32 Read(u64 address, bool external) noexcept;
-    void Write(u64 address, u32 value, bool external, bool writeThrough) noexcept;
+    [[nodiscard]] u32 Read(u64 address, bool external, ECacheLevel* servedBy = nullptr, ECacheHint hint = ECacheHint::Normal) noexcept;
+    void Write(u64 address, u32 value, bool external, bool writeThrough, ECacheHint hint = ECacheHint::Normal) noexcept;
+    // Fills a line ahead of demand, returns false if it was already present.
+    bool PrefetchLine(u64 address, bool external, ECacheLevel* servedBy = nullptr, ECacheHint hint = ECacheHint::Normal) noexcept;
+
+    // Whether a valid copy of the line is present, without touching the replacement state.
+    [[nodiscard]] bool Contains(const u64 address, const bool external) const noexcept
+    {
+        const u64 setIndex = GetSetIndex(address);
+        const uSys way = GetCacheLine(setIndex, address, external);
+
+        return way != Set::NO_WAY && m_Sets[setIndex].States[way] != MESI::Invalid;
+    }
     // void FillCacheLine(u64 address, const u32* data) noexcept;
     void Flush() noexcept;
+    // Writes back the dirty lines in the range, invalidate also drops every line in it.
+    void FlushRange(u64 address, u64 wordCount, bool external, bool invalidate) noexcept;
 
     bool SnoopBusRead(u32 requestorLine, u64 address, bool external, u32* dataBus) noexcept;
     bool SnoopBusReadX(u32 requestorLine, u64 address, bool external, u32* dataBus) noexcept;
     void SnoopBusUpgrade(u32 requestorLine, u64 address, bool external) noexcept;
+    // Copies the line out if this cache holds it dirty, leaving its state alone. Used for host reads.
+    bool SnoopBusPeek(u64 address, bool external, u32* dataBus) const noexcept;
 private:
-    [[nodiscard]] CacheLine<IndexBits>* GetCacheLine(const u64 address, const bool external) noexcept
+    [[nodiscard]] static u64 GetSetIndex(const u64 address) noexcept { return (address >> 3) & ((1ull << IndexBits) - 1); }
+    [[nodiscard]] static u64 GetKey(const u64 address, const bool external) noexcept { return Set::MakeKey(address >> (IndexBits + 3), external); }
+    [[nodiscard]] static u64 GetLineAddress(const u64 setIndex, const u64 key) noexcept { return (Set::KeyTag(key) << (IndexBits + 3)) | (setIndex << 3); }
+
+    // Invalid lines still match, an invalidated line keeps its tag until it is reallocated.
+    [[nodiscard]] uSys GetCacheLine(const u64 setIndex, const u64 address, const bool external) const noexcept
     {
-        const u64 setIndex = (address >> 3) & ((1 << IndexBits) - 1);
-        const u64 tag = address >> (IndexBits + 3);
+        return m_Sets[setIndex].FindWay(GetKey(address, external));
+    }
 
-        CacheSet<IndexBits, SetLineCount>& targetSet = m_Sets[setIndex];
+    [[nodiscard]] uSys GetFreeCacheLine(u64 setIndex, u64 address, bool external) noexcept;
 
-        for(uSys i = 0; i < SetLineCount; ++i)
+    // A non-temporal miss, the line is moved over the bus without being allocated.
+    [[nodiscard]] u32 ReadAround(u64 address, u64 lineOffset, bool external, ECacheLevel* servedBy) noexcept;
+    void WriteAround(u64 address, u64 lineOffset, u32 value, bool external, bool writeThrough) noexcept;
+
+    // Every state change goes through here to keep the dirty masks current.
+    void SetLineState(const u64 setIndex, const uSys way, const MESI state) noexcept
+    {
+        m_DirtySets.Update(setIndex, m_Sets[setIndex].SetState(way, state));
+    }
+
+    void FlushLine(u64 setIndex, uSys way, bool invalidate) noexcept;
+
+    // Clears the way's prefetched bit, returning whether it was set.
+    [[nodiscard]] bool TakePrefetched(const u64 setIndex, const uSys way) noexcept
+    {
+        const u32 wayBit = 1u << way;
+
+        if((m_PrefetchedMasks[setIndex] & wayBit) == 0)
+        {
+            return false;
+        }
+
+        m_PrefetchedMasks[setIndex] &= ~wayBit;
+        return true;
+    }
+
+    // Tells the replacement policy about a demand access, fill is set if the line was just allocated.
+    void UpdateReplacement(const u64 setIndex, const uSys way, const bool fill, const ECacheHint hint = ECacheHint::Normal) noexcept
+    {
+        if(hint == ECacheHint::Keep)
         {
-            if(targetSet.SetLines[i].Tag == tag && targetSet.SetLines[i].External == external)
+            m_KeptMasks[setIndex] |= 1u << way;
+        }
+        else if(hint == ECacheHint::Streaming || hint == ECacheHint::NonTemporal)
+        {
+            if(fill)
             {
-                return &targetSet.SetLines[i];
+                m_Replacement.OnDemote(m_ReplacementStates[setIndex], way);
             }
+
+            return;
         }
 
-        return nullptr;
+        if(fill)
+        {
+            m_Replacement.OnFill(m_ReplacementStates[setIndex], way);
+        }
+        else
+        {
+            m_Replacement.OnHit(m_ReplacementStates[setIndex], way);
+        }
     }
 
-    [[nodiscard]] CacheLine<IndexBits>* GetFreeCacheLine(u64 address, bool external) noexcept;
+    void ResetReplacement() noexcept
+    {
+        m_Replacement.Reset();
+
+        for(uSys i = 0; i < ::std::size(m_ReplacementStates); ++i)
+        {
+            Policy::ResetSet(m_ReplacementStates[i]);
+        }
+    }
 private:
     CacheController* m_MemoryManager;
     u32 m_LineIndex;
-    CacheSet<IndexBits, SetLineCount> m_Sets[1 << IndexBits];
-    u32 m_RollingSelector;
+    Set m_Sets[1 << IndexBits];
+    alignas(32) u32 m_Data[1 << IndexBits][SetLineCount][CACHE_LINE_WORD_COUNT];
+    Policy m_Replacement;
+    typename Policy::SetState m_ReplacementStates[1 << IndexBits];
+    // A bit per way filled by the prefetcher and not yet hit by demand.
+    u32 m_PrefetchedMasks[1 << IndexBits];
+    // A bit per way last accessed with ECacheHint::Keep, cleared when the way is reallocated.
+    u32 m_KeptMasks[1 << IndexBits];
+    DirtySetMap<1 << IndexBits> m_DirtySets;
+};
+
+/**
+ * \brief The L2 cache shared by every SM, between the L0 caches and memory.
+ *
+ *   Lines are interleaved across (1 << BankBits) banks by line address,
+ * each bank is set associative and keeps its own victim selector and
+ * statistics. The L2 is inclusive of the L0 caches: every L0 fill
+ * allocates in the L2, and before an L2 line is evicted it is pulled
+ * back out of the L0s. L0 writebacks land in the L2, memory is only
+ * written for evicted or flushed dirty lines, and for write-through
+ * stores.
+ *
+ *   Because it is inclusive, the L2 doubles as the snoop filter. Each
+ * line keeps a mask of the L0s that may hold it, so the controller only
+ * probes those. The mask is conservative, an L0 silently dropping a
+ * clean line leaves its bit set until the next exclusive access.
+ *
+ *   Lines are either Exclusive (clean), Modified (dirty) or Invalid.
+ */
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+class SharedCache final
+{
+    DEFAULT_DESTRUCT(SharedCache);
+    DELETE_CM(SharedCache);
+public:
+    static inline constexpr uSys BANK_COUNT = 1ull << BankBits;
+
+    using Set = CacheSet<SetLineCount>;
+    using Policy = ReplacementPolicy<Replacement, SetLineCount>;
+    // One bit per L0 line index.
+    using SharerMask = u32;
+public:
+    SharedCache(CacheController* const memoryManager) noexcept
+        : m_MemoryManager(memoryManager)
+        , m_Banks{ }
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        for(uSys i = 0; i < BANK_COUNT; ++i)
+        {
+            for(uSys j = 0; j < ::std::size(m_Banks[i].Sets); ++j)
+            {
+                m_Banks[i].Sets[j].Reset();
+            }
+
+            (void) ::std::memset(m_Banks[i].Sharers, 0, sizeof(m_Banks[i].Sharers));
+            (void) ::std::memset(m_Banks[i].KeptMasks, 0, sizeof(m_Banks[i].KeptMasks));
+            m_Banks[i].DirtySets.Reset();
+            m_Banks[i].Statistics = { };
+        }
+
+        m_Residency.Reset();
+        ResetReplacement();
+    }
+
+    // The L0s that may hold a line, none if the L2 doesn't have it.
+    [[nodiscard]] SharerMask Sharers(u64 address, bool external) const noexcept;
+    void AddSharer(u64 address, bool external, u32 requestorLine) noexcept;
+    // For when the requestor took the line exclusively, every other copy was invalidated.
+    void SetSoleSharer(u64 address, bool external, u32 requestorLine) noexcept;
+
+    // Reads a line for the requestor, filling it from memory on a miss. Returns whether it hit.
+    bool ReadLine(u64 address, bool external, u32 data[8], u32 requestorLine, ECacheHint hint = ECacheHint::Normal) noexcept;
+    // Takes a line written back from an L0.
+    void WriteLine(u64 address, bool external, const u32 data[8], bool writeThrough) noexcept;
+    void Flush() noexcept;
+    // Writes the dirty lines in the range to memory, invalidate also drops every line in it, pulling them out of the L0s.
+    void FlushRange(u64 address, u64 wordCount, bool external, bool invalidate) noexcept;
+
+    // Copies the newest data of a line for the host without changing any state. Returns false if the line isn't cached, memory is then current.
+    bool HostReadLine(u64 address, bool external, u32 data[8]) noexcept;
+    // Merges a host write into a line once the L0s have let go of it. Returns false if the line isn't cached. Memory is written by the caller either way.
+    bool HostWriteLine(u64 address, bool external, u64 wordOffset, const u32* words, u64 wordCount) noexcept;
+
+    // Safe to call from any thread.
+    [[nodiscard]] bool MayHold(const u64 address, const u64 wordCount) const noexcept { return m_Residency.MayHold(address, wordCount); }
+
+    [[nodiscard]] const CacheStatistics& BankStatistics(const uSys bankIndex) const noexcept { return m_Banks[bankIndex].Statistics; }
+    [[nodiscard]] CacheStatistics Statistics() const noexcept;
+private:
+    // Unlike the L0, an invalid L2 line always has INVALID_KEY, so a key match is a hit.
+    struct Bank final
+    {
+        Set Sets[1ull << IndexBits];
+        alignas(32) u32 Data[1ull << IndexBits][SetLineCount][CACHE_LINE_WORD_COUNT];
+        SharerMask Sharers[1ull << IndexBits][SetLineCount];
+        // A bit per way read with ECacheHint::Keep, cleared when the way is reallocated.
+        u32 KeptMasks[1ull << IndexBits];
+        Policy Replacer;
+        typename Policy::SetState ReplacementStates[1ull << IndexBits];
+        DirtySetMap<1ull << IndexBits> DirtySets;
+        CacheStatistics Statistics;
+    };
+
+    void ResetReplacement() noexcept
+    {
+        for(uSys i = 0; i < BANK_COUNT; ++i)
+        {
+            m_Banks[i].Replacer.Reset();
+
+            for(uSys j = 0; j < ::std::size(m_Banks[i].ReplacementStates); ++j)
+            {
+                Policy::ResetSet(m_Banks[i].ReplacementStates[j]);
+            }
+        }
+    }
+
+    [[nodiscard]] static Bank& GetBank(Bank* const banks, const u64 address) noexcept
+    {
+        return banks[(address >> 3) & (BANK_COUNT - 1)];
+    }
+
+    [[nodiscard]] static const Bank& GetBank(const Bank* const banks, const u64 address) noexcept
+    {
+        return banks[(address >> 3) & (BANK_COUNT - 1)];
+    }
+
+    [[nodiscard]] static u64 GetSetIndex(const u64 address) noexcept { return (address >> (BankBits + 3)) & ((1ull << IndexBits) - 1); }
+    [[nodiscard]] static u64 GetKey(const u64 address, const bool external) noexcept { return Set::MakeKey(address >> (BankBits + IndexBits + 3), external); }
+
+    [[nodiscard]] static u64 GetLineAddress(const uSys bankIndex, const u64 setIndex, const u64 key) noexcept
+    {
+        return (Set::KeyTag(key) << (BankBits + IndexBits + 3)) | (setIndex << (BankBits + 3)) | (bankIndex << 3);
+    }
+
+    static void SetLineState(Bank& bank, const u64 setIndex, const uSys way, const MESI state) noexcept
+    {
+        bank.DirtySets.Update(setIndex, bank.Sets[setIndex].SetState(way, state));
+    }
+
+    [[nodiscard]] static uSys GetCacheLine(const Bank& bank, const u64 setIndex, const u64 address, const bool external) noexcept
+    {
+        return bank.Sets[setIndex].FindWay(GetKey(address, external));
+    }
+
+    static void UpdateReplacement(Bank& bank, const u64 setIndex, const uSys way, const bool fill) noexcept
+    {
+        if(fill)
+        {
+            bank.Replacer.OnFill(bank.ReplacementStates[setIndex], way);
+        }
+        else
+        {
+            bank.Replacer.OnHit(bank.ReplacementStates[setIndex], way);
+        }
+    }
+
+    // Picks a line for address, evicting whatever was there.
+    [[nodiscard]] uSys AllocateCacheLine(Bank& bank, u64 setIndex, u64 address, bool external) noexcept;
+    // Pulls a valid line out of the L0s and writes it to memory if dirty, leaving the way invalid.
+    void EvictCacheLine(Bank& bank, u64 setIndex, uSys way, u64 lineAddress) noexcept;
+    void FlushLine(Bank& bank, uSys bankIndex, u64 setIndex, uSys way, bool invalidate) noexcept;
+private:
+    CacheController* m_MemoryManager;
+    Bank m_Banks[BANK_COUNT];
+    ResidencyFilter m_Residency;
 };
 
 class Processor;
 
 class CacheController final
 {
+public:
+    using L0Cache = Cache<Topology.L0IndexBits, Topology.L0SetLineCount, Topology.L0Replacement, Topology.L0Coherence>;
+    using L2Cache = SharedCache<Topology.L2BankBits, Topology.L2IndexBits, Topology.L2SetLineCount, Topology.L2Replacement>;
+
+    // The line index the L2 uses on the snoop bus.
+    static inline constexpr u32 L2_LINE_INDEX = Topology.SmCount;
+
+    static_assert(Topology.SmCount <= sizeof(L2Cache::SharerMask) * 8, "The L2 sharer mask is too small for the SM count.");
 public:
     CacheController(Processor* const processor) noexcept
+        : CacheController(processor, ::std::make_index_sequence<Topology.SmCount>())
+    { }
+private:
+    // Expands an initializer for the L0 cache of every SM in the topology.
+    template<uSys... LineIndices>
+    CacheController(Processor* const processor, ::std::index_sequence<LineIndices...>) noexcept
         : m_Processor(processor)
-        , m_L0Caches{ { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 } }
-        // , L1Cache(this, 4)
+        , m_L0Caches{ { this, LineIndices }... }
+        , m_L2Cache(this)
+        , m_Prefetchers{ }
     { }
-
+public:
     void Reset()
     {
-        m_L0Caches[0].Reset();
-        m_L0Caches[1].Reset();
-        m_L0Caches[2].Reset();
-        m_L0Caches[3].Reset();
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            m_L0Caches[i].Reset();
+            m_Prefetchers[i].Reset();
+        }
+
+        m_L2Cache.Reset();
     }
 
-    [[nodiscard]] u32 Read(const u32 coreIndex, const u64 address, const bool external) noexcept
+    [[nodiscard]] u32 Read(const u32 coreIndex, const u64 address, const bool external, ECacheLevel* const servedBy = nullptr, const ECacheHint hint = ECacheHint::Normal) noexcept
     {
-        return m_L0Caches[coreIndex].Read(address, external);
+        return m_L0Caches[coreIndex].Read(address, external, servedBy, hint);
     }
 
-    void Write(const u32 coreIndex, const u64 address, const u32 value, const bool external, const bool writeThrough) noexcept
+    void Write(const u32 coreIndex, const u64 address, const u32 value, const bool external, const bool writeThrough, const ECacheHint hint = ECacheHint::Normal) noexcept
     {
-        m_L0Caches[coreIndex].Write(address, value, external, writeThrough);
+        m_L0Caches[coreIndex].Write(address, value, external, writeThrough, hint);
     }
 
-    void Prefetch(const u32 coreIndex, const u64 address, const bool external) noexcept
+    void Prefetch(const u32 coreIndex, const u64 address, const bool external, ECacheLevel* const servedBy = nullptr) noexcept
     {
         // For pre-fetching we'll be acting asynchronously typically, but we're forced to act synchronously in software, so we'll just redirect to read.
-        (void) m_L0Caches[coreIndex].Read(address, external);
+        (void) m_L0Caches[coreIndex].Read(address, external, servedBy);
+    }
+
+    [[nodiscard]] bool Contains(const u32 coreIndex, const u64 address, const bool external) const noexcept
+    {
+        return m_L0Caches[coreIndex].Contains(address, external);
     }
 
+    // Flushes the core's L0 into the L2, then the L2 into memory.
     void Flush(const u32 coreIndex) noexcept
     {
         m_L0Caches[coreIndex].Flush();
+        m_L2Cache.Flush();
     }
 
-    bool ReadCacheLine(const u32 requestorLine, const u64 address, const bool external, u32* const cacheLine) noexcept
+    // Flush, limited to the lines of a range. They stay cached.
+    void FlushRange(const u32 coreIndex, const u64 address, const u64 wordCount, const bool external) noexcept
     {
-        bool didWrite = m_L0Caches[0].SnoopBusRead(requestorLine, address, external, cacheLine);
-        didWrite = m_L0Caches[1].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[2].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[3].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine);
+        m_L0Caches[coreIndex].FlushRange(address, wordCount, external, false);
+        m_L2Cache.FlushRange(address, wordCount, external, false);
+    }
+
+    // Flush of a single line from whichever L0s hold it, then the L2. It stays cached.
+    void FlushSharedLine(const u64 address, const bool external) noexcept
+    {
+        for(u32 sharers = m_L2Cache.Sharers(address, external); sharers != 0; sharers &= sharers - 1)
+        {
+            m_L0Caches[_tzcnt_u32(sharers)].FlushRange(address, CACHE_LINE_WORD_COUNT, external, false);
+        }
+
+        m_L2Cache.FlushRange(address, CACHE_LINE_WORD_COUNT, external, false);
+    }
+
+    // Flushes the range and drops it from the core's L0 and the L2, the L2 also pulls it out of the other L0s.
+    void InvalidateRange(const u32 coreIndex, const u64 address, const u64 wordCount, const bool external) noexcept
+    {
+        m_L0Caches[coreIndex].FlushRange(address, wordCount, external, true);
+        m_L2Cache.FlushRange(address, wordCount, external, true);
+    }
+
+    [[nodiscard]] const L2Cache& GetL2Cache() const noexcept { return m_L2Cache; }
+    [[nodiscard]] const StridePrefetcher& GetPrefetcher(const u32 coreIndex) const noexcept { return m_Prefetchers[coreIndex]; }
+
+    bool ReadCacheLine(const u32 requestorLine, const u64 address, const bool external, u32* const cacheLine, ECacheLevel* const servedBy = nullptr, const ECacheHint hint = ECacheHint::Normal) noexcept
+    {
+        bool didWrite = false;
+        for(u32 sharers = m_L2Cache.Sharers(address, external) & ~(1u << requestorLine); sharers != 0; sharers &= sharers - 1)
+        {
+            didWrite |= m_L0Caches[_tzcnt_u32(sharers)].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine);
+        }
 
         if(!didWrite)
         {
-            // The memory granularity is 32 bits, thus we'll adjust to an 8 bit granularity for x86.
-            ReadCacheLine(address, cacheLine, external);
+            const bool l2Hit = m_L2Cache.ReadLine(address, external, cacheLine, requestorLine, hint);
+
+            if(servedBy)
+            {
+                *servedBy = l2Hit ? ECacheLevel::L2 : ECacheLevel::Memory;
+            }
             return false;
         }
 
+        m_L2Cache.AddSharer(address, external, requestorLine);
+
+        if(servedBy)
+        {
+            *servedBy = ECacheLevel::L2;
+        }
         return true;
     }
 
-    bool ReadXCacheLine(const u32 requestorLine, const u64 address, const bool external, u32* const cacheLine) noexcept
+    bool ReadXCacheLine(const u32 requestorLine, const u64 address, const bool external, u32* const cacheLine, const ECacheHint hint = ECacheHint::Normal) noexcept
     {
-        bool didWrite = m_L0Caches[0].SnoopBusReadX(requestorLine, address, external, cacheLine);
-        didWrite = m_L0Caches[1].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[2].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[3].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine);
+        bool didWrite = false;
+        for(u32 sharers = m_L2Cache.Sharers(address, external) & ~(1u << requestorLine); sharers != 0; sharers &= sharers - 1)
+        {
+            didWrite |= m_L0Caches[_tzcnt_u32(sharers)].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine);
+        }
 
         if(!didWrite)
         {
-            // The memory granularity is 32 bits, thus we'll adjust to an 8 bit granularity for x86.
-            ReadCacheLine(address, cacheLine, external);
-            return false;
+            (void) m_L2Cache.ReadLine(address, external, cacheLine, requestorLine, hint);
         }
 
-        return true;
+        m_L2Cache.SetSoleSharer(address, external, requestorLine);
+        return didWrite;
     }
 
     void UpgradeCacheLine(const u32 requestorLine, const u64 address, const bool external) noexcept
     {
-        m_L0Caches[0].SnoopBusUpgrade(requestorLine, address, external);
-        m_L0Caches[1].SnoopBusUpgrade(requestorLine, address, external);
-        m_L0Caches[2].SnoopBusUpgrade(requestorLine, address, external);
-        m_L0Caches[3].SnoopBusUpgrade(requestorLine, address, external);
+        for(u32 sharers = m_L2Cache.Sharers(address, external) & ~(1u << requestorLine); sharers != 0; sharers &= sharers - 1)
+        {
+            m_L0Caches[_tzcnt_u32(sharers)].SnoopBusUpgrade(requestorLine, address, external);
+        }
+
+        m_L2Cache.SetSoleSharer(address, external, requestorLine);
+    }
+
+    void WriteBackCacheLine(const u32 requestorLine, const u64 address, const bool external, const u32* cacheLine, const bool writeThrough = false) noexcept
+    {
+        (void) requestorLine;
+        m_L2Cache.WriteLine(address, external, cacheLine, writeThrough);
     }
 
-    void WriteBackCacheLine(const u32 requestorLine, const u64 address, const bool external, const u32* cacheLine) noexcept
+    // Called by the L2 before it evicts a line, keeps the L0s inclusive. Dirty L0 copies are written back into the L2 line.
+    void BackInvalidateCacheLine(const u64 address, const bool external, const u32 sharers) noexcept
     {
-        // if(requestorLine == 4)
+        for(u32 remaining = sharers; remaining != 0; remaining &= remaining - 1)
         {
-            // The memory granularity is 32 bits, thus we'll adjust to an 8 bit granularity for x86.
-            WriteCacheLine(address, cacheLine, external);
+            (void) m_L0Caches[_tzcnt_u32(remaining)].SnoopBusReadX(L2_LINE_INDEX, address, external, nullptr);
         }
     }
-private:
-    void ReadCacheLine(u64 address, u32 data[8], bool external) noexcept;
-    void WriteCacheLine(u64 address, const u32 data[8], bool external) noexcept;
+
+    // For host reads, copies the dirty L0 copy of a line if one of the sharers has it.
+    bool PeekCacheLine(const u64 address, const bool external, const u32 sharers, u32* const cacheLine) noexcept
+    {
+        // Only one L0 can hold a line dirty.
+        for(u32 remaining = sharers; remaining != 0; remaining &= remaining - 1)
+        {
+            if(m_L0Caches[_tzcnt_u32(remaining)].SnoopBusPeek(address, external, cacheLine))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * \brief The host's coherence port, for BAR1 accesses.
+     *
+     *   Only the lines a cache holds are snooped. Reads take the newest
+     * copy without disturbing any cache, writes pull the line out of the
+     * L0s and update the L2's copy as well as memory. Ranges no cache
+     * holds are copied straight to or from memory. These must be called
+     * from the thread driving the caches.
+     */
+    void HostRead(u64 address, u32* data, u64 wordCount, bool external) noexcept;
+    void HostWrite(u64 address, const u32* data, u64 wordCount, bool external) noexcept;
+
+    // Safe to call from any thread, false means no cache holds a line of the range.
+    [[nodiscard]] bool HostRangeMayBeCached(const u64 address, const u64 wordCount) const noexcept
+    {
+        return m_L2Cache.MayHold(address, wordCount);
+    }
+
+    // Called by an L0 after a demand miss, or the first demand hit on a line its prefetcher filled.
+    void TrainPrefetcher(u32 requestorLine, u64 address, bool external, bool prefetchHit, ECacheHint hint = ECacheHint::Normal) noexcept;
+
+    // The memory side of the L2.
+    void ReadMemoryLine(u64 address, u32 data[8], bool external) noexcept;
+    void WriteMemoryLine(u64 address, const u32 data[8], bool external) noexcept;
 private:
     Processor* m_Processor;
-    Cache<8, 4> m_L0Caches[4];
-    // Cache<10, 8> L1Cache;
+    L0Cache m_L0Caches[Topology.SmCount];
+    L2Cache m_L2Cache;
+    StridePrefetcher m_Prefetchers[Topology.SmCount];
 };
 
 #include "Cache.inl"
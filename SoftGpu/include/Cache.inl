@@ -4,229 +4,775 @@
 
 #include <cstring>
 
-template<uSys IndexBits, uSys SetLineCount>
-u32 Cache<IndexBits, SetLineCount>::Read(u64 address, const bool external) noexcept
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+u32 Cache<IndexBits, SetLineCount, Replacement, Coherence>::Read(u64 address, const bool external, ECacheLevel* const servedBy, const ECacheHint hint) noexcept
 {
     const u64 lineOffset = address & 0x7;
     address >>= 3;
     address <<= 3;
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    const u64 setIndex = GetSetIndex(address);
+    Set& cacheSet = m_Sets[setIndex];
+    uSys way = GetCacheLine(setIndex, address, external);
+    bool missed = false;
     
-    if(!cacheLine || cacheLine->Mesi == MESI::Invalid)
+    if(way == Set::NO_WAY || cacheSet.States[way] == MESI::Invalid)
     {
-        if(!cacheLine)
+        if(hint == ECacheHint::NonTemporal)
         {
-            cacheLine = GetFreeCacheLine(address, external);
+            return ReadAround(address, lineOffset, external, servedBy);
         }
 
-        if(m_MemoryManager->ReadCacheLine(m_LineIndex, address, external, cacheLine->Data))
+        if(way == Set::NO_WAY)
         {
-            cacheLine->Mesi = MESI::Shared;
+            way = GetFreeCacheLine(setIndex, address, external);
+        }
+
+        if(m_MemoryManager->ReadCacheLine(m_LineIndex, address, external, m_Data[setIndex][way], servedBy, hint))
+        {
+            SetLineState(setIndex, way, MESI::Shared);
         }
         else
         {
-            cacheLine->Mesi = MESI::Exclusive;
+            SetLineState(setIndex, way, MESI::Exclusive);
+        }
+
+        (void) TakePrefetched(setIndex, way);
+        UpdateReplacement(setIndex, way, true, hint);
+        missed = true;
+    }
+    else
+    {
+        UpdateReplacement(setIndex, way, false, hint);
+
+        if(servedBy)
+        {
+            *servedBy = ECacheLevel::L0;
         }
     }
 
-    return cacheLine->Data[lineOffset];
+    const bool prefetchHit = !missed && TakePrefetched(setIndex, way);
+    const u32 value = m_Data[setIndex][way][lineOffset];
+
+    // Only once the value is out, the prefetches can replace the line.
+    if(missed || prefetchHit)
+    {
+        m_MemoryManager->TrainPrefetcher(m_LineIndex, address, external, prefetchHit, hint);
+    }
+
+    return value;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-void Cache<IndexBits, SetLineCount>::Write(u64 address, const u32 value, const bool external, const bool writeThrough) noexcept
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+void Cache<IndexBits, SetLineCount, Replacement, Coherence>::Write(u64 address, const u32 value, const bool external, const bool writeThrough, const ECacheHint hint) noexcept
 {
     const u64 lineOffset = address & 0x7;
     address >>= 3;
     address <<= 3;
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    const u64 setIndex = GetSetIndex(address);
+    Set& cacheSet = m_Sets[setIndex];
+    uSys way = GetCacheLine(setIndex, address, external);
+    bool missed = false;
 
-    if(!cacheLine || cacheLine->Mesi == MESI::Invalid)
+    if(way == Set::NO_WAY || cacheSet.States[way] == MESI::Invalid)
     {
-        if(!cacheLine)
+        if(hint == ECacheHint::NonTemporal)
         {
-            cacheLine = GetFreeCacheLine(address, external);
+            WriteAround(address, lineOffset, value, external, writeThrough);
+            return;
         }
 
-        (void) m_MemoryManager->ReadXCacheLine(m_LineIndex, address, external, cacheLine->Data);
-        cacheLine->Mesi = MESI::Modified;
+        if(way == Set::NO_WAY)
+        {
+            way = GetFreeCacheLine(setIndex, address, external);
+        }
+
+        (void) m_MemoryManager->ReadXCacheLine(m_LineIndex, address, external, m_Data[setIndex][way], hint);
+        SetLineState(setIndex, way, MESI::Modified);
+        (void) TakePrefetched(setIndex, way);
+        UpdateReplacement(setIndex, way, true, hint);
+        missed = true;
     }
-    else if(cacheLine->Mesi == MESI::Exclusive || cacheLine->Mesi == MESI::Modified)
+    else if(cacheSet.States[way] == MESI::Exclusive || cacheSet.States[way] == MESI::Modified)
     {
-        cacheLine->Mesi = MESI::Modified;
+        SetLineState(setIndex, way, MESI::Modified);
+        UpdateReplacement(setIndex, way, false, hint);
     }
-    else if(cacheLine->Mesi == MESI::Shared)
+    else if(cacheSet.States[way] == MESI::Shared || cacheSet.States[way] == MESI::Owned)
     {
-        cacheLine->Mesi = MESI::Modified;
+        SetLineState(setIndex, way, MESI::Modified);
         m_MemoryManager->UpgradeCacheLine(m_LineIndex, address, external);
+        UpdateReplacement(setIndex, way, false, hint);
     }
 
-    cacheLine->Data[lineOffset] = value;
+    const bool prefetchHit = !missed && TakePrefetched(setIndex, way);
+
+    m_Data[setIndex][way][lineOffset] = value;
     if(writeThrough)
     {
-        m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
+        m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, m_Data[setIndex][way], true);
+    }
+
+    if(missed || prefetchHit)
+    {
+        m_MemoryManager->TrainPrefetcher(m_LineIndex, address, external, prefetchHit, hint);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+bool Cache<IndexBits, SetLineCount, Replacement, Coherence>::PrefetchLine(u64 address, const bool external, ECacheLevel* const servedBy, const ECacheHint hint) noexcept
+{
+    address >>= 3;
+    address <<= 3;
+    const u64 setIndex = GetSetIndex(address);
+    Set& cacheSet = m_Sets[setIndex];
+    uSys way = GetCacheLine(setIndex, address, external);
+
+    if(way != Set::NO_WAY && cacheSet.States[way] != MESI::Invalid)
+    {
+        return false;
+    }
+
+    if(way == Set::NO_WAY)
+    {
+        way = GetFreeCacheLine(setIndex, address, external);
+    }
+
+    if(m_MemoryManager->ReadCacheLine(m_LineIndex, address, external, m_Data[setIndex][way], servedBy, hint))
+    {
+        SetLineState(setIndex, way, MESI::Shared);
     }
+    else
+    {
+        SetLineState(setIndex, way, MESI::Exclusive);
+    }
+
+    m_PrefetchedMasks[setIndex] |= 1u << way;
+    UpdateReplacement(setIndex, way, true, hint);
+    return true;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-void Cache<IndexBits, SetLineCount>::Flush() noexcept
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+void Cache<IndexBits, SetLineCount, Replacement, Coherence>::Flush() noexcept
 {
-    for(uSys i = 0; i < 1 << IndexBits; ++i)
+    // Only the sets and ways with dirty lines are visited, flushing clears the bits as it goes.
+    for(uSys i = 0; i < ::std::size(m_DirtySets.Words); ++i)
     {
-        CacheSet<IndexBits, SetLineCount>& cacheSet = m_Sets[i];
+        for(u64 dirtySets = m_DirtySets.Words[i]; dirtySets != 0; dirtySets &= dirtySets - 1)
+        {
+            const u64 setIndex = i * 64 + _tzcnt_u64(dirtySets);
+
+            for(u32 dirtyWays = m_Sets[setIndex].DirtyMask; dirtyWays != 0; dirtyWays &= dirtyWays - 1)
+            {
+                FlushLine(setIndex, _tzcnt_u32(dirtyWays), false);
+            }
+        }
+    }
+}
 
-        for(u32 j = 0; j < SetLineCount; ++j)
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+void Cache<IndexBits, SetLineCount, Replacement, Coherence>::FlushRange(const u64 address, const u64 wordCount, const bool external, const bool invalidate) noexcept
+{
+    const u64 firstLine = address >> 3;
+    const u64 endLine = (address + wordCount + CACHE_LINE_WORD_COUNT - 1) >> 3;
+
+    // Probing every line of the range is cheaper until it covers more lines than there are sets.
+    if(endLine - firstLine <= (1ull << IndexBits))
+    {
+        for(u64 line = firstLine; line < endLine; ++line)
         {
-            CacheLine<IndexBits>& cacheLine = cacheSet.SetLines[j];
+            const u64 lineAddress = line << 3;
+            const u64 setIndex = GetSetIndex(lineAddress);
+            const uSys way = GetCacheLine(setIndex, lineAddress, external);
 
-            if(cacheLine.Mesi == MESI::Modified)
+            if(way != Set::NO_WAY)
             {
-                const u64 address = (cacheLine.Tag << (IndexBits + 3)) | (i << 3);
+                FlushLine(setIndex, way, invalidate);
+            }
+        }
 
-                m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, cacheLine.External, cacheLine.Data);
-                cacheLine.Mesi = MESI::Exclusive;
+        return;
+    }
+
+    for(u64 setIndex = 0; setIndex < (1ull << IndexBits); ++setIndex)
+    {
+        const Set& cacheSet = m_Sets[setIndex];
+
+        // A flush only has to look at the dirty ways.
+        for(u32 ways = invalidate ? static_cast<u32>((1ull << SetLineCount) - 1) : cacheSet.DirtyMask; ways != 0; ways &= ways - 1)
+        {
+            const uSys way = _tzcnt_u32(ways);
+            const u64 key = cacheSet.Keys[way];
+            const u64 line = GetLineAddress(setIndex, key) >> 3;
+
+            if(cacheSet.States[way] != MESI::Invalid && Set::KeyExternal(key) == external && line >= firstLine && line < endLine)
+            {
+                FlushLine(setIndex, way, invalidate);
             }
         }
     }
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-CacheLine<IndexBits>* Cache<IndexBits, SetLineCount>::GetFreeCacheLine(const u64 address, const bool external) noexcept
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+void Cache<IndexBits, SetLineCount, Replacement, Coherence>::FlushLine(const u64 setIndex, const uSys way, const bool invalidate) noexcept
 {
-    const u64 setIndex = (address >> 3) & ((1 << IndexBits) - 1);
-    const u64 tag = address >> (IndexBits + 3);
+    const MESI state = m_Sets[setIndex].States[way];
+
+    if(state == MESI::Invalid)
+    {
+        return;
+    }
+
+    if(IsDirty(state))
+    {
+        const u64 key = m_Sets[setIndex].Keys[way];
+        m_MemoryManager->WriteBackCacheLine(m_LineIndex, GetLineAddress(setIndex, key), Set::KeyExternal(key), m_Data[setIndex][way]);
+    }
+
+    if(invalidate)
+    {
+        SetLineState(setIndex, way, MESI::Invalid);
+    }
+    else if(state == MESI::Owned)
+    {
+        // Other L0s may still share an Owned line.
+        SetLineState(setIndex, way, MESI::Shared);
+    }
+    else if(state == MESI::Modified)
+    {
+        SetLineState(setIndex, way, MESI::Exclusive);
+    }
+}
 
-    CacheSet<IndexBits, SetLineCount>& targetSet = m_Sets[setIndex];
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+uSys Cache<IndexBits, SetLineCount, Replacement, Coherence>::GetFreeCacheLine(const u64 setIndex, const u64 address, const bool external) noexcept
+{
+    Set& targetSet = m_Sets[setIndex];
 
     for(uSys i = 0; i < SetLineCount; ++i)
     {
-        if(targetSet.SetLines[i].Mesi == MESI::Invalid)
+        if(targetSet.States[i] == MESI::Invalid)
         {
-            targetSet.SetLines[i].Tag = tag;
-            targetSet.SetLines[i].External = external;
-            return &targetSet.SetLines[i];
+            targetSet.Keys[i] = GetKey(address, external);
+            m_KeptMasks[setIndex] &= ~(1u << i);
+            return i;
         }
     }
 
-    for(uSys i = 0; i < SetLineCount; ++i)
+    if constexpr(Replacement == EReplacementPolicy::RoundRobin)
     {
-        if(targetSet.SetLines[i].Mesi == MESI::Exclusive || targetSet.SetLines[i].Mesi == MESI::Shared)
+        // The original policy takes any clean line before it has to write one back.
+        for(uSys i = 0; i < SetLineCount; ++i)
         {
-            targetSet.SetLines[i].Tag = tag;
-            targetSet.SetLines[i].External = external;
-            return &targetSet.SetLines[i];
+            if((targetSet.States[i] == MESI::Exclusive || targetSet.States[i] == MESI::Shared) && (m_KeptMasks[setIndex] & (1u << i)) == 0)
+            {
+                SetLineState(setIndex, i, MESI::Invalid);
+                targetSet.Keys[i] = GetKey(address, external);
+                return i;
+            }
         }
     }
 
-    // This will be implemented as an n-bit rolling integer.
-    const u64 rollingSelector = (m_RollingSelector++) % SetLineCount;
+    const uSys way = SelectUnkeptVictim<SetLineCount>(m_Replacement, m_ReplacementStates[setIndex], m_KeptMasks[setIndex]);
+
+    if(IsDirty(targetSet.States[way]))
+    {
+        // Write back the victim to its own address.
+        const u64 victimKey = targetSet.Keys[way];
+        m_MemoryManager->WriteBackCacheLine(m_LineIndex, GetLineAddress(setIndex, victimKey), Set::KeyExternal(victimKey), m_Data[setIndex][way]);
+    }
+
+    SetLineState(setIndex, way, MESI::Invalid);
+    targetSet.Keys[way] = GetKey(address, external);
+    m_KeptMasks[setIndex] &= ~(1u << way);
 
-    CacheLine<IndexBits>* const cacheLine = &targetSet.SetLines[rollingSelector];
+    return way;
+}
 
-    m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
-    cacheLine->Tag = tag;
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+u32 Cache<IndexBits, SetLineCount, Replacement, Coherence>::ReadAround(const u64 address, const u64 lineOffset, const bool external, ECacheLevel* const servedBy) noexcept
+{
+    // The usual bus read, so a dirty copy in another L0 is still seen. The L2 just records a sharer that will never answer a snoop.
+    u32 lineData[CACHE_LINE_WORD_COUNT];
+    (void) m_MemoryManager->ReadCacheLine(m_LineIndex, address, external, lineData, servedBy, ECacheHint::NonTemporal);
+
+    return lineData[lineOffset];
+}
+
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+void Cache<IndexBits, SetLineCount, Replacement, Coherence>::WriteAround(const u64 address, const u64 lineOffset, const u32 value, const bool external, const bool writeThrough) noexcept
+{
+    // Take the line exclusively to invalidate every other copy, then merge the store into the L2's.
+    u32 lineData[CACHE_LINE_WORD_COUNT];
+    (void) m_MemoryManager->ReadXCacheLine(m_LineIndex, address, external, lineData, ECacheHint::NonTemporal);
 
-    return cacheLine;
+    lineData[lineOffset] = value;
+    m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, lineData, writeThrough);
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-bool Cache<IndexBits, SetLineCount>::SnoopBusRead(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+bool Cache<IndexBits, SetLineCount, Replacement, Coherence>::SnoopBusRead(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
 {
     if(requestorLine == m_LineIndex)
     {
         return false;
     }
 
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(setIndex, address, external);
 
-    if(!cacheLine || cacheLine->Mesi == MESI::Invalid)
+    if(way == Set::NO_WAY || m_Sets[setIndex].States[way] == MESI::Invalid)
     {
         return false;
     }
 
-    if(cacheLine->Mesi == MESI::Exclusive)
+    const MESI state = m_Sets[setIndex].States[way];
+    const u32* const lineData = m_Data[setIndex][way];
+
+    if(dataBus)
     {
-        cacheLine->Mesi = MESI::Shared;
-        if(dataBus)
+        (void) ::std::memcpy(dataBus, lineData, sizeof(m_Data[setIndex][way]));
+    }
+
+    if(IsDirty(state))
+    {
+        if constexpr(Coherence == ECoherenceProtocol::Moesi)
         {
-            (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
+            // The requestor gets a clean copy, this cache keeps the dirty data until it is evicted.
+            SetLineState(setIndex, way, MESI::Owned);
+            return true;
         }
+        else
+        {
+            m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, lineData);
+        }
+    }
+
+    // Exclusive, Shared and Modified all end up Shared.
+    SetLineState(setIndex, way, MESI::Shared);
+
+    return true;
+}
+
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+bool Cache<IndexBits, SetLineCount, Replacement, Coherence>::SnoopBusReadX(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
+{
+    if(requestorLine == m_LineIndex)
+    {
+        return false;
+    }
+
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(setIndex, address, external);
+
+    if(way == Set::NO_WAY || m_Sets[setIndex].States[way] == MESI::Invalid)
+    {
+        return false;
+    }
+
+    const MESI state = m_Sets[setIndex].States[way];
+    const u32* const lineData = m_Data[setIndex][way];
+
+    if(dataBus)
+    {
+        (void) ::std::memcpy(dataBus, lineData, sizeof(m_Data[setIndex][way]));
+    }
+
+    // Under MOESI an L0 requestor takes over the dirty data, only the L2 pulling the line back needs it written.
+    if(IsDirty(state) && (Coherence == ECoherenceProtocol::Mesi || requestorLine == CacheController::L2_LINE_INDEX))
+    {
+        m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, lineData);
+    }
+
+    SetLineState(setIndex, way, MESI::Invalid);
+
+    return true;
+}
+
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+void Cache<IndexBits, SetLineCount, Replacement, Coherence>::SnoopBusUpgrade(const u32 requestorLine, const u64 address, const bool external) noexcept
+{
+    if(requestorLine == m_LineIndex)
+    {
+        return;
+    }
+
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(setIndex, address, external);
+
+    // The requestor already holds the same data as an owner, so the dirty copy can just be dropped.
+    if(way != Set::NO_WAY && (m_Sets[setIndex].States[way] == MESI::Shared || m_Sets[setIndex].States[way] == MESI::Owned))
+    {
+        SetLineState(setIndex, way, MESI::Invalid);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement, ECoherenceProtocol Coherence>
+bool Cache<IndexBits, SetLineCount, Replacement, Coherence>::SnoopBusPeek(const u64 address, const bool external, u32* const dataBus) const noexcept
+{
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(setIndex, address, external);
+
+    if(way == Set::NO_WAY || !IsDirty(m_Sets[setIndex].States[way]))
+    {
+        return false;
+    }
+
+    (void) ::std::memcpy(dataBus, m_Data[setIndex][way], sizeof(m_Data[setIndex][way]));
+
+    return true;
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+typename SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::SharerMask SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::Sharers(u64 address, const bool external) const noexcept
+{
+    address >>= 3;
+    address <<= 3;
+
+    const Bank& bank = GetBank(m_Banks, address);
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(bank, setIndex, address, external);
+
+    if(way == Set::NO_WAY)
+    {
+        return 0;
     }
-    else if(cacheLine->Mesi == MESI::Shared)
+
+    return bank.Sharers[setIndex][way];
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+void SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::AddSharer(u64 address, const bool external, const u32 requestorLine) noexcept
+{
+    address >>= 3;
+    address <<= 3;
+
+    Bank& bank = GetBank(m_Banks, address);
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(bank, setIndex, address, external);
+
+    if(way != Set::NO_WAY)
+    {
+        bank.Sharers[setIndex][way] |= 1u << requestorLine;
+    }
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+void SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::SetSoleSharer(u64 address, const bool external, const u32 requestorLine) noexcept
+{
+    address >>= 3;
+    address <<= 3;
+
+    Bank& bank = GetBank(m_Banks, address);
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(bank, setIndex, address, external);
+
+    if(way != Set::NO_WAY)
+    {
+        bank.Sharers[setIndex][way] = 1u << requestorLine;
+    }
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+bool SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::ReadLine(u64 address, const bool external, u32 data[8], const u32 requestorLine, const ECacheHint hint) noexcept
+{
+    address >>= 3;
+    address <<= 3;
+
+    Bank& bank = GetBank(m_Banks, address);
+    const u64 setIndex = GetSetIndex(address);
+    uSys way = GetCacheLine(bank, setIndex, address, external);
+    const bool hit = way != Set::NO_WAY;
+    // One touch data goes in as the next victim and isn't promoted, so it doesn't push lines the L0s still use out of the L2, and with it the L0s.
+    const bool evictFirst = hint == ECacheHint::Streaming || hint == ECacheHint::NonTemporal;
+
+    if(hit)
     {
-        if(dataBus)
+        ++bank.Statistics.ReadHits;
+
+        if(!evictFirst)
         {
-            (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
+            UpdateReplacement(bank, setIndex, way, false);
         }
     }
-    else if(cacheLine->Mesi == MESI::Modified)
+    else
     {
-        cacheLine->Mesi = MESI::Shared;
-        if(dataBus)
+        ++bank.Statistics.ReadMisses;
+
+        way = AllocateCacheLine(bank, setIndex, address, external);
+        m_MemoryManager->ReadMemoryLine(address, bank.Data[setIndex][way], external);
+        SetLineState(bank, setIndex, way, MESI::Exclusive);
+
+        if(evictFirst)
         {
-            (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
+            bank.Replacer.OnDemote(bank.ReplacementStates[setIndex], way);
+        }
+        else
+        {
+            UpdateReplacement(bank, setIndex, way, true);
         }
-        m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
     }
 
-    return true;
+    bank.Sharers[setIndex][way] |= 1u << requestorLine;
+
+    if(hint == ECacheHint::Keep)
+    {
+        bank.KeptMasks[setIndex] |= 1u << way;
+    }
+
+    (void) ::std::memcpy(data, bank.Data[setIndex][way], sizeof(bank.Data[setIndex][way]));
+
+    return hit;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-bool Cache<IndexBits, SetLineCount>::SnoopBusReadX(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+void SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::WriteLine(u64 address, const bool external, const u32 data[8], const bool writeThrough) noexcept
 {
-    if(requestorLine == m_LineIndex)
+    address >>= 3;
+    address <<= 3;
+
+    Bank& bank = GetBank(m_Banks, address);
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(bank, setIndex, address, external);
+
+    // Every L0 line is in the L2, but don't lose the data if that ever isn't the case.
+    if(way == Set::NO_WAY)
+    {
+        ++bank.Statistics.WriteMisses;
+        ++bank.Statistics.MemoryWrites;
+        m_MemoryManager->WriteMemoryLine(address, data, external);
+        return;
+    }
+
+    ++bank.Statistics.WriteHits;
+
+    (void) ::std::memcpy(bank.Data[setIndex][way], data, sizeof(bank.Data[setIndex][way]));
+
+    if(writeThrough)
+    {
+        ++bank.Statistics.MemoryWrites;
+        m_MemoryManager->WriteMemoryLine(address, data, external);
+        SetLineState(bank, setIndex, way, MESI::Exclusive);
+    }
+    else
+    {
+        SetLineState(bank, setIndex, way, MESI::Modified);
+    }
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+bool SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::HostReadLine(const u64 address, const bool external, u32 data[8]) noexcept
+{
+    Bank& bank = GetBank(m_Banks, address);
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(bank, setIndex, address, external);
+
+    if(way == Set::NO_WAY)
     {
         return false;
     }
 
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    // A dirty L0 copy is newer than the L2's.
+    if(!m_MemoryManager->PeekCacheLine(address, external, bank.Sharers[setIndex][way], data))
+    {
+        (void) ::std::memcpy(data, bank.Data[setIndex][way], sizeof(bank.Data[setIndex][way]));
+    }
+
+    return true;
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+bool SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::HostWriteLine(const u64 address, const bool external, const u64 wordOffset, const u32* const words, const u64 wordCount) noexcept
+{
+    Bank& bank = GetBank(m_Banks, address);
+    const u64 setIndex = GetSetIndex(address);
+    const uSys way = GetCacheLine(bank, setIndex, address, external);
 
-    if(!cacheLine || cacheLine->Mesi == MESI::Invalid)
+    if(way == Set::NO_WAY)
     {
         return false;
     }
 
-    if(cacheLine->Mesi == MESI::Exclusive)
+    // Dirty L0 copies are written back into the line, the host's words then go over them.
+    SharerMask& sharers = bank.Sharers[setIndex][way];
+
+    if(sharers != 0)
+    {
+        m_MemoryManager->BackInvalidateCacheLine(address, external, sharers);
+        sharers = 0;
+    }
+
+    (void) ::std::memcpy(bank.Data[setIndex][way] + wordOffset, words, wordCount * sizeof(u32));
+
+    return true;
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+void SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::Flush() noexcept
+{
+    for(uSys bankIndex = 0; bankIndex < BANK_COUNT; ++bankIndex)
     {
-        cacheLine->Mesi = MESI::Invalid;
-        if(dataBus)
+        Bank& bank = m_Banks[bankIndex];
+
+        for(uSys i = 0; i < ::std::size(bank.DirtySets.Words); ++i)
         {
-            (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
+            for(u64 dirtySets = bank.DirtySets.Words[i]; dirtySets != 0; dirtySets &= dirtySets - 1)
+            {
+                const u64 setIndex = i * 64 + _tzcnt_u64(dirtySets);
+
+                for(u32 dirtyWays = bank.Sets[setIndex].DirtyMask; dirtyWays != 0; dirtyWays &= dirtyWays - 1)
+                {
+                    FlushLine(bank, bankIndex, setIndex, _tzcnt_u32(dirtyWays), false);
+                }
+            }
         }
     }
-    else if(cacheLine->Mesi == MESI::Shared)
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+void SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::FlushRange(const u64 address, const u64 wordCount, const bool external, const bool invalidate) noexcept
+{
+    const u64 firstLine = address >> 3;
+    const u64 endLine = (address + wordCount + CACHE_LINE_WORD_COUNT - 1) >> 3;
+
+    // Probing every line of the range is cheaper until it covers more lines than there are sets.
+    if(endLine - firstLine <= BANK_COUNT << IndexBits)
     {
-        cacheLine->Mesi = MESI::Invalid;
-        if(dataBus)
+        for(u64 line = firstLine; line < endLine; ++line)
         {
-            (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
+            const u64 lineAddress = line << 3;
+            const uSys bankIndex = line & (BANK_COUNT - 1);
+            Bank& bank = m_Banks[bankIndex];
+            const u64 setIndex = GetSetIndex(lineAddress);
+            const uSys way = GetCacheLine(bank, setIndex, lineAddress, external);
+
+            if(way != Set::NO_WAY)
+            {
+                FlushLine(bank, bankIndex, setIndex, way, invalidate);
+            }
         }
+
+        return;
     }
-    else if(cacheLine->Mesi == MESI::Modified)
+
+    for(uSys bankIndex = 0; bankIndex < BANK_COUNT; ++bankIndex)
     {
-        cacheLine->Mesi = MESI::Invalid;
-        if(dataBus)
+        Bank& bank = m_Banks[bankIndex];
+
+        for(u64 setIndex = 0; setIndex < (1ull << IndexBits); ++setIndex)
         {
-            (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
+            const Set& cacheSet = bank.Sets[setIndex];
+
+            // A flush only has to look at the dirty ways.
+            for(u32 ways = invalidate ? static_cast<u32>((1ull << SetLineCount) - 1) : cacheSet.DirtyMask; ways != 0; ways &= ways - 1)
+            {
+                const uSys way = _tzcnt_u32(ways);
+                const u64 key = cacheSet.Keys[way];
+                const u64 line = GetLineAddress(bankIndex, setIndex, key) >> 3;
+
+                if(key != Set::INVALID_KEY && Set::KeyExternal(key) == external && line >= firstLine && line < endLine)
+                {
+                    FlushLine(bank, bankIndex, setIndex, way, invalidate);
+                }
+            }
         }
-        m_MemoryManager->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
     }
-
-    return true;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-void Cache<IndexBits, SetLineCount>::SnoopBusUpgrade(const u32 requestorLine, const u64 address, const bool external) noexcept
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+void SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::FlushLine(Bank& bank, const uSys bankIndex, const u64 setIndex, const uSys way, const bool invalidate) noexcept
 {
-    if(requestorLine == m_LineIndex)
+    const u64 lineAddress = GetLineAddress(bankIndex, setIndex, bank.Sets[setIndex].Keys[way]);
+
+    if(invalidate)
     {
+        EvictCacheLine(bank, setIndex, way, lineAddress);
         return;
     }
 
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    if(bank.Sets[setIndex].States[way] == MESI::Modified)
+    {
+        ++bank.Statistics.MemoryWrites;
+        m_MemoryManager->WriteMemoryLine(lineAddress, bank.Data[setIndex][way], Set::KeyExternal(bank.Sets[setIndex].Keys[way]));
+        SetLineState(bank, setIndex, way, MESI::Exclusive);
+    }
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+CacheStatistics SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::Statistics() const noexcept
+{
+    CacheStatistics total { };
+
+    for(uSys i = 0; i < BANK_COUNT; ++i)
+    {
+        const CacheStatistics& statistics = m_Banks[i].Statistics;
+
+        total.ReadHits += statistics.ReadHits;
+        total.ReadMisses += statistics.ReadMisses;
+        total.WriteHits += statistics.WriteHits;
+        total.WriteMisses += statistics.WriteMisses;
+        total.Evictions += statistics.Evictions;
+        total.MemoryWrites += statistics.MemoryWrites;
+    }
+
+    return total;
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+uSys SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::AllocateCacheLine(Bank& bank, const u64 setIndex, const u64 address, const bool external) noexcept
+{
+    Set& targetSet = bank.Sets[setIndex];
+
+    uSys way = Set::NO_WAY;
 
-    if(cacheLine->Mesi == MESI::Shared)
+    for(uSys i = 0; i < SetLineCount; ++i)
     {
-        cacheLine->Mesi = MESI::Invalid;
+        if(targetSet.States[i] == MESI::Invalid)
+        {
+            way = i;
+            break;
+        }
     }
+
+    if(way == Set::NO_WAY)
+    {
+        way = SelectUnkeptVictim<SetLineCount>(bank.Replacer, bank.ReplacementStates[setIndex], bank.KeptMasks[setIndex]);
+
+        const u64 victimKey = targetSet.Keys[way];
+        const u64 victimAddress = (Set::KeyTag(victimKey) << (BankBits + IndexBits + 3)) | (address & ((1ull << (BankBits + IndexBits + 3)) - 1));
+
+        ++bank.Statistics.Evictions;
+        EvictCacheLine(bank, setIndex, way, victimAddress);
+    }
+
+    bank.Sharers[setIndex][way] = 0;
+    bank.KeptMasks[setIndex] &= ~(1u << way);
+    targetSet.Keys[way] = GetKey(address, external);
+    m_Residency.Add(address);
+
+    return way;
+}
+
+template<uSys BankBits, uSys IndexBits, uSys SetLineCount, EReplacementPolicy Replacement>
+void SharedCache<BankBits, IndexBits, SetLineCount, Replacement>::EvictCacheLine(Bank& bank, const u64 setIndex, const uSys way, const u64 lineAddress) noexcept
+{
+    const bool external = Set::KeyExternal(bank.Sets[setIndex].Keys[way]);
+
+    // Any dirty L0 copies are written back into the line first.
+    SharerMask& sharers = bank.Sharers[setIndex][way];
+
+    if(sharers != 0)
+    {
+        m_MemoryManager->BackInvalidateCacheLine(lineAddress, external, sharers);
+        sharers = 0;
+    }
+
+    if(bank.Sets[setIndex].States[way] == MESI::Modified)
+    {
+        ++bank.Statistics.MemoryWrites;
+        m_MemoryManager->WriteMemoryLine(lineAddress, bank.Data[setIndex][way], external);
+    }
+
+    SetLineState(bank, setIndex, way, MESI::Invalid);
+    bank.Sets[setIndex].Keys[way] = Set::INVALID_KEY;
+    m_Residency.Remove(lineAddress);
 }
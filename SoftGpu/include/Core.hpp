@@ -20,6 +20,11 @@ public:
     virtual void InvokeRegisterFileHigh(RegisterFile::CommandPacket packet) noexcept = 0;
     virtual void InvokeRegisterFileLow(RegisterFile::CommandPacket packet) noexcept = 0;
 
+    // Operands are read and results written directly, the dispatch unit locked the registers beforehand.
+    [[nodiscard]] virtual u32 GetRegister(u32 registerIndex) const noexcept = 0;
+    virtual void SetRegister(u32 registerIndex, u32 value) noexcept = 0;
+    virtual void ReleaseRegisterContestation(u32 registerIndex) noexcept = 0;
+
     virtual void ReportRegisterValues(u64 a, u64 b, u64 c) noexcept = 0;
     virtual void PrepareRegisterWrite(bool is64Bit, u32 storageRegister, u64 value) noexcept = 0;
 
@@ -76,9 +81,19 @@ public:
         }
     }
     
+    // Whether an instruction or a register access is still in flight.
+    [[nodiscard]] bool IsActive() const noexcept
+    {
+        return m_Stage0Ready || m_Stage1Ready || m_Stage2Ready || m_CRM.IsActive();
+    }
+
     void InvokeRegisterFileHigh(RegisterFile::CommandPacket packet) noexcept override;
     void InvokeRegisterFileLow(RegisterFile::CommandPacket packet) noexcept override;
 
+    [[nodiscard]] u32 GetRegister(u32 registerIndex) const noexcept override;
+    void SetRegister(u32 registerIndex, u32 value) noexcept override;
+    void ReleaseRegisterContestation(u32 registerIndex) noexcept override;
+
     void InitiateInstruction(const FpuInstruction fpuInstruction) noexcept
     {
         m_CRM.InitiateRegisterRead(fpuInstruction.Precision == EPrecision::Double, RequiredRegisterCount(fpuInstruction.Operation), fpuInstruction.OperandA, fpuInstruction.OperandB, fpuInstruction.OperandC);
@@ -96,7 +111,7 @@ public:
 
     void ReportRegisterValues(const u64 a, const u64 b, const u64 c) noexcept override
     {
-        switch(RequiredRegisterCount(m_PipelineSlot2.Operation))
+        switch(RequiredRegisterCount(m_PipelineSlot0.Operation))
         {
             case 2:
                 m_PipelineSlot0.OperandC = c;
@@ -180,8 +195,18 @@ public:
         }
     }
     
+    // Whether an instruction or a register access is still in flight.
+    [[nodiscard]] bool IsActive() const noexcept
+    {
+        return m_Stage0Ready || m_Stage1Ready || m_Stage2Ready || m_CRM.IsActive();
+    }
+
     void InvokeRegisterFileHigh(RegisterFile::CommandPacket packet) noexcept override;
     void InvokeRegisterFileLow(RegisterFile::CommandPacket packet) noexcept override;
+
+    [[nodiscard]] u32 GetRegister(u32 registerIndex) const noexcept override;
+    void SetRegister(u32 registerIndex, u32 value) noexcept override;
+    void ReleaseRegisterContestation(u32 registerIndex) noexcept override;
     
     void InitiateInstructionFP(const FpuInstruction fpuInstruction) noexcept
     {
@@ -200,7 +225,7 @@ public:
 
     void ReportRegisterValues(const u64 a, const u64 b, const u64 c) noexcept override
     {
-        switch(RequiredRegisterCount(m_PipelineSlot2.Operation))
+        switch(RequiredRegisterCount(m_PipelineSlot0.Operation))
         {
             case 2:
                 m_PipelineSlot0.OperandC = c;
@@ -66,6 +66,11 @@ public:
 
     void Clock(u32 clockIndex) noexcept;
 
+    [[nodiscard]] bool IsActive() const noexcept
+    {
+        return m_RegisterReadReady || m_RegisterReadLockReleaseReady || m_RegisterWriteReady || m_RegisterWriteLockReleaseReady;
+    }
+
     void InitiateRegisterRead(bool is64Bit, u8 registerCount, u32 registerA, u32 registerB, u32 registerC) noexcept;
     void InitiateRegisterWrite(bool is64Bit, u32 storageRegister, u64 value) noexcept;
 private:
@@ -73,6 +78,8 @@ private:
     void ReadLockRelease() noexcept;
     void RegisterWrite() noexcept;
     void WriteLockRelease() noexcept;
+
+    [[nodiscard]] u64 ReadRegister64(u32 registerIndex) const noexcept;
 private:
     ICore* m_Core;
 
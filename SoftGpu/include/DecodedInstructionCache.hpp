@@ -0,0 +1,156 @@
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+#include <cstring>
+#include <atomic>
+
+#include "DispatchUnit.hpp"
+
+struct DecodedInstruction final
+{
+    u64 InstructionPointer;
+    u64 NextInstructionPointer;
+    u32 Epoch;
+    EInstruction Instruction;
+    InstructionDecodeData::InstructionData Data;
+};
+
+/**
+ * \brief A direct mapped cache of decoded instructions, keyed by the instruction pointer.
+ *
+ *   Each SM shares a single cache between its dispatch units. Entries
+ * are invalidated in bulk by bumping the epoch. To catch self modifying
+ * code every physical cache line an instruction is fetched from is
+ * marked in a small filter. A store from any SM, or a write from the
+ * host, that hits a marked line flags the cache. The processor applies
+ * the flag at the start of the next cycle, so a racing store is seen
+ * from the same cycle whether the SMs are clocked serially or threaded.
+ */
+class DecodedInstructionCache final
+{
+    DEFAULT_DESTRUCT(DecodedInstructionCache);
+    DELETE_CM(DecodedInstructionCache);
+public:
+    static inline constexpr uSys ENTRY_COUNT = 512;
+    static inline constexpr uSys CODE_LINE_FILTER_BITS = 4096;
+public:
+    DecodedInstructionCache() noexcept
+        : m_Entries { }
+        , m_CodeLineFilter { }
+        , m_Epoch(1)
+        , m_HasCodeLines(false)
+        , m_InvalidatePending(false)
+    { }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Entries, 0, sizeof(m_Entries));
+        ClearCodeLines();
+        m_Epoch = 1;
+        m_InvalidatePending.store(false, ::std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] u32 Epoch() const noexcept { return m_Epoch; }
+
+    [[nodiscard]] const DecodedInstruction* Lookup(const u64 instructionPointer) const noexcept
+    {
+        const DecodedInstruction& entry = m_Entries[instructionPointer % ENTRY_COUNT];
+
+        if(entry.Epoch != m_Epoch || entry.InstructionPointer != instructionPointer)
+        {
+            return nullptr;
+        }
+
+        return &entry;
+    }
+
+    void Insert(const u64 instructionPointer, const u64 nextInstructionPointer, const EInstruction instruction, const InstructionDecodeData::InstructionData& data) noexcept
+    {
+        DecodedInstruction& entry = m_Entries[instructionPointer % ENTRY_COUNT];
+        entry.InstructionPointer = instructionPointer;
+        entry.NextInstructionPointer = nextInstructionPointer;
+        entry.Epoch = m_Epoch;
+        entry.Instruction = instruction;
+        entry.Data = data;
+    }
+
+    // Called before every instruction fetch, address is the physical word address.
+    // Marking before the read means a racing write either sees the mark or is seen by the fetch.
+    void MarkCodeLine(const u64 physicalAddress) noexcept
+    {
+        const u64 line = WordToLine(physicalAddress);
+        ::std::atomic<u64>& filterWord = m_CodeLineFilter[(line % CODE_LINE_FILTER_BITS) / 64];
+        const u64 bit = 1ull << (line % 64);
+
+        if(!(filterWord.load(::std::memory_order_relaxed) & bit))
+        {
+            m_HasCodeLines.store(true, ::std::memory_order_relaxed);
+            (void) filterWord.fetch_or(bit);
+        }
+    }
+
+    // Called on every store by any SM and on host writes, address is the physical word address. May be called from any thread.
+    void NotifyWrite(const u64 physicalAddress) noexcept
+    {
+        if(!m_HasCodeLines.load(::std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        const u64 line = WordToLine(physicalAddress);
+
+        if(m_CodeLineFilter[(line % CODE_LINE_FILTER_BITS) / 64].load(::std::memory_order_relaxed) & (1ull << (line % 64)))
+        {
+            m_InvalidatePending.store(true, ::std::memory_order_release);
+        }
+    }
+
+    // Only called between cycles or by the owning SM while it holds shared memory, invalidates everything if a write has hit a marked line since the last check.
+    void SyncPendingInvalidate() noexcept
+    {
+        if(m_InvalidatePending.load(::std::memory_order_relaxed) && m_InvalidatePending.exchange(false, ::std::memory_order_acquire))
+        {
+            Invalidate();
+        }
+    }
+
+    void Invalidate() noexcept
+    {
+        ++m_Epoch;
+
+        // Skip 0 so that zeroed entries are never valid.
+        if(m_Epoch == 0)
+        {
+            (void) ::std::memset(m_Entries, 0, sizeof(m_Entries));
+            m_Epoch = 1;
+        }
+
+        if(m_HasCodeLines.load(::std::memory_order_relaxed))
+        {
+            ClearCodeLines();
+        }
+    }
+private:
+    // Cache lines are 8 words.
+    [[nodiscard]] static u64 WordToLine(const u64 address) noexcept
+    {
+        return address >> 3;
+    }
+
+    void ClearCodeLines() noexcept
+    {
+        m_HasCodeLines.store(false, ::std::memory_order_relaxed);
+
+        for(::std::atomic<u64>& filterWord : m_CodeLineFilter)
+        {
+            filterWord.store(0, ::std::memory_order_relaxed);
+        }
+    }
+private:
+    DecodedInstruction m_Entries[ENTRY_COUNT];
+    ::std::atomic<u64> m_CodeLineFilter[CODE_LINE_FILTER_BITS / 64];
+    u32 m_Epoch;
+    ::std::atomic<bool> m_HasCodeLines;
+    ::std::atomic<bool> m_InvalidatePending;
+};
@@ -5,16 +5,20 @@
 
 #include <cstring>
 
+#include <immintrin.h>
+
 #include "FPU.hpp"
 #include "DebugManager.hpp"
+#include "GpuTopology.hpp"
 
 class StreamingMultiprocessor;
+struct ThreadedBlock;
 
 enum class EInstruction : u8
 {
     Nop = 0,
     Hlt,
-    LoadStore, // { 0 : 1, Read/Write : 1, IndexExponent : 3, RegisterCount : 3 }, BaseRegister : 8, [ IndexRegister : 8 ], TargetRegister : 8, Offset : 16
+    LoadStore, // { HasCacheHint : 1, Read/Write : 1, IndexExponent : 3, RegisterCount : 3 }, BaseRegister : 8, [ IndexRegister : 8 ], TargetRegister : 8, Offset : 16, [ CacheHint : 8 ]
     LoadImmediate, // Register : 8, Value : 32
     LoadZero, // RegisterCount : 8, StartRegister : 8
     SwapRegister, // RegisterA : 8, RegisterB : 8
@@ -96,6 +100,8 @@ struct LoadStoreData final
     u32 IndexRegister : 8;
     u32 TargetRegister : 8;
     i16 Offset;
+    // An ECacheHint, Normal unless the instruction has a hint byte.
+    u8 CacheHint;
 };
 
 struct LoadImmediateData final
@@ -142,6 +148,11 @@ class DispatchUnit final
 {
     DEFAULT_DESTRUCT(DispatchUnit);
     DELETE_CM(DispatchUnit);
+public:
+    // Units that don't exist in the topology are never marked available.
+    static inline constexpr u32 FP_CORE_MASK = (1u << Topology.FpCoreCount) - 1;
+    static inline constexpr u32 INT_FP_CORE_MASK = (1u << Topology.IntFpCoreCount) - 1;
+    static inline constexpr u32 LDST_MASK = (1u << Topology.LdStCount) - 1;
 public:
     DispatchUnit(StreamingMultiprocessor* const sm, const u32 index) noexcept
         : m_SM(sm)
@@ -149,10 +160,10 @@ public:
         , m_BaseRegisters{ 0, 0, 0, 0, 0, 0, 0, 0 }
         , m_ClockIndex(0)
         , m_InstructionPointer(0)
-        , m_FpAvailabilityMap(0xFF)
-        , m_IntFpAvailabilityMap(0xFF)
+        , m_FpAvailabilityMap(FP_CORE_MASK)
+        , m_IntFpAvailabilityMap(INT_FP_CORE_MASK)
         , m_SfuAvailabilityMap(0xF)
-        , m_LdStAvailabilityMap(0xF)
+        , m_LdStAvailabilityMap(LDST_MASK)
         , m_TextureSamplerAvailabilityMap(0x3)
         , m_IsStalled(0)
         , m_NeedToDecode(true)
@@ -183,10 +194,10 @@ public:
 
         m_ClockIndex = 0;
         m_InstructionPointer = 0;
-        m_FpAvailabilityMap = 0xFF;
-        m_IntFpAvailabilityMap = 0xFF;
+        m_FpAvailabilityMap = FP_CORE_MASK;
+        m_IntFpAvailabilityMap = INT_FP_CORE_MASK;
         m_SfuAvailabilityMap = 0xF;
-        m_LdStAvailabilityMap = 0xF;
+        m_LdStAvailabilityMap = LDST_MASK;
         m_TextureSamplerAvailabilityMap = 0x3;
         m_IsStalled = 0;
         m_NeedToDecode = true;
@@ -208,6 +219,31 @@ public:
 
     void Clock() noexcept;
 
+    // Executes the next instruction for every replication directly against the register file and memory.
+    // This bypasses the execution units entirely, only the architectural results are preserved.
+    void ExecuteFunctional() noexcept;
+
+    // Whether the unit has nothing to execute, either it was never loaded or every replication has halted.
+    [[nodiscard]] bool IsIdle() const noexcept
+    {
+        if(!m_InstructionPointer)
+        {
+            return true;
+        }
+
+        return !m_NeedToDecode && m_CurrentInstruction == EInstruction::Hlt && m_ReplicationMask == 0x0u;
+    }
+
+    // Accounts for cycles that were skipped while idle, exactly as if ResetCycle had been called for each.
+    void AdvanceIdleCycles(const u64 cycleCount) noexcept
+    {
+        m_TotalIterationsTracker += cycleCount;
+        m_FpSaturationTracker += cycleCount * (Topology.FpCoreCount - _mm_popcnt_u32(m_FpAvailabilityMap));
+        m_IntFpSaturationTracker += cycleCount * (Topology.IntFpCoreCount - _mm_popcnt_u32(m_IntFpAvailabilityMap));
+        m_LdStSaturationTracker += cycleCount * (Topology.LdStCount - _mm_popcnt_u32(m_LdStAvailabilityMap));
+        m_TextureSaturationTracker += cycleCount * (2 - _mm_popcnt_u32(m_TextureSamplerAvailabilityMap));
+    }
+
     void ReportUnitReady(u32 unitIndex) noexcept
     {
         if(unitIndex < 8)
@@ -322,6 +358,8 @@ public:
         m_ReplicationCompletedMask = 0x0;
         ::std::memcpy(m_BaseRegisters, baseRegisters, sizeof(u16[4]));
         m_InstructionPointer = instructionPointer;
+        // Whatever was decoded belongs to the previous program.
+        m_NeedToDecode = true;
     }
 
     void LoadWarp(const u32 enabledMask, const u32 completedMask, const u16 baseRegisters[8], const u64 instructionPointer) noexcept
@@ -330,9 +368,10 @@ public:
         m_ReplicationCompletedMask = completedMask;
         ::std::memcpy(m_BaseRegisters, baseRegisters, sizeof(m_BaseRegisters));
         m_InstructionPointer = instructionPointer;
+        m_NeedToDecode = true;
     }
 
-    void ReportBaseRegisters(const u32 smIndex) noexcept
+    void ReportBaseRegisters(const u32 smIndex) const noexcept
     {
         if(GlobalDebug.IsAttached())
         {
@@ -347,6 +386,8 @@ public:
         }
     }
 private:
+    void Decode() noexcept;
+
     void NextInstruction(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) const noexcept;
 
     [[nodiscard]] bool CanReadRegister(u32 registerIndex, u32 replicationIndex) noexcept;
@@ -366,6 +407,14 @@ private:
     void DispatchLoadZero(u32 replicationIndex) noexcept;
     void DispatchWriteStatistics(u32 replicationIndex) noexcept;
     void DispatchFpuBinOp(u32 replicationIndex) noexcept;
+
+    void SetRegister(u32 registerIndex, u32 replicationIndex, u32 value) noexcept;
+
+    void ExecuteWriteStatisticsFunctional(u32 replicationIndex) noexcept;
+
+    // Runs the threaded block starting at the instruction pointer, returns false if its first instruction has no handler.
+    [[nodiscard]] bool ExecuteThreadedBlock() noexcept;
+    [[nodiscard]] const ThreadedBlock& BuildThreadedBlock() noexcept;
 private:
     template<typename T>
     T ReadT(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) const noexcept
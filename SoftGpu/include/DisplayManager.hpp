@@ -116,6 +116,7 @@ public:
         , m_DisplaysEdid{ }
         , m_Displays{ }
         , m_CurrentPacket()
+        , m_BusActive(false)
         , m_UpdateCallback(nullptr)
         , m_VSyncEvent(0)
     { }
@@ -136,7 +137,7 @@ public:
         }
         else
         {
-            if(!m_CurrentPacket.BusActive)
+            if(!m_BusActive.load(::std::memory_order_relaxed))
             {
                 return;
             }
@@ -239,14 +240,21 @@ public:
         }
     }
 
+    [[nodiscard]] bool HasPendingWork() const noexcept
+    {
+        return m_BusActive.load(::std::memory_order_relaxed) || m_VSyncEvent.load(::std::memory_order_relaxed) != 0;
+    }
+
     void SetBus(const DisplayDataPacket& bus) noexcept
     {
         m_CurrentPacket = bus;
+        m_BusActive.store(bus.BusActive, ::std::memory_order_relaxed);
     }
 
     void ResetBus() noexcept
     {
         m_CurrentPacket.BusActive = 0;
+        m_BusActive.store(false, ::std::memory_order_relaxed);
         m_CurrentPacket.PacketType = 0;
         m_CurrentPacket.Read = 0;
         m_CurrentPacket.DisplayIndex = 0;
@@ -259,10 +267,7 @@ public:
     [[nodiscard]] EdidBlock& GetDisplayEdid(const uSys index) noexcept { return m_DisplaysEdid[index]; }
     [[nodiscard]] DisplayUpdateCallback_f& UpdateCallback() noexcept { return m_UpdateCallback; }
 
-    void SetDisplayVSyncEvent(const u32 display) noexcept
-    {
-        m_VSyncEvent = display + 1;
-    }
+    void SetDisplayVSyncEvent(u32 display) noexcept;
 private:
     void HandleVSyncEvent() noexcept;
 private:
@@ -270,6 +275,8 @@ private:
     EdidBlock m_DisplaysEdid[MaxDisplayCount];
     DisplayData m_Displays[MaxDisplayCount];
     DisplayDataPacket m_CurrentPacket;
+    // The packet's BusActive bit, atomic so HasPendingWork can be polled from other threads.
+    ::std::atomic_bool m_BusActive;
 
     DisplayUpdateCallback_f m_UpdateCallback;
     ::std::atomic_uint32_t m_VSyncEvent;
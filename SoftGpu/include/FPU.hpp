@@ -2,6 +2,7 @@
 
 #include <Objects.hpp>
 #include <NumTypes.hpp>
+#include <cmath>
 
 enum class EFpuOp : u32
 {
@@ -103,6 +104,36 @@ public:
     void Clock() noexcept;
 
     void ExecuteInstruction(LoadedFpuInstruction instructionInfo) noexcept;
+
+    // The arithmetic of a basic binary op without any of the timing, shared with the functional execution engine.
+    [[nodiscard]] static f32 EvaluateBinOp(f32 valueA, f32 valueB, EBinOp op) noexcept;
+    [[nodiscard]] static f64 EvaluateBinOp(f64 valueA, f64 valueB, EBinOp op) noexcept;
+
+    // The same arithmetic with the op fixed at compile time, for the threaded blocks.
+    template<EBinOp Op, typename T>
+    [[nodiscard]] static T EvaluateBinOp(const T valueA, const T valueB) noexcept
+    {
+        if constexpr(Op == EBinOp::Add)
+        {
+            return valueA + valueB;
+        }
+        else if constexpr(Op == EBinOp::Subtract)
+        {
+            return valueA - valueB;
+        }
+        else if constexpr(Op == EBinOp::Multiply)
+        {
+            return valueA * valueB;
+        }
+        else if constexpr(Op == EBinOp::Divide)
+        {
+            return valueA / valueB;
+        }
+        else
+        {
+            return ::std::fmod(valueA, valueB);
+        }
+    }
 private:
     [[nodiscard]] f32 BasicBinOpF32(f32 valueA, f32 valueB, EBinOp op) noexcept;
     [[nodiscard]] f64 BasicBinOpF64(f64 valueA, f64 valueB, EBinOp op) noexcept;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <NumTypes.hpp>
+
+#include "ReplacementPolicy.hpp"
+
+enum class ECoherenceProtocol : u8
+{
+    Mesi = 0,
+    // Adds an Owned state, so dirty lines are shared cache to cache instead of being written back.
+    Moesi
+};
+
+/**
+ * \brief The shape of the simulated GPU, fixed at compile time.
+ *
+ *   Every unit array, and every loop over units, is sized from the
+ * selected topology, so all trip counts are constant and the compiler
+ * unrolls them just like the literal sizes they replace. Define
+ * SOFTGPU_TOPOLOGY_COMPACT, SOFTGPU_TOPOLOGY_WIDE or
+ * SOFTGPU_TOPOLOGY_TUNED for the whole build to select a different
+ * shape; by default the original 4 SM layout is used. Every preset but
+ * the tuned one keeps the original round robin replacement and MESI.
+ */
+struct GpuTopology final
+{
+    u32 SmCount;
+    // The following are per SM.
+    u32 DispatchUnitCount;
+    u32 LdStCount;
+    u32 FpCoreCount;
+    u32 IntFpCoreCount;
+    // Each SM has a private L0 cache of (1 << L0IndexBits) sets.
+    uSys L0IndexBits;
+    uSys L0SetLineCount;
+    // Misses each L0 can have outstanding at once.
+    u32 L0MshrCount;
+    // The shared L2 has (1 << L2BankBits) banks of (1 << L2IndexBits) sets each.
+    uSys L2BankBits;
+    uSys L2IndexBits;
+    uSys L2SetLineCount;
+    EReplacementPolicy L0Replacement;
+    EReplacementPolicy L2Replacement;
+    ECoherenceProtocol L0Coherence;
+};
+
+// Limits set by the ISA and the register file rather than the simulator.
+// The dispatch port is a single bit in the instruction packets.
+static inline constexpr u32 MAX_DISPATCH_UNIT_COUNT = 2;
+// Each LoadStore unit owns a register file port pair.
+static inline constexpr u32 MAX_LDST_COUNT = 4;
+// The dispatch unit availability maps reserve 8 slots for each core type.
+static inline constexpr u32 MAX_FP_CORE_COUNT = 8;
+static inline constexpr u32 MAX_INT_FP_CORE_COUNT = 8;
+
+// The original layout, with a 256 KiB L2.
+static inline constexpr GpuTopology DefaultTopology { 4, 2, 4, 8, 8, 8, 4, 8, 2, 8, 8, EReplacementPolicy::RoundRobin, EReplacementPolicy::RoundRobin, ECoherenceProtocol::Mesi };
+// Small enough to run comfortably on a CI VM, with a 32 KiB L2.
+static inline constexpr GpuTopology CompactTopology { 2, 1, 2, 4, 4, 6, 2, 4, 1, 7, 4, EReplacementPolicy::RoundRobin, EReplacementPolicy::RoundRobin, ECoherenceProtocol::Mesi };
+// For throughput experiments on large hosts, with a 1 MiB L2.
+static inline constexpr GpuTopology WideTopology { 8, 2, 4, 8, 8, 8, 8, 16, 3, 8, 16, EReplacementPolicy::RoundRobin, EReplacementPolicy::RoundRobin, ECoherenceProtocol::Mesi };
+// The original layout with tree PLRU L0s, an SRRIP L2 and MOESI between the L0s.
+static inline constexpr GpuTopology TunedTopology { 4, 2, 4, 8, 8, 8, 4, 8, 2, 8, 8, EReplacementPolicy::TreePlru, EReplacementPolicy::Srrip, ECoherenceProtocol::Moesi };
+
+#if defined(SOFTGPU_TOPOLOGY_COMPACT)
+static inline constexpr GpuTopology Topology = CompactTopology;
+#elif defined(SOFTGPU_TOPOLOGY_WIDE)
+static inline constexpr GpuTopology Topology = WideTopology;
+#elif defined(SOFTGPU_TOPOLOGY_TUNED)
+static inline constexpr GpuTopology Topology = TunedTopology;
+#else
+static inline constexpr GpuTopology Topology = DefaultTopology;
+#endif
+
+// SM 0 is clocked on the processor thread, SmWorkerPool needs at least one worker.
+static_assert(Topology.SmCount >= 2, "At least 2 SMs are required.");
+static_assert(Topology.DispatchUnitCount >= 1 && Topology.DispatchUnitCount <= MAX_DISPATCH_UNIT_COUNT, "Invalid dispatch unit count.");
+static_assert(Topology.LdStCount >= 1 && Topology.LdStCount <= MAX_LDST_COUNT, "Invalid LoadStore unit count.");
+static_assert(Topology.FpCoreCount >= 1 && Topology.FpCoreCount <= MAX_FP_CORE_COUNT, "Invalid FP core count.");
+static_assert(Topology.IntFpCoreCount >= 1 && Topology.IntFpCoreCount <= MAX_INT_FP_CORE_COUNT, "Invalid Int/FP core count.");
+static_assert(Topology.L0SetLineCount >= 1, "The L0 cache needs at least 1 line per set.");
+static_assert(Topology.L0MshrCount >= 1 && Topology.L0MshrCount <= 32, "Invalid L0 MSHR count.");
+static_assert(Topology.L2SetLineCount >= 1, "The L2 cache needs at least 1 line per set.");
+// The L2 is inclusive, so it has to be able to hold everything the L0s do.
+static_assert((1ull << (Topology.L2BankBits + Topology.L2IndexBits)) * Topology.L2SetLineCount >= (1ull << Topology.L0IndexBits) * Topology.L0SetLineCount * Topology.SmCount, "The L2 cache is smaller than the L0 caches combined.");
@@ -13,7 +13,8 @@ struct LoadStoreInstruction final
     u32 ReadWrite : 1; // Loading = 0, Storing = 1
     u32 IndexExponent : 3; // Index multiplier can be either 1, 2, 4, 8, 16, 32, 64, or 0. 111 disables indexing, every other value is equal to 2**xxx
     u32 RegisterCount : 3; // Indicates how many registers in a sequence are being Loaded/Stored. This uses 1 based index. This is enough to store a full vec4d.
-    u32 Pad0 : 8; // Pad for x86 alignment.
+    u32 CacheHint : 2; // An ECacheHint.
+    u32 Pad0 : 6; // Pad for x86 alignment.
     u32 BaseRegister : 12; // The base register to address to. This points to a sequence of 2 registers.
     u32 IndexRegister : 12; // The index register to address to. This will be ignored if IndexExponent is 111
     u32 TargetRegister : 12; // The target register to Load or Store.
@@ -40,6 +41,8 @@ public:
         , m_Address(0)
         , m_IndexRegister(0)
         , m_CurrentRegister(0)
+        , m_LoadPending(false)
+        , m_ReadyCycle(0)
     { }
 
     void Reset()
@@ -53,10 +56,18 @@ public:
         m_Address = 0;
         m_IndexRegister = 0;
         m_CurrentRegister = 0;
+        m_LoadPending = false;
+        m_ReadyCycle = 0;
     }
 
     void Clock() noexcept
     {
+        // Waiting on a cache miss, the stalled stage is retried once it completes.
+        if(m_ReadyCycle > CurrentCycle())
+        {
+            return;
+        }
+
         switch(m_ExecutionStage)
         {
             case 0: return;
@@ -90,10 +101,17 @@ public:
         --m_ExecutionStage;
     }
 
+    [[nodiscard]] bool IsActive() const noexcept { return m_ExecutionStage != 0; }
+
     void PrepareExecution(LoadStoreInstruction instructionInfo) noexcept
     {
         (void) ::std::memcpy(&m_Instruction, &instructionInfo, sizeof(instructionInfo));
         m_ExecutionStage = MAX_EXECUTION_STAGE;
+        m_CurrentRegister = static_cast<u16>(instructionInfo.TargetRegister);
+        m_SuccessfulHigh = false;
+        m_UnsuccessfulHigh = false;
+        m_SuccessfulLow = false;
+        m_UnsuccessfulLow = false;
     }
 
     // void Execute(LoadStoreInstruction instructionInfo) noexcept;
@@ -226,6 +244,13 @@ private:
 
     void PipelineRWHandler(u32 index) noexcept;
     void PipelineReleaseHandler(u32 index) noexcept;
+
+    // Returns false if the load has to wait, m_ReadyCycle is then set.
+    [[nodiscard]] bool IssueLoad() noexcept;
+    [[nodiscard]] u64 CurrentCycle() const noexcept;
+
+    // Returns true if the command issued by the previous stage failed, the stage is then set up to issue it again.
+    [[nodiscard]] bool RetryFailedStage() noexcept;
 private:
     StreamingMultiprocessor* m_SM;
     u32 m_UnitIndex;
@@ -256,4 +281,8 @@ private:
     };
 
     u16 m_CurrentRegister;
+
+    // The loaded value is in m_TargetValue, but the miss it came from is still outstanding.
+    bool m_LoadPending;
+    u64 m_ReadyCycle;
 };
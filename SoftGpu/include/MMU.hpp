@@ -29,7 +29,11 @@ struct PageEntry final
             // If 1 then this external memory (likely on the motherboard).
             u64 External : 1;
             u64 PhysicalAddress : 48;
-            u64 Reserved1 : 8;
+            // In a page directory entry, if 1 then this directly maps the entire span of the directory entry.
+            // In a page table entry, if 1 then this is part of a medium page, see GpuMediumPageShift.
+            // The Accessed and Dirty bits of a medium page are only kept in the first entry of its run, those of the other entries are left as they are.
+            u64 LargePage : 1;
+            u64 Reserved1 : 7;
         };
         u64 Value;
     };
@@ -38,84 +42,345 @@ struct PageEntry final
 static_assert(sizeof(PageEntry) == 8, "Page Entry is not 8 bytes long.");
 
 static inline constexpr u64 GpuPageSize = 65536;
+// A large page spans every page of a page directory entry, (1 << GpuLargePageShift) pages or 4 GiB.
+static inline constexpr u64 GpuLargePageShift = 16;
+// A medium page spans an aligned run of (1 << GpuMediumPageShift) page table entries, 16 MiB.
+// Every entry of the run has LargePage set and maps its own page, the pages must be physically contiguous.
+static inline constexpr u64 GpuMediumPageShift = 8;
+// Page directories and page tables each hold 65536 entries.
+static inline constexpr u64 GpuPageTableSize = 65536 * sizeof(PageEntry);
 
+struct TlbEntry final
+{
+    // The virtual address in pages, this is the full tag, the set index is not stripped.
+    u64 VirtualPage;
+    // Word address of the page table entry, used to write back the Accessed and Dirty bits.
+    u64 PageEntryAddress;
+    PageEntry Entry;
+    // The address space the translation belongs to.
+    u16 Asid;
+    bool Valid;
+    // 0 for a single page, otherwise the entry is split from a (1 << PageShift) page span. Set on the medium and large page TLB entries, and on the L1 entries split from them.
+    u8 PageShift;
+    // The Accessed or Dirty bit changed and hasn't been written to memory yet. Only tracked in the L2 and large page TLBs.
+    bool WritebackPending;
+};
+
+/**
+ * \brief A set associative cache of page table entries.
+ *
+ *   Entries are tagged with the ASID they were walked under, so the
+ * translations of several address spaces can live side by side. Only
+ * present pages are ever inserted, a fault always walks the page tables
+ * again. Victims are picked with a rolling selector, the same as the L0
+ * data caches.
+ */
+template<uSys SetCount, uSys WayCount>
+class Tlb final
+{
+    DEFAULT_DESTRUCT(Tlb);
+    DELETE_CM(Tlb);
+public:
+    static_assert((SetCount & (SetCount - 1)) == 0, "The TLB set count must be a power of 2.");
+
+    static inline constexpr uSys ENTRY_COUNT = SetCount * WayCount;
+public:
+    Tlb() noexcept
+        : m_Sets { }
+        , m_RollingSelector(0)
+    { }
+
+    void Invalidate() noexcept
+    {
+        for(uSys i = 0; i < SetCount; ++i)
+        {
+            for(uSys j = 0; j < WayCount; ++j)
+            {
+                m_Sets[i][j].Valid = false;
+            }
+        }
+
+        m_RollingSelector = 0;
+    }
+
+    void InvalidateAsid(const u16 asid) noexcept
+    {
+        for(uSys i = 0; i < SetCount; ++i)
+        {
+            for(uSys j = 0; j < WayCount; ++j)
+            {
+                if(m_Sets[i][j].Asid == asid)
+                {
+                    m_Sets[i][j].Valid = false;
+                }
+            }
+        }
+    }
+
+    void InvalidatePage(const u64 virtualPage, const u16 asid) noexcept
+    {
+        if(TlbEntry* const entry = Lookup(virtualPage, asid))
+        {
+            entry->Valid = false;
+        }
+    }
+
+    // Drops every page that was split from a medium or large page containing the page.
+    void InvalidateSpans(const u64 virtualPage, const u16 asid) noexcept
+    {
+        for(uSys i = 0; i < SetCount; ++i)
+        {
+            for(uSys j = 0; j < WayCount; ++j)
+            {
+                TlbEntry& entry = m_Sets[i][j];
+
+                if(entry.PageShift != 0 && entry.Asid == asid && (entry.VirtualPage >> entry.PageShift) == (virtualPage >> entry.PageShift))
+                {
+                    entry.Valid = false;
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] TlbEntry* Lookup(const u64 virtualPage, const u16 asid) noexcept
+    {
+        TlbEntry* const set = m_Sets[virtualPage & (SetCount - 1)];
+
+        for(uSys i = 0; i < WayCount; ++i)
+        {
+            if(set[i].Valid && set[i].VirtualPage == virtualPage && set[i].Asid == asid)
+            {
+                return &set[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    [[nodiscard]] TlbEntry* Entries() noexcept { return &m_Sets[0][0]; }
+
+    // If a valid entry is evicted it is copied into evicted.
+    TlbEntry* Insert(const TlbEntry& entry, TlbEntry* const evicted = nullptr) noexcept
+    {
+        TlbEntry* const set = m_Sets[entry.VirtualPage & (SetCount - 1)];
+
+        TlbEntry* victim = nullptr;
+
+        for(uSys i = 0; i < WayCount; ++i)
+        {
+            if(!set[i].Valid)
+            {
+                victim = &set[i];
+                break;
+            }
+        }
+
+        if(!victim)
+        {
+            victim = &set[(m_RollingSelector++) % WayCount];
+
+            if(evicted)
+            {
+                *evicted = *victim;
+            }
+        }
+
+        *victim = entry;
+        victim->Valid = true;
+        return victim;
+    }
+private:
+    TlbEntry m_Sets[SetCount][WayCount];
+    u32 m_RollingSelector;
+};
+
+/**
+ * \brief Translates virtual word addresses through a two level TLB.
+ *
+ *   Instruction fetches and data accesses each get a small L1 TLB, both
+ * backed by an L2 TLB. On a miss in both, the page walker reads just
+ * the directory and table entries for that address.
+ *
+ *   The L2 TLB is private to each SM rather than shared between them.
+ * The SMs are clocked in parallel on the worker pool, so a shared TLB
+ * would need a lock on every L1 miss. Each SM also loads its own page
+ * directory, and ASID 0 is untagged, so an ASID alone can't tell whose
+ * translation an entry is. The pending Accessed and Dirty writebacks
+ * are tracked per Mmu as well.
+ *
+ *   A directory entry with LargePage set maps its whole span without a
+ * page table, it costs a single read to walk. Page table entries with
+ * LargePage set form medium pages, the walk is unchanged but a single
+ * TLB entry covers the whole run, with its Accessed and Dirty bits kept
+ * in the first entry of the run. Medium and large pages are each held
+ * in their own small TLB, and the L1 TLBs get the individual pages
+ * split from them, so the hot path doesn't care about the page size.
+ * Neither needs to be physically aligned, pages are placed at an offset
+ * from the base.
+ *
+ *   Translations are tagged with the ASID the page directory was loaded
+ * with, so switching between tagged address spaces keeps them warm. ASID
+ * 0 is untagged, loading a directory with it drops the old ASID 0
+ * translations. Whoever reuses an ASID for a different directory, or
+ * edits live page tables, must invalidate the stale translations.
+ *
+ *   Accessed and Dirty bits are set in the TLB entries and marked for
+ * writeback on the L2, medium or large page copy. They reach memory when the L2 entry is
+ * evicted, when translations are invalidated, and at the fence points
+ * (FlushCache and Hlt), so repeated updates to a page cost a single
+ * write.
+ */
 class Mmu final
 {
     DEFAULT_DESTRUCT(Mmu);
     DELETE_CM(Mmu);
+public:
+    using InstructionTlb = Tlb<4, 4>;
+    using DataTlb = Tlb<8, 4>;
+    using L2Tlb = Tlb<64, 8>;
+    using MediumTlb = Tlb<8, 4>;
+    using LargeTlb = Tlb<1, 8>;
+
+    // Virtual addresses are in words, so a 64 KiB page is 14 bits of offset.
+    static inline constexpr u64 PAGE_OFFSET_BITS = 14;
+    static inline constexpr u64 PAGE_OFFSET_MASK = (1ull << PAGE_OFFSET_BITS) - 1;
+    // The Accessed and Dirty bits, both live in the low word of a PageEntry.
+    static inline constexpr u32 PAGE_ENTRY_ACCESSED_DIRTY_MASK = 0x00000060;
 public:
     Mmu(StreamingMultiprocessor* const sm) noexcept
         : m_SM(sm)
         , m_PageDirectoryPhysicalAddress(0)
-        , m_CachedTableIndex(0)
-        , m_CacheDirty(true)
+        , m_Asid(0)
         , m_ValueLoaded(false)
-        , m_PageDirectoryCache{ }
-        , m_PageTableCache{ }
+        , m_PendingWritebackCount(0)
+        , m_InstructionTlb { }
+        , m_DataTlb { }
+        , m_L2Tlb { }
+        , m_MediumTlb { }
+        , m_LargeTlb { }
     { }
 
     void Reset()
     {
         m_PageDirectoryPhysicalAddress = 0;
-        m_CachedTableIndex = 0;
-        m_CacheDirty = true;
+        m_Asid = 0;
         m_ValueLoaded = false;
+        // Anything still pending belongs to the old page tables.
+        m_PendingWritebackCount = 0;
+        m_InstructionTlb.Invalidate();
+        m_DataTlb.Invalidate();
+        m_L2Tlb.Invalidate();
+        m_MediumTlb.Invalidate();
+        m_LargeTlb.Invalidate();
     }
 
     [[nodiscard]] u64 TranslateAddress(u64 virtualAddress, bool* success, bool* readWrite, bool* execute, bool* writeThrough, bool* cacheDisable, bool* external) noexcept;
+    // Translates a store, marking the page Dirty if it is writable.
+    [[nodiscard]] u64 TranslateWriteAddress(u64 virtualAddress, bool* success, bool* readWrite, bool* execute, bool* writeThrough, bool* cacheDisable, bool* external) noexcept;
+    [[nodiscard]] u64 TranslateInstructionAddress(u64 virtualAddress, bool* success, bool* cacheDisable, bool* external) noexcept;
 
-    void MarkDirty(u64 virtualAddress) noexcept;
+    [[nodiscard]] bool HasPendingWriteback() const noexcept { return m_PendingWritebackCount != 0; }
 
-    void LoadPageDirectoryPointer(const u64 pageDirectoryPhysicalAddress) noexcept
+    // Writes every pending Accessed and Dirty bit to the page tables.
+    void WriteBackPageEntries() noexcept
     {
-        m_PageDirectoryPhysicalAddress = pageDirectoryPhysicalAddress;
-        m_ValueLoaded = true;
-        FlushCache();
+        if(m_PendingWritebackCount != 0)
+        {
+            WriteBackPendingEntries();
+        }
     }
 
-    void FlushCache() noexcept
+    void LoadPageDirectoryPointer(const u64 pageDirectoryPhysicalAddress, const u16 asid) noexcept
     {
-        if(!m_ValueLoaded)
+        m_PageDirectoryPhysicalAddress = pageDirectoryPhysicalAddress;
+        m_Asid = asid;
+        m_ValueLoaded = true;
+
+        if(asid == 0)
         {
-            return;
+            InvalidateAsid(0);
         }
+    }
 
-        // Translate the address to be in bytes.
-        const u64 pageDirectoryAddress = m_PageDirectoryPhysicalAddress << 16;
-        // Convert the address to a C++ Pointer.
-        void* const pageDirectoryPtr = reinterpret_cast<void*>(pageDirectoryAddress);
+    [[nodiscard]] u16 Asid() const noexcept { return m_Asid; }
 
-        // Copy the memory into our cache.
-        (void) ::std::memcpy(m_PageDirectoryCache, pageDirectoryPtr, GpuPageSize);
+    void InvalidateAsid(const u16 asid) noexcept
+    {
+        WriteBackPageEntries();
 
-        // Is m_CachedTableIndex valid?
-        if(!m_CacheDirty)
-        {
-            // Is the target table present?
-            if(m_PageDirectoryCache[m_CachedTableIndex].Present)
-            {
-                // Translate the address to be in bytes.
-                const u64 pageTableAddress = m_PageDirectoryCache[m_CachedTableIndex].PhysicalAddress << 16;
-                // Convert the address to a C++ Pointer.
-                void* const pageTablePtr = reinterpret_cast<void*>(pageTableAddress);
+        m_InstructionTlb.InvalidateAsid(asid);
+        m_DataTlb.InvalidateAsid(asid);
+        m_L2Tlb.InvalidateAsid(asid);
+        m_MediumTlb.InvalidateAsid(asid);
+        m_LargeTlb.InvalidateAsid(asid);
+    }
 
-                // Copy the memory into our cache.
-                (void) ::std::memcpy(m_PageTableCache, pageTablePtr, GpuPageSize);
-            }
-            else
-            {
-                m_CacheDirty = true;
-            }
-        }
+    // The virtual address is in words.
+    void InvalidatePage(const u64 virtualAddress, const u16 asid) noexcept
+    {
+        const u64 virtualPage = virtualAddress >> PAGE_OFFSET_BITS;
+
+        WriteBackPageEntries();
+
+        m_InstructionTlb.InvalidatePage(virtualPage, asid);
+        m_DataTlb.InvalidatePage(virtualPage, asid);
+        m_L2Tlb.InvalidatePage(virtualPage, asid);
+
+        // The address may be inside a medium or large page, in which case the whole span goes.
+        m_InstructionTlb.InvalidateSpans(virtualPage, asid);
+        m_DataTlb.InvalidateSpans(virtualPage, asid);
+        m_MediumTlb.InvalidatePage(virtualPage >> GpuMediumPageShift, asid);
+        m_LargeTlb.InvalidatePage(virtualPage >> GpuLargePageShift, asid);
     }
+
+    void FlushCache() noexcept
+    {
+        WriteBackPageEntries();
+
+        m_InstructionTlb.Invalidate();
+        m_DataTlb.Invalidate();
+        m_L2Tlb.Invalidate();
+        m_MediumTlb.Invalidate();
+        m_LargeTlb.Invalidate();
+    }
+private:
+    template<bool Write, uSys SetCount, uSys WayCount>
+    [[nodiscard]] u64 Translate(Tlb<SetCount, WayCount>& l1Tlb, u64 virtualAddress, bool* success, bool* readWrite, bool* execute, bool* writeThrough, bool* cacheDisable, bool* external) noexcept;
+
+    // Finds the entry for a page, filling the L1 TLB from the L2 TLB or the page tables. Returns nullptr if the page is not present.
+    template<uSys SetCount, uSys WayCount>
+    [[nodiscard]] TlbEntry* LookupPage(Tlb<SetCount, WayCount>& l1Tlb, u64 virtualPage) noexcept;
+
+    [[nodiscard]] bool WalkPageTables(u64 virtualPage, TlbEntry* entry) const noexcept;
+
+    // Inserts into the L2, medium or large page TLB, writing back the victim if it has pending bits.
+    template<uSys SetCount, uSys WayCount>
+    TlbEntry* InsertBacking(Tlb<SetCount, WayCount>& tlb, const TlbEntry& entry) noexcept;
+
+    // Builds the L1 entry of a single page within a medium or large page.
+    [[nodiscard]] static TlbEntry SplitSpan(const TlbEntry& spanEntry, u64 virtualPage) noexcept;
+
+    // Finds the L2, medium or large page copy of an L1 entry.
+    [[nodiscard]] TlbEntry* LookupBacking(const TlbEntry& entry) noexcept;
+
+    // Sets the Accessed, and optionally Dirty, bit and marks the L2 copy of the entry for writeback.
+    void UpdatePageEntry(TlbEntry& entry, bool dirty) noexcept;
+
+    void WriteBackPendingEntries() noexcept;
+
+    template<uSys SetCount, uSys WayCount>
+    void WriteBackPendingEntries(Tlb<SetCount, WayCount>& tlb) noexcept;
+
+    void WriteBackPageEntry(const TlbEntry& entry) noexcept;
 private:
     StreamingMultiprocessor* m_SM;
-    u64 m_PageDirectoryPhysicalAddress : 48;
-    u64 m_CachedTableIndex : 14;
-    u64 m_CacheDirty : 1;
-    u64 m_ValueLoaded : 1;
-    // Cache the entire page directory.
-    PageEntry m_PageDirectoryCache[GpuPageSize / sizeof(PageEntry)];
-    // Cache a single page table.
-    PageEntry m_PageTableCache[GpuPageSize / sizeof(PageEntry)];
+    u64 m_PageDirectoryPhysicalAddress;
+    u16 m_Asid;
+    bool m_ValueLoaded;
+    u32 m_PendingWritebackCount;
+    InstructionTlb m_InstructionTlb;
+    DataTlb m_DataTlb;
+    L2Tlb m_L2Tlb;
+    MediumTlb m_MediumTlb;
+    LargeTlb m_LargeTlb;
 };
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include <immintrin.h>
+
+#include "Cache.hpp"
+
+struct MshrStatistics final
+{
+    // Misses that allocated an entry.
+    u64 PrimaryMisses;
+    // Accesses that merged into a miss already outstanding on their line.
+    u64 SecondaryMisses;
+    // Misses that had to wait for an entry to free up.
+    u64 FullStalls;
+};
+
+/**
+ * \brief The miss status holding registers of an SM's L0 cache.
+ *
+ *   The caches still move the data the moment a line is first touched,
+ * the MSHRs only track how long each miss takes to come back. A load
+ * that misses allocates an entry and the LoadStore unit waits for its
+ * ready cycle, while the other units and dispatch keep going. Loads to
+ * a line that is already outstanding merge into its entry, and a miss
+ * only blocks on the MSHRs themselves when every entry is in use.
+ *
+ *   Entries retire lazily, once the cycle passed in reaches their ready
+ * cycle.
+ */
+template<uSys EntryCount>
+class MissStatusHoldingRegisters final
+{
+    DEFAULT_DESTRUCT(MissStatusHoldingRegisters);
+    DELETE_CM(MissStatusHoldingRegisters);
+public:
+    static_assert(EntryCount >= 1 && EntryCount <= 32, "The MSHR valid mask is 32 bits.");
+
+    static inline constexpr u32 FULL_MASK = static_cast<u32>((1ull << EntryCount) - 1);
+
+    // Cycles for a line to come back from each level, in SM clocks.
+    static inline constexpr u64 L2_LATENCY = 20;
+    static inline constexpr u64 MEMORY_LATENCY = 80;
+public:
+    MissStatusHoldingRegisters() noexcept
+        : m_Entries{ }
+        , m_ValidMask(0)
+        , m_Statistics{ }
+    { }
+
+    void Reset() noexcept
+    {
+        m_ValidMask = 0;
+        m_Statistics = { };
+    }
+
+    [[nodiscard]] static u64 MissLatency(const ECacheLevel servedBy) noexcept
+    {
+        switch(servedBy)
+        {
+            case ECacheLevel::L0: return 0;
+            case ECacheLevel::L2: return L2_LATENCY;
+            case ECacheLevel::Memory:
+            default: return MEMORY_LATENCY;
+        }
+    }
+
+    // The cycle the outstanding miss on a line completes on, 0 if there isn't one.
+    [[nodiscard]] u64 Lookup(const u64 lineAddress, const bool external, const u64 cycle) noexcept
+    {
+        Retire(cycle);
+
+        for(u32 validMask = m_ValidMask; validMask != 0; validMask &= validMask - 1)
+        {
+            const Entry& entry = m_Entries[_tzcnt_u32(validMask)];
+
+            if(entry.LineAddress == lineAddress && entry.External == external)
+            {
+                return entry.ReadyCycle;
+            }
+        }
+
+        return 0;
+    }
+
+    // Lookup for a demand access, which then waits on the outstanding miss.
+    [[nodiscard]] u64 Merge(const u64 lineAddress, const bool external, const u64 cycle) noexcept
+    {
+        const u64 readyCycle = Lookup(lineAddress, external, cycle);
+
+        if(readyCycle != 0)
+        {
+            ++m_Statistics.SecondaryMisses;
+        }
+
+        return readyCycle;
+    }
+
+    [[nodiscard]] bool IsFull(const u64 cycle) noexcept
+    {
+        Retire(cycle);
+
+        return m_ValidMask == FULL_MASK;
+    }
+
+    // The first cycle an entry will be free again, only meaningful while full.
+    [[nodiscard]] u64 EarliestReadyCycle() noexcept
+    {
+        u64 earliest = ~0ull;
+
+        for(u32 validMask = m_ValidMask; validMask != 0; validMask &= validMask - 1)
+        {
+            const u64 readyCycle = m_Entries[_tzcnt_u32(validMask)].ReadyCycle;
+
+            if(readyCycle < earliest)
+            {
+                earliest = readyCycle;
+            }
+        }
+
+        ++m_Statistics.FullStalls;
+        return earliest;
+    }
+
+    // The caller must have checked IsFull.
+    void Allocate(const u64 lineAddress, const bool external, const u64 readyCycle) noexcept
+    {
+        const u32 entryIndex = _tzcnt_u32(~m_ValidMask);
+
+        m_Entries[entryIndex].LineAddress = lineAddress;
+        m_Entries[entryIndex].ReadyCycle = readyCycle;
+        m_Entries[entryIndex].External = external;
+        m_ValidMask |= 1u << entryIndex;
+
+        ++m_Statistics.PrimaryMisses;
+    }
+
+    [[nodiscard]] u32 FreeCount(const u64 cycle) noexcept
+    {
+        Retire(cycle);
+
+        return EntryCount - OutstandingCount();
+    }
+
+    [[nodiscard]] u32 OutstandingCount() const noexcept { return static_cast<u32>(_mm_popcnt_u32(m_ValidMask)); }
+    [[nodiscard]] const MshrStatistics& Statistics() const noexcept { return m_Statistics; }
+private:
+    struct Entry final
+    {
+        u64 LineAddress;
+        u64 ReadyCycle;
+        bool External;
+    };
+
+    void Retire(const u64 cycle) noexcept
+    {
+        for(u32 validMask = m_ValidMask; validMask != 0; validMask &= validMask - 1)
+        {
+            const u32 entryIndex = _tzcnt_u32(validMask);
+
+            if(m_Entries[entryIndex].ReadyCycle <= cycle)
+            {
+                m_ValidMask &= ~(1u << entryIndex);
+            }
+        }
+    }
+private:
+    Entry m_Entries[EntryCount];
+    u32 m_ValidMask;
+    MshrStatistics m_Statistics;
+};
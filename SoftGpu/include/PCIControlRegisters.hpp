@@ -3,7 +3,10 @@
 #include <NumTypes.hpp>
 #include <Objects.hpp>
 
+#include <cstring>
+
 #include "DisplayManager.hpp"
+#include "GpuTopology.hpp"
 
 class Processor;
 
@@ -94,6 +97,17 @@ public:
     static inline constexpr u16 BASE_REGISTER_EDID              = 0x3000;
     static inline constexpr u16 SIZE_EDID                       = 128;
 
+    // One block per SM. 64 bit values are split in two, writing the high half commits the operation.
+    static inline constexpr u16 BASE_REGISTER_MMU               = 0x4000;
+    static inline constexpr u16 SIZE_REGISTER_MMU               = 7 * 0x4;
+    static inline constexpr u16 OFFSET_REGISTER_MMU_PAGE_DIRECTORY_LOW   = 0x00;
+    static inline constexpr u16 OFFSET_REGISTER_MMU_PAGE_DIRECTORY_HIGH  = 0x04; // Loads the page directory tagged with the ASID register.
+    static inline constexpr u16 OFFSET_REGISTER_MMU_ASID                 = 0x08;
+    static inline constexpr u16 OFFSET_REGISTER_MMU_INVALIDATE_ASID      = 0x0C; // Drops every translation tagged with the written ASID.
+    static inline constexpr u16 OFFSET_REGISTER_MMU_INVALIDATE_PAGE_LOW  = 0x10;
+    static inline constexpr u16 OFFSET_REGISTER_MMU_INVALIDATE_PAGE_HIGH = 0x14; // Drops the translation of the page in the ASID register's address space.
+    static inline constexpr u16 OFFSET_REGISTER_MMU_ACTIVE_ASID          = 0x18; // Read only, the ASID of the loaded page directory.
+
     static inline constexpr u16 REGISTER_DEBUG_PRINT            = 0x8000;
 
     static inline constexpr u32 CONTROL_REGISTER_VALID_MASK     = 0x00000001;
@@ -113,6 +127,7 @@ public:
         , m_Pad0(0)
         , m_DisplayEdidStorage()
         , m_DisplayDataStorage()
+        , m_MmuRegisters { }
         , m_DebugReadCallback(nullptr)
         , m_DebugWriteCallback(nullptr)
     {
@@ -134,6 +149,8 @@ public:
         m_Bus.WriteValue = 0;
 
         m_ReadState = 0;
+
+        (void) ::std::memset(m_MmuRegisters, 0, sizeof(m_MmuRegisters));
     }
 
     void Clock(bool risingEdge = false)
@@ -155,6 +172,11 @@ public:
         m_CurrentInterruptMessage = messageType;
     }
 
+    [[nodiscard]] bool HasPendingWork() const noexcept
+    {
+        return m_Bus.ReadBusLocked != 0 || m_Bus.WriteBusLocked != 0;
+    }
+
     // [[nodiscard]] u32 Read(u32 address) noexcept;
     //
     // void Write(u32 address, u32 value) noexcept;
@@ -167,6 +189,7 @@ public:
 private:
     void ExecuteRead() noexcept;
     void ExecuteWrite() noexcept;
+    void ExecuteMmuWrite(u32 smIndex, u32 registerOffset) noexcept;
 private:
     Processor* m_Processor;
     ControlRegister m_ControlRegister;
@@ -180,6 +203,7 @@ private:
     u32 m_Pad0 : 28;
     EdidBlock m_DisplayEdidStorage;
     u32 m_DisplayDataStorage;
+    u32 m_MmuRegisters[Topology.SmCount][SIZE_REGISTER_MMU / sizeof(u32)];
 
     PciControlDebugReadCallback_f m_DebugReadCallback;
     PciControlDebugWriteCallback_f m_DebugWriteCallback;
@@ -7,6 +7,7 @@
 
 #include <cstring>
 #include <mutex>
+#include <atomic>
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 
@@ -488,6 +489,12 @@ public:
                     break;
                 }
                 m_MessageSignalledInterruptCapability.MessageControl.Packed = (value & MESSAGE_CONTROL_REGISTER_MASK_BITS) | MESSAGE_CONTROL_REGISTER_READ_ONLY_BITS;
+
+                // An interrupt latched while MSI was disabled becomes pending work, so wake a parked processor to deliver it.
+                if(m_MessageSignalledInterruptCapability.MessageControl.Enabled)
+                {
+                    RingProcessorDoorbell();
+                }
                 break;
             case offsetof(PciController, m_MessageSignalledInterruptCapability) + offsetof(MessageSignalledInterruptCapabilityStructure, MessageAddress):
                 if(size != 4)
@@ -523,21 +530,29 @@ public:
 
     void PciMemReadSet(const u64 address, const u16 size, u32* const data, u16* const readResponse) noexcept
     {
-        ::std::lock_guard lock(m_ReadDataMutex);
-        m_ReadRequestActive = true;
-        m_ReadRequestAddress = address;
-        m_ReadRequestSize = size;
-        m_ReadRequestResponseData = data;
-        m_ReadCountResponse = readResponse;
+        {
+            ::std::lock_guard lock(m_ReadDataMutex);
+            m_ReadRequestActive = true;
+            m_ReadRequestAddress = address;
+            m_ReadRequestSize = size;
+            m_ReadRequestResponseData = data;
+            m_ReadCountResponse = readResponse;
+        }
+
+        RingProcessorDoorbell();
     }
 
     void PciMemWriteSet(const u64 address, const u16 size, const u32* const data) noexcept
     {
-        ::std::lock_guard lock(m_WriteDataMutex);
-        m_WriteRequestActive = true;
-        m_WriteRequestAddress = address;
-        m_WriteRequestSize = size;
-        m_WriteRequestData = data;
+        {
+            ::std::lock_guard lock(m_WriteDataMutex);
+            m_WriteRequestActive = true;
+            m_WriteRequestAddress = address;
+            m_WriteRequestSize = size;
+            m_WriteRequestData = data;
+        }
+
+        RingProcessorDoorbell();
     }
 
     void SetInterrupt(const u32 messageType) noexcept
@@ -547,6 +562,12 @@ public:
         m_InterruptSet = true;
     }
 
+    // Whether Clock has anything to do, safe to call while the device thread is posting requests.
+    [[nodiscard]] bool HasPendingWork() const noexcept
+    {
+        return m_ReadRequestActive || m_WriteRequestActive || (m_InterruptSet && m_MessageSignalledInterruptCapability.MessageControl.Enabled);
+    }
+
     [[nodiscard]] u8 GetBARFromAddress(const u64 address) noexcept
     {
         if(address < 0xFFFFFFFF)
@@ -816,6 +837,8 @@ private:
     void ExecuteMemRead() noexcept;
     void ExecuteMemWrite() noexcept;
 
+    void RingProcessorDoorbell() noexcept;
+
     void ExecuteInterrupt() noexcept
     {
         if(!m_MessageSignalledInterruptCapability.MessageControl.Enabled)
@@ -849,12 +872,13 @@ private:
     u8 m_PciExtendedConfig[4096 - 256 - sizeof(m_AdvancedErrorReportingCapability)];
 
     HANDLE m_SimulationSyncEvent;
-    bool m_ReadRequestActive;
+    // These are set by the device thread, they're atomic so they can be polled without taking the locks.
+    ::std::atomic_bool m_ReadRequestActive;
     u64 m_ReadRequestAddress;
     u16 m_ReadRequestSize;
     u32* m_ReadRequestResponseData;
     u16* m_ReadCountResponse;
-    bool m_WriteRequestActive;
+    ::std::atomic_bool m_WriteRequestActive;
     u64 m_WriteRequestAddress;
     u16 m_WriteRequestSize;
     const u32* m_WriteRequestData;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include "MMU.hpp"
+
+// Must return zeroed, GpuPageSize aligned memory of GpuPageTableSize bytes, or nullptr.
+typedef PageEntry* (*PageTableAllocateCallback_f)(void* userData);
+
+/**
+ * \brief Builds GPU page tables in host memory.
+ *
+ *   Every span of (1 << GpuLargePageShift) pages that is fully covered
+ * by a mapping, and starts on a directory entry boundary, is mapped
+ * with a single large page directory entry. Anything else is mapped
+ * with page table entries, page tables are allocated through the
+ * callback as they are needed. Within a page table every fully covered
+ * aligned run of (1 << GpuMediumPageShift) pages is mapped as a medium
+ * page, so allocations of a few tens of MiB and up already get the
+ * larger TLB reach.
+ *
+ *   A large page is never mapped over an existing page table, the
+ * table is filled with medium pages instead. Mapping part of a medium
+ * page demotes the rest of its run to regular pages.
+ *
+ *   Pages are in units of GpuPageSize on both sides, a host pointer is
+ * converted with `reinterpret_cast<u64>(ptr) / GpuPageSize`.
+ */
+class PageTableBuilder final
+{
+    DEFAULT_DESTRUCT(PageTableBuilder);
+    DELETE_CM(PageTableBuilder);
+public:
+    PageTableBuilder(PageEntry* const pageDirectory, const PageTableAllocateCallback_f allocatePageTable, void* const userData) noexcept
+        : m_PageDirectory(pageDirectory)
+        , m_AllocatePageTable(allocatePageTable)
+        , m_UserData(userData)
+    { }
+
+    /**
+     * \brief Maps pageCount pages starting at virtualPage to physicalPage.
+     *
+     * \param flags The ReadWrite, Execute, WriteThrough, CacheDisable and
+     *   External bits of every entry, everything else is ignored.
+     * \return false if a page table could not be allocated, or if part of
+     *   the range needs a page table where a large page is already mapped.
+     */
+    [[nodiscard]] bool Map(u64 virtualPage, u64 physicalPage, u64 pageCount, PageEntry flags) noexcept;
+
+    [[nodiscard]] PageEntry* PageDirectory() const noexcept { return m_PageDirectory; }
+private:
+    [[nodiscard]] PageEntry* GetPageTable(u64 pageDirectoryIndex) noexcept;
+
+    // Fills part of a single page table, using medium pages where possible.
+    static void FillPageTable(PageEntry* pageTable, u64 pageTableIndex, u64 physicalPage, u64 pageCount, PageEntry flags) noexcept;
+private:
+    PageEntry* m_PageDirectory;
+    PageTableAllocateCallback_f m_AllocatePageTable;
+    void* m_UserData;
+};
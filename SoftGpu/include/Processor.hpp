@@ -9,33 +9,57 @@
 #include "PCIController.hpp"
 #include "RomController.hpp"
 #include "DisplayManager.hpp"
+#include "SmWorkerPool.hpp"
+#include "GpuTopology.hpp"
+
+#include <utility>
 
 class Processor final
 {
     DEFAULT_DESTRUCT(Processor);
     DELETE_CM(Processor);
+public:
+    // Consecutive quiescent cycles before the processor thread parks, this keeps wake up latency low for bursts of requests.
+    static inline constexpr u64 PARK_AFTER_QUIESCENT_CYCLES = 4096;
+    // Cycles per ClockN call for a free running processor thread, the debugger is only polled this often.
+    static inline constexpr u64 CLOCK_BATCH_CYCLES = 1024;
+    // Words staged at a time for unaligned host accesses.
+    static inline constexpr u64 HOST_ACCESS_WORD_COUNT = 16;
 public:
     Processor() noexcept
+        : Processor(::std::make_index_sequence<Topology.SmCount>())
+    { }
+private:
+    // Expands an initializer for every SM in the topology.
+    template<uSys... SmIndices>
+    Processor(::std::index_sequence<SmIndices...>) noexcept
         : m_PciController(this)
         , m_RomController(this)
         , m_PciRegisters(this)
         , m_CacheController(this)
-        , m_SMs { { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 } }
+        , m_SMs { { this, SmIndices }... }
         , m_DisplayManager(this)
         , m_ClockCycle(0)
+        , m_BreakpointCycle(0)
+        , m_QuiescentCycles(0)
         , m_RamBaseAddress(0)
+        , m_Doorbell(0)
+        , m_Parked(false)
+        , m_ParkCount(0)
+        , m_SmWorkers(this)
     { }
-
+public:
     void Reset()
     {
         m_PciRegisters.Reset();
         m_CacheController.Reset();
-        m_SMs[0].Reset();
-        m_SMs[1].Reset();
-        m_SMs[2].Reset();
-        m_SMs[3].Reset();
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            m_SMs[i].Reset();
+        }
         m_DisplayManager.Reset();
         m_ClockCycle = 0;
+        m_QuiescentCycles = 0;
     }
 
     void Clock() noexcept
@@ -43,66 +67,238 @@ public:
         ++m_ClockCycle;
         if(GlobalDebug.IsAttached())
         {
-            GlobalDebug.WriteInfo(DebugCodeReportTiming, &m_ClockCycle, sizeof(m_ClockCycle));
+            PollDebugger();
+            ClockCycle<true>();
+            return;
+        }
 
-            if(!GlobalDebug.Stepping() && !GlobalDebug.DisableStepping())
-            {
-                GlobalDebug.WriteStepping(DebugCodeCheckForPause);
+        if(IsQuiescent())
+        {
+            // Every event that can wake us comes from outside, so an idle cycle only has to count itself.
+            ++m_QuiescentCycles;
+            return;
+        }
 
-                const u32 dataCode = GlobalDebug.ReadStepping<u32>();
-                const u32 dataSize = GlobalDebug.ReadStepping<u32>();
+        ClockCycle<false>();
+    }
 
-                (void) dataSize;
+    /**
+     * \brief Clocks the processor for a batch of cycles.
+     *
+     *   The debugger is only polled, and sent the timing and register
+     * reports, on the last cycle of the batch, every other cycle runs
+     * without any hooks. While the debugger is stepping this clocks a
+     * single cycle. A batch is cut short at a cycle breakpoint, which
+     * then puts an attached debugger into stepping.
+     *
+     *   Once the processor is quiescent nothing inside it can change
+     * until an external event arrives, so the rest of the batch is
+     * skipped immediately.
+     *
+     * \return The number of cycles clocked, less than cycleCount if a breakpoint was hit or the debugger is stepping.
+     */
+    u64 ClockN(const u64 cycleCount) noexcept
+    {
+        if(cycleCount == 0)
+        {
+            return 0;
+        }
 
-                if(dataCode == DebugCodePause)
-                {
-                    GlobalDebug.Stepping() = true;
-                }
+        u64 batchCount = cycleCount;
+        bool hitBreakpoint = false;
+
+        // A breakpoint that has already been clocked past must not wrap around into a huge batch.
+        if(m_BreakpointCycle != 0 && m_BreakpointCycle > m_ClockCycle)
+        {
+            // The breakpoint cycle is the last one clocked by the batch.
+            const u64 cyclesToBreakpoint = static_cast<u64>(m_BreakpointCycle) - static_cast<u64>(m_ClockCycle);
+            if(cyclesToBreakpoint <= batchCount)
+            {
+                batchCount = cyclesToBreakpoint;
+                hitBreakpoint = true;
             }
+        }
 
+        if(GlobalDebug.IsAttached())
+        {
             if(GlobalDebug.Stepping())
             {
-                ConPrinter::Print("Waiting for Step.\n");
-                GlobalDebug.WriteStepping(DebugCodeReportStepReady);
+                Clock();
+                batchCount = 1;
+            }
+            else
+            {
+                for(u64 i = 1; i < batchCount; ++i)
+                {
+                    ClockUnhooked();
+                }
+
+                Clock();
+            }
+        }
+        else
+        {
+            for(u64 i = 0; i < batchCount; ++i)
+            {
+                ++m_ClockCycle;
 
-                while(true)
+                if(IsQuiescent())
                 {
-                    const u32 dataCode = GlobalDebug.ReadStepping<u32>();
-                    const u32 dataSize = GlobalDebug.ReadStepping<u32>();
-
-                    (void) dataSize;
-
-                    if(dataCode == DebugCodeStep)
-                    {
-                        ConPrinter::Print("Step Received.\n");
-                        break;
-                    }
-                    else if(dataCode == DebugCodeResume)
-                    {
-                        ConPrinter::Print("Resume Received.\n");
-                        GlobalDebug.Stepping() = false;
-                        break;
-                    }
+                    const u64 skippedCycles = batchCount - i;
+                    m_ClockCycle += static_cast<u32>(skippedCycles - 1);
+                    m_QuiescentCycles += skippedCycles;
+                    break;
                 }
+
+                ClockCycle<false>();
             }
         }
 
-        m_PciController.Clock(true);
-        m_PciRegisters.Clock(true);
-        m_DisplayManager.Clock(true);
+        if(hitBreakpoint && m_ClockCycle == m_BreakpointCycle)
+        {
+            m_BreakpointCycle = 0;
 
-        m_SMs[0].Clock();
-        m_SMs[1].Clock();
-        m_SMs[2].Clock();
-        m_SMs[3].Clock();
+            if(GlobalDebug.IsAttached() && !GlobalDebug.DisableStepping())
+            {
+                GlobalDebug.Stepping() = true;
+            }
+        }
 
-        m_PciController.Clock(false);
-        m_PciRegisters.Clock(false);
-        m_DisplayManager.Clock(false);
+        return batchCount;
+    }
+
+    // Stops the next ClockN batch after the given cycle has been clocked, 0 clears the breakpoint.
+    void SetCycleBreakpoint(const u32 cycle) noexcept
+    {
+        m_BreakpointCycle = cycle;
+    }
+
+    [[nodiscard]] u32 CycleBreakpoint() const noexcept { return m_BreakpointCycle; }
+
+    /**
+     * \brief Whether a clock would do nothing but advance the cycle counter.
+     *
+     *   This is true when every dispatch unit is halted or unloaded, no
+     * execution unit has work in flight, no write-combining buffer holds
+     * stores, and there is no pending PCI request, interrupt, control
+     * register access or display event.
+     */
+    [[nodiscard]] bool IsQuiescent() const noexcept
+    {
+        if(m_PciController.HasPendingWork() || m_PciRegisters.HasPendingWork() || m_DisplayManager.HasPendingWork())
+        {
+            return false;
+        }
+
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            if(!m_SMs[i].IsIdle())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] u32 ClockCycle() const noexcept { return m_ClockCycle; }
+
+    // Wakes the thread driving Clock, called by anything outside of it that hands the processor new work.
+    void RingDoorbell() noexcept
+    {
+        (void) m_Doorbell.fetch_add(1);
+        m_Doorbell.notify_one();
+    }
+
+    /**
+     * \brief Blocks the thread driving Clock until the doorbell rings.
+     *
+     *   This only parks once the processor has been quiescent for
+     * PARK_AFTER_QUIESCENT_CYCLES cycles, and never while a debugger is
+     * attached.
+     *
+     * \return Whether the thread was parked.
+     */
+    bool WaitForWork() noexcept
+    {
+        if(m_QuiescentCycles < PARK_AFTER_QUIESCENT_CYCLES || GlobalDebug.IsAttached())
+        {
+            return false;
+        }
+
+        const u32 doorbell = m_Doorbell.load();
+
+        // Requests are posted before the doorbell is rung, so anything that lands after this check changes the doorbell.
+        if(!IsQuiescent())
+        {
+            return false;
+        }
+
+        m_Parked.store(true);
+        (void) m_ParkCount.fetch_add(1, ::std::memory_order_relaxed);
+        m_Doorbell.wait(doorbell);
+        m_Parked.store(false);
+        return true;
+    }
+
+    // Whether the thread driving Clock is blocked in WaitForWork, safe to call from any thread.
+    [[nodiscard]] bool IsParked() const noexcept { return m_Parked.load(); }
+    // How many times the thread driving Clock has parked, safe to call from any thread.
+    [[nodiscard]] u32 ParkCount() const noexcept { return m_ParkCount.load(::std::memory_order_relaxed); }
+
+    // Must be called from the thread driving Clock, or while the processor is not being clocked.
+    void SetThreadedClock(const bool threaded) noexcept
+    {
+        if(threaded)
+        {
+            m_SmWorkers.Start();
+        }
+        else
+        {
+            m_SmWorkers.Stop();
+        }
+    }
+
+    [[nodiscard]] bool ThreadedClock() const noexcept { return m_SmWorkers.IsRunning(); }
+
+    void SetExecutionMode(const EExecutionMode executionMode) noexcept
+    {
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            m_SMs[i].SetExecutionMode(executionMode);
+        }
+    }
+
+    [[nodiscard]] EExecutionMode ExecutionMode() const noexcept { return m_SMs[0].ExecutionMode(); }
+
+    void SetBlockInterpreter(const bool blockInterpreter) noexcept
+    {
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            m_SMs[i].SetBlockInterpreter(blockInterpreter);
+        }
+    }
+
+    [[nodiscard]] bool BlockInterpreter() const noexcept { return m_SMs[0].BlockInterpreter(); }
+
+    // Intended only for SmWorkerPool.
+    void ClockSM(const u32 smIndex) noexcept
+    {
+        m_SMs[smIndex].Clock();
+    }
+
+    // Called by an SM before it first touches the caches or physical memory in a cycle.
+    void WaitForSharedMemory(const u32 smIndex) const noexcept
+    {
+        if(m_SmWorkers.InParallelPhase())
+        {
+            m_SmWorkers.WaitForSharedMemory(smIndex);
+        }
     }
 
     void TestLoadProgram(const u32 sm, const u32 dispatchPort, const u8 replicationMask, const u64 program)
     {
+        assert(sm < Topology.SmCount);
         m_SMs[sm].TestLoadProgram(dispatchPort, replicationMask, program);
     }
 
@@ -113,9 +309,35 @@ public:
 
     void TestLoadRegister(const u32 sm, const u32 dispatchPort, const u32 replicationIndex, const u8 registerIndex, const u32 registerValue)
     {
+        assert(sm < Topology.SmCount);
         m_SMs[sm].TestLoadRegister(dispatchPort, replicationIndex, registerIndex, registerValue);
     }
 
+    // A store made by the SM, it goes through the SM's MMU and write-combining buffer.
+    void TestWrite(const u32 sm, const u64 address, const u32 value) noexcept
+    {
+        assert(sm < Topology.SmCount);
+        m_SMs[sm].Write(address, value);
+    }
+
+    [[nodiscard]] Mmu& TestMmu(const u32 sm) noexcept
+    {
+        assert(sm < Topology.SmCount);
+        return m_SMs[sm].TestMmu();
+    }
+
+    [[nodiscard]] u32 TestDecodeEpoch(const u32 sm) const noexcept
+    {
+        assert(sm < Topology.SmCount);
+        return m_SMs[sm].DecodeEpoch();
+    }
+
+    [[nodiscard]] u32 TestReadRegister(const u32 sm, const u32 registerIndex) const noexcept
+    {
+        assert(sm < Topology.SmCount);
+        return m_SMs[sm].GetRegister(registerIndex);
+    }
+
     void TestSetRamBaseAddress(const u64 ramBaseAddress, const u64 size) noexcept
     {
         m_RamBaseAddress = ramBaseAddress;
@@ -142,6 +364,119 @@ public:
         (void) ::std::memcpy(reinterpret_cast<void*>(addressX86), &value, sizeof(u32));
     }
 
+    // Reads wordCount contiguous words in one copy, for whole cache lines.
+    void MemReadPhyBlock(const u64 address, u32* const data, const uSys wordCount, const bool external = false) noexcept
+    {
+        (void) external;
+
+        const uintptr_t addressX86 = address << 2;
+        (void) ::std::memcpy(data, reinterpret_cast<const void*>(addressX86), wordCount * sizeof(u32));
+    }
+
+    void MemWritePhyBlock(const u64 address, const u32* const data, const uSys wordCount, const bool external = false) noexcept
+    {
+        (void) external;
+
+        const uintptr_t addressX86 = address << 2;
+        (void) ::std::memcpy(reinterpret_cast<void*>(addressX86), data, wordCount * sizeof(u32));
+    }
+
+    /**
+     * \brief Host reads and writes of GPU memory, kept coherent with the caches.
+     *
+     *   Addresses and sizes are in bytes and needn't be word aligned, the
+     * bytes around a partial word are read back and written unchanged.
+     * These snoop the caches and drain the uncached stores the SMs still
+     * hold in their write-combining buffers, so they may only be called
+     * from the thread driving Clock, the PCI controller makes them for
+     * BAR1 requests.
+     */
+    void HostMemRead(const u64 address, void* const data, const u64 size) noexcept
+    {
+        DrainWriteCombiningRange(address, size);
+
+        if(((address | size) & 0x3) == 0)
+        {
+            m_CacheController.HostRead(address >> 2, static_cast<u32*>(data), size >> 2, false);
+            return;
+        }
+
+        u32 words[HOST_ACCESS_WORD_COUNT];
+
+        for(u64 offset = 0; offset < size;)
+        {
+            const u64 byteAddress = address + offset;
+            const u64 byteOffset = byteAddress & 0x3;
+            const u64 byteCount = size - offset < sizeof(words) - byteOffset ? size - offset : sizeof(words) - byteOffset;
+
+            m_CacheController.HostRead(byteAddress >> 2, words, (byteOffset + byteCount + 3) >> 2, false);
+            (void) ::std::memcpy(static_cast<u8*>(data) + offset, reinterpret_cast<const u8*>(words) + byteOffset, byteCount);
+
+            offset += byteCount;
+        }
+    }
+
+    void HostMemWrite(const u64 address, const void* const data, const u64 size) noexcept
+    {
+        // Stores the SMs made before this write must not land on top of it.
+        DrainWriteCombiningRange(address, size);
+
+        if(((address | size) & 0x3) == 0)
+        {
+            m_CacheController.HostWrite(address >> 2, static_cast<const u32*>(data), size >> 2, false);
+            return;
+        }
+
+        u32 words[HOST_ACCESS_WORD_COUNT];
+
+        for(u64 offset = 0; offset < size;)
+        {
+            const u64 byteAddress = address + offset;
+            const u64 byteOffset = byteAddress & 0x3;
+            const u64 byteCount = size - offset < sizeof(words) - byteOffset ? size - offset : sizeof(words) - byteOffset;
+            const u64 wordCount = (byteOffset + byteCount + 3) >> 2;
+
+            m_CacheController.HostRead(byteAddress >> 2, words, wordCount, false);
+            (void) ::std::memcpy(reinterpret_cast<u8*>(words) + byteOffset, static_cast<const u8*>(data) + offset, byteCount);
+            m_CacheController.HostWrite(byteAddress >> 2, words, wordCount, false);
+
+            offset += byteCount;
+        }
+    }
+
+    // May be called from any thread. False means no cache holds any of the range, so the host may copy it directly.
+    [[nodiscard]] bool HostRangeMayBeCached(const u64 address, const u64 size) const noexcept
+    {
+        if(size == 0)
+        {
+            return false;
+        }
+
+        // Uncached stores sitting in a write-combining buffer have to be drained by the processor thread.
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            if(m_SMs[i].HasPendingWrites())
+            {
+                return true;
+            }
+        }
+
+        const u64 firstWord = address >> 2;
+        return m_CacheController.HostRangeMayBeCached(firstWord, ((address + size - 1) >> 2) - firstWord + 1);
+    }
+
+    // Drains the uncached stores to the line from every other SM's write-combining buffer, address is in words.
+    void DrainWriteCombiningLine(const u32 smIndex, const u64 address, const bool external) noexcept
+    {
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            if(i != smIndex)
+            {
+                m_SMs[i].DrainUncachedWrites(address, external);
+            }
+        }
+    }
+
     [[nodiscard]] u32 PciConfigRead(const u16 address, const u8 size) noexcept
     {
         return m_PciController.ConfigRead(address, size);
@@ -273,17 +608,22 @@ public:
         m_PciRegisters.SetInterrupt(messageType);
     }
 
-    [[nodiscard]] u32 Read(const u32 coreIndex, const u64 address, const bool cacheDisable = false, const bool external = false) noexcept
+    [[nodiscard]] u32 Read(const u32 coreIndex, const u64 address, const bool cacheDisable = false, const bool external = false, ECacheLevel* const servedBy = nullptr, const ECacheHint hint = ECacheHint::Normal) noexcept
     {
         if(cacheDisable)
         {
+            if(servedBy)
+            {
+                *servedBy = ECacheLevel::Memory;
+            }
+
             return MemReadPhy(address, external);
         }
 
-        return m_CacheController.Read(coreIndex, address, external);
+        return m_CacheController.Read(coreIndex, address, external, servedBy, hint);
     }
 
-    void Write(const u32 coreIndex, const u64 address, const u32 value, const bool writeThrough = false, const bool cacheDisable = false, const bool external = false) noexcept
+    void Write(const u32 coreIndex, const u64 address, const u32 value, const bool writeThrough = false, const bool cacheDisable = false, const bool external = false, const ECacheHint hint = ECacheHint::Normal) noexcept
     {
         if(cacheDisable)
         {
@@ -291,12 +631,18 @@ public:
             return;
         }
 
-        m_CacheController.Write(coreIndex, address, value, external, writeThrough);
+        m_CacheController.Write(coreIndex, address, value, external, writeThrough, hint);
+    }
+
+    void Prefetch(const u32 coreIndex, const u64 address, const bool external = false, ECacheLevel* const servedBy = nullptr) noexcept
+    {
+        m_CacheController.Prefetch(coreIndex, address, external, servedBy);
     }
 
-    void Prefetch(const u32 coreIndex, const u64 address, const bool external = false) noexcept
+    // Whether the core's L0 holds the line, nothing is fetched.
+    [[nodiscard]] bool CacheContains(const u32 coreIndex, const u64 address, const bool external = false) const noexcept
     {
-        m_CacheController.Prefetch(coreIndex, address, external);
+        return m_CacheController.Contains(coreIndex, address, external);
     }
 
     void FlushCache(const u32 coreIndex) noexcept
@@ -304,14 +650,85 @@ public:
         m_CacheController.Flush(coreIndex);
     }
 
-    void LoadPageDirectoryPointer(const u64 coreIndex, const u64 pageDirectoryPhysicalAddress) noexcept
+    // Writes back the core's cached copies of a range of words, they stay cached.
+    void FlushCacheRange(const u32 coreIndex, const u64 address, const u64 wordCount, const bool external = false) noexcept
+    {
+        m_CacheController.FlushRange(coreIndex, address, wordCount, external);
+    }
+
+    // Writes back the line from whichever core holds it dirty, it stays cached.
+    void FlushSharedCacheLine(const u64 address, const bool external = false) noexcept
+    {
+        m_CacheController.FlushSharedLine(address, external);
+    }
+
+    // Writes back and drops every cached copy of a range of words, so the next reads see memory.
+    void InvalidateCacheRange(const u32 coreIndex, const u64 address, const u64 wordCount, const bool external = false) noexcept
+    {
+        m_CacheController.InvalidateRange(coreIndex, address, wordCount, external);
+    }
+
+    [[nodiscard]] CacheStatistics L2CacheStatistics() const noexcept
+    {
+        return m_CacheController.GetL2Cache().Statistics();
+    }
+
+    // The cores whose L0 the L2 snoops for the line.
+    [[nodiscard]] u32 L2Sharers(const u64 address, const bool external = false) const noexcept
+    {
+        return m_CacheController.GetL2Cache().Sharers(address, external);
+    }
+
+    // Hardware prefetches are tracked by the core's MSHRs, see StreamingMultiprocessor::CanTrackPrefetch.
+    [[nodiscard]] bool CanTrackL0Prefetch(const u32 coreIndex) noexcept
+    {
+        return m_SMs[coreIndex].CanTrackPrefetch();
+    }
+
+    void TrackL0Prefetch(const u32 coreIndex, const u64 address, const bool external, const ECacheLevel servedBy) noexcept
     {
-        m_SMs[coreIndex].LoadPageDirectoryPointer(pageDirectoryPhysicalAddress);
+        m_SMs[coreIndex].TrackPrefetch(address, external, servedBy);
     }
 
-    void LoadPageDirectoryPointer(const u64 coreIndex, const void* const pageDirectoryPhysicalAddress) noexcept
+    [[nodiscard]] const PrefetcherStatistics& L0PrefetcherStatistics(const u32 coreIndex) const noexcept
     {
-        LoadPageDirectoryPointer(coreIndex, reinterpret_cast<u64>(pageDirectoryPhysicalAddress) >> 16);
+        return m_CacheController.GetPrefetcher(coreIndex).Statistics();
+    }
+
+    [[nodiscard]] const MshrStatistics& L0MshrStatistics(const u32 coreIndex) const noexcept
+    {
+        return m_SMs[coreIndex].L0MshrStatistics();
+    }
+
+    [[nodiscard]] const WriteCombiningStatistics& WriteCombinerStatistics(const u32 coreIndex) const noexcept
+    {
+        return m_SMs[coreIndex].WriteCombinerStatistics();
+    }
+
+    // ASID 0 is untagged, see Mmu.
+    void LoadPageDirectoryPointer(const u64 coreIndex, const u64 pageDirectoryPhysicalAddress, const u16 asid = 0) noexcept
+    {
+        m_SMs[coreIndex].LoadPageDirectoryPointer(pageDirectoryPhysicalAddress, asid);
+    }
+
+    void LoadPageDirectoryPointer(const u64 coreIndex, const void* const pageDirectoryPhysicalAddress, const u16 asid = 0) noexcept
+    {
+        LoadPageDirectoryPointer(coreIndex, reinterpret_cast<u64>(pageDirectoryPhysicalAddress) >> 16, asid);
+    }
+
+    [[nodiscard]] u16 Asid(const u64 coreIndex) const noexcept
+    {
+        return m_SMs[coreIndex].Asid();
+    }
+
+    void InvalidateMmuAsid(const u64 coreIndex, const u16 asid) noexcept
+    {
+        m_SMs[coreIndex].InvalidateMmuAsid(asid);
+    }
+
+    void InvalidateMmuPage(const u64 coreIndex, const u64 virtualAddress, const u16 asid) noexcept
+    {
+        m_SMs[coreIndex].InvalidateMmuPage(virtualAddress, asid);
     }
 
     void FlushMmuCache(const u64 coreIndex) noexcept
@@ -329,6 +746,62 @@ public:
         m_DisplayManager.ResetBus();
     }
 
+    // Only called between cycles, address and size are in bytes.
+    void DrainWriteCombiningRange(const u64 address, const u64 size) noexcept
+    {
+        bool hasPendingWrites = false;
+
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            hasPendingWrites |= m_SMs[i].HasPendingWrites();
+        }
+
+        if(!hasPendingWrites || size == 0)
+        {
+            return;
+        }
+
+        // Lines are 8 words.
+        const u64 lastWord = (address + size - 1) >> 2;
+
+        for(u64 word = address >> 2; word <= lastWord; word = (word | 0x7) + 1)
+        {
+            for(u32 i = 0; i < Topology.SmCount; ++i)
+            {
+                m_SMs[i].DrainUncachedWrites(word, false);
+            }
+        }
+    }
+
+    // Drops any decoded instructions from the physical line in every SM, address is in words. This may be called from any thread.
+    void NotifyCodeWrite(const u64 physicalAddress) noexcept
+    {
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            m_SMs[i].NotifyCodeWrite(physicalAddress);
+        }
+    }
+
+    // Must be called after the host writes to GPU memory, address and size are in bytes. This may be called from any thread.
+    void NotifyHostMemoryWrite(const u64 address, const u64 size) noexcept
+    {
+        if(size == 0)
+        {
+            return;
+        }
+
+        // Pairs with the fetch marking its line before reading it.
+        ::std::atomic_thread_fence(::std::memory_order_seq_cst);
+
+        // Lines are 8 words.
+        const u64 lastWord = (address + size - 1) >> 2;
+
+        for(u64 word = address >> 2; word <= lastWord; word = (word | 0x7) + 1)
+        {
+            NotifyCodeWrite(word);
+        }
+    }
+
     [[nodiscard]] u64 RamBaseAddress() const noexcept { return m_RamBaseAddress; }
     [[nodiscard]] u64 RamSize() const noexcept { return m_RamSize; }
 
@@ -338,14 +811,132 @@ public:
     [[nodiscard]] PciController& GetPciController() noexcept { return m_PciController; }
     [[nodiscard]] PciControlRegisters& GetPciControlRegisters() noexcept { return m_PciRegisters; }
     [[nodiscard]] DisplayManager& GetDisplayManager() noexcept { return m_DisplayManager; }
+private:
+    // Reports the cycle to the debugger, then blocks if it has paused us until it steps or resumes.
+    void PollDebugger() noexcept
+    {
+        GlobalDebug.WriteInfo(DebugCodeReportTiming, &m_ClockCycle, sizeof(m_ClockCycle));
+
+        if(!GlobalDebug.Stepping() && !GlobalDebug.DisableStepping())
+        {
+            GlobalDebug.WriteStepping(DebugCodeCheckForPause);
+
+            const u32 dataCode = GlobalDebug.ReadStepping<u32>();
+            const u32 dataSize = GlobalDebug.ReadStepping<u32>();
+
+            (void) dataSize;
+
+            if(dataCode == DebugCodePause)
+            {
+                GlobalDebug.Stepping() = true;
+            }
+        }
+
+        if(GlobalDebug.Stepping())
+        {
+            ConPrinter::Print("Waiting for Step.\n");
+            GlobalDebug.WriteStepping(DebugCodeReportStepReady);
+
+            while(true)
+            {
+                const u32 dataCode = GlobalDebug.ReadStepping<u32>();
+                const u32 dataSize = GlobalDebug.ReadStepping<u32>();
+
+                (void) dataSize;
+
+                if(dataCode == DebugCodeStep)
+                {
+                    ConPrinter::Print("Step Received.\n");
+                    break;
+                }
+                else if(dataCode == DebugCodeResume)
+                {
+                    ConPrinter::Print("Resume Received.\n");
+                    GlobalDebug.Stepping() = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // A cycle within a batch, the debugger is neither polled nor sent reports.
+    void ClockUnhooked() noexcept
+    {
+        ++m_ClockCycle;
+
+        if(IsQuiescent())
+        {
+            ++m_QuiescentCycles;
+            return;
+        }
+
+        ClockCycle<false>();
+    }
+
+    template<bool ReportToDebugger>
+    void ClockCycle() noexcept
+    {
+        if(m_QuiescentCycles != 0)
+        {
+            for(u32 i = 0; i < Topology.SmCount; ++i)
+            {
+                m_SMs[i].AdvanceIdleCycles(m_QuiescentCycles);
+            }
+            m_QuiescentCycles = 0;
+        }
+
+        m_PciController.Clock(true);
+        m_PciRegisters.Clock(true);
+        m_DisplayManager.Clock(true);
+
+        // Code writes from the last cycle are applied serially so every SM sees them from the same cycle on.
+        for(u32 i = 0; i < Topology.SmCount; ++i)
+        {
+            m_SMs[i].SyncPendingInvalidate();
+        }
+
+        if constexpr(ReportToDebugger)
+        {
+            for(u32 i = 0; i < Topology.SmCount; ++i)
+            {
+                m_SMs[i].ReportToDebugger();
+            }
+        }
+
+        // The debugger expects the SM reports in order, so stay serial while it is attached.
+        if(!ReportToDebugger && m_SmWorkers.IsRunning())
+        {
+            m_SmWorkers.Clock();
+        }
+        else
+        {
+            for(u32 i = 0; i < Topology.SmCount; ++i)
+            {
+                m_SMs[i].Clock();
+            }
+        }
+
+        m_PciController.Clock(false);
+        m_PciRegisters.Clock(false);
+        m_DisplayManager.Clock(false);
+    }
 private:
     PciController m_PciController;
     RomController m_RomController;
     PciControlRegisters m_PciRegisters;
     CacheController m_CacheController;
-    StreamingMultiprocessor m_SMs[4];
+    StreamingMultiprocessor m_SMs[Topology.SmCount];
     DisplayManager m_DisplayManager;
     u32 m_ClockCycle;
+    u32 m_BreakpointCycle;
+    // Cycles skipped while quiescent that the dispatch unit statistics haven't caught up on yet.
+    u64 m_QuiescentCycles;
     u64 m_RamBaseAddress;
     u64 m_RamSize;
+    ::std::atomic<u32> m_Doorbell;
+    // Only written by the thread driving Clock, read by anyone watching it.
+    ::std::atomic_bool m_Parked;
+    ::std::atomic<u32> m_ParkCount;
+    // Declared last so the workers are joined before anything they clock is destroyed.
+    SmWorkerPool m_SmWorkers;
 };
@@ -6,6 +6,8 @@
 #include <ConPrinter.hpp>
 #include "DebugManager.hpp"
 
+#include <immintrin.h>
+
 /**
  * \brief Manages the set of register for a given SM.s
  *
@@ -91,55 +93,131 @@ public:
         (void) ::std::memset(m_RegisterContestationMapBankD, 0, sizeof(m_RegisterContestationMapBank0));
         (void) ::std::memset(m_RegisterContestationMapBankE, 0, sizeof(m_RegisterContestationMapBank0));
         (void) ::std::memset(m_RegisterContestationMapBankF, 0, sizeof(m_RegisterContestationMapBank0));
+
+        // Drop any commands still latched on the ports from before the reset.
+        (void) ::std::memset(&m_Port0High, 0, sizeof(m_Port0High));
+        (void) ::std::memset(&m_Port1High, 0, sizeof(m_Port1High));
+        (void) ::std::memset(&m_Port2High, 0, sizeof(m_Port2High));
+        (void) ::std::memset(&m_Port3High, 0, sizeof(m_Port3High));
+        (void) ::std::memset(&m_Port0Low, 0, sizeof(m_Port0Low));
+        (void) ::std::memset(&m_Port1Low, 0, sizeof(m_Port1Low));
+        (void) ::std::memset(&m_Port2Low, 0, sizeof(m_Port2Low));
+        (void) ::std::memset(&m_Port3Low, 0, sizeof(m_Port3Low));
+        m_ActivePortMask = 0;
     }
 
     // We'll use a pulsed model for handling multiple ports.
     void Clock() noexcept
     {
-        ExecutePacket(m_Port0High, m_Port0Low);
-        ExecutePacket(m_Port1High, m_Port1Low);
-        ExecutePacket(m_Port2High, m_Port2Low);
-        ExecutePacket(m_Port3High, m_Port3Low);
+        // Only visit port pairs where either side holds a command that does something.
+        for(u32 activePorts = (m_ActivePortMask | (m_ActivePortMask >> 4)) & 0xF; activePorts != 0; activePorts &= activePorts - 1)
+        {
+            switch(_tzcnt_u32(activePorts))
+            {
+                case 0: ExecutePacket(m_Port0High, m_Port0Low); break;
+                case 1: ExecutePacket(m_Port1High, m_Port1Low); break;
+                case 2: ExecutePacket(m_Port2High, m_Port2Low); break;
+                case 3: ExecutePacket(m_Port3High, m_Port3Low); break;
+                default: break;
+            }
+        }
     }
 
+    [[nodiscard]] bool HasActivePorts() const noexcept { return m_ActivePortMask != 0; }
+
     void InvokePort0High(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port0High, &packet, sizeof(packet));
+        UpdateActivePort(0, packet.Command);
     }
 
     void InvokePort1High(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port1High, &packet, sizeof(packet));
+        UpdateActivePort(1, packet.Command);
     }
 
     void InvokePort2High(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port2High, &packet, sizeof(packet));
+        UpdateActivePort(2, packet.Command);
     }
 
     void InvokePort3High(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port3High, &packet, sizeof(packet));
+        UpdateActivePort(3, packet.Command);
     }
 
     void InvokePort0Low(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port0Low, &packet, sizeof(packet));
+        UpdateActivePort(4, packet.Command);
     }
 
     void InvokePort1Low(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port1Low, &packet, sizeof(packet));
+        UpdateActivePort(5, packet.Command);
     }
 
     void InvokePort2Low(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port2Low, &packet, sizeof(packet));
+        UpdateActivePort(6, packet.Command);
     }
 
     void InvokePort3Low(const CommandPacket packet) noexcept
     {
         (void) ::std::memcpy(&m_Port3Low, &packet, sizeof(packet));
+        UpdateActivePort(7, packet.Command);
+    }
+
+    // Direct register access, bypassing the ports and the contestation maps.
+    // This has no hardware equivalent, it exists for the functional execution engine.
+    [[nodiscard]] u32 GetRegister(const u32 registerIndex) const noexcept
+    {
+        return GetRegisterBank(registerIndex)[registerIndex >> 4];
+    }
+
+    void SetRegister(const u32 registerIndex, const u32 value) noexcept
+    {
+        GetRegisterBank(registerIndex)[registerIndex >> 4] = value;
+    }
+
+    // Direct contestation access, the dispatch units check and lock registers before handing them to a unit.
+    // The units release their locks through the ports with ECommand::Unlock.
+    [[nodiscard]] bool CanReadRegister(const u32 registerIndex) const noexcept
+    {
+        return GetContestationBank(registerIndex)[registerIndex >> 4] != 1;
+    }
+
+    [[nodiscard]] bool CanWriteRegister(const u32 registerIndex) const noexcept
+    {
+        return GetContestationBank(registerIndex)[registerIndex >> 4] == 0;
+    }
+
+    void LockRegisterRead(const u32 registerIndex) noexcept
+    {
+        u8& contestation = GetContestationBank(registerIndex)[registerIndex >> 4];
+
+        // Read locks start at 2, 1 is the write lock.
+        contestation = contestation == 0 ? 2 : contestation + 1;
+    }
+
+    void LockRegisterWrite(const u32 registerIndex) noexcept
+    {
+        GetContestationBank(registerIndex)[registerIndex >> 4] = 1;
+    }
+
+    void ReleaseRegisterContestation(const u32 registerIndex) noexcept
+    {
+        u8& contestation = GetContestationBank(registerIndex)[registerIndex >> 4];
+
+        assert(contestation != 0);
+
+        // Releasing the last read lock leaves 1, which is the write lock.
+        contestation = contestation <= 2 ? 0 : contestation - 1;
     }
 
     void ReportRegisters(const u32 smIndex) const noexcept
@@ -200,6 +278,64 @@ public:
         }
     }
 private:
+    // The low bit selects the high (odd) or low (even) banks, the next 3 bits select the bank, the rest is the index into the bank.
+    [[nodiscard]] const u32* GetRegisterBank(const u32 registerIndex) const noexcept
+    {
+        switch(((registerIndex >> 1) & 0x7) * 2 + (registerIndex & 0x1))
+        {
+            case 0x0: return m_RegisterBank0;
+            case 0x1: return m_RegisterBank1;
+            case 0x2: return m_RegisterBank2;
+            case 0x3: return m_RegisterBank3;
+            case 0x4: return m_RegisterBank4;
+            case 0x5: return m_RegisterBank5;
+            case 0x6: return m_RegisterBank6;
+            case 0x7: return m_RegisterBank7;
+            case 0x8: return m_RegisterBank8;
+            case 0x9: return m_RegisterBank9;
+            case 0xA: return m_RegisterBankA;
+            case 0xB: return m_RegisterBankB;
+            case 0xC: return m_RegisterBankC;
+            case 0xD: return m_RegisterBankD;
+            case 0xE: return m_RegisterBankE;
+            default:  return m_RegisterBankF;
+        }
+    }
+
+    [[nodiscard]] u32* GetRegisterBank(const u32 registerIndex) noexcept
+    {
+        return const_cast<u32*>(static_cast<const RegisterFile*>(this)->GetRegisterBank(registerIndex));
+    }
+
+    // Uses the same bank mapping as GetRegisterBank.
+    [[nodiscard]] const u8* GetContestationBank(const u32 registerIndex) const noexcept
+    {
+        switch(((registerIndex >> 1) & 0x7) * 2 + (registerIndex & 0x1))
+        {
+            case 0x0: return m_RegisterContestationMapBank0;
+            case 0x1: return m_RegisterContestationMapBank1;
+            case 0x2: return m_RegisterContestationMapBank2;
+            case 0x3: return m_RegisterContestationMapBank3;
+            case 0x4: return m_RegisterContestationMapBank4;
+            case 0x5: return m_RegisterContestationMapBank5;
+            case 0x6: return m_RegisterContestationMapBank6;
+            case 0x7: return m_RegisterContestationMapBank7;
+            case 0x8: return m_RegisterContestationMapBank8;
+            case 0x9: return m_RegisterContestationMapBank9;
+            case 0xA: return m_RegisterContestationMapBankA;
+            case 0xB: return m_RegisterContestationMapBankB;
+            case 0xC: return m_RegisterContestationMapBankC;
+            case 0xD: return m_RegisterContestationMapBankD;
+            case 0xE: return m_RegisterContestationMapBankE;
+            default:  return m_RegisterContestationMapBankF;
+        }
+    }
+
+    [[nodiscard]] u8* GetContestationBank(const u32 registerIndex) noexcept
+    {
+        return const_cast<u8*>(static_cast<const RegisterFile*>(this)->GetContestationBank(registerIndex));
+    }
+
     void ExecutePacket(const CommandPacket packetHigh, const CommandPacket packetLow) noexcept
     {
         switch(packetHigh.Command)
@@ -704,6 +840,19 @@ private:
                 break;
         }
     }
+private:
+    // None and Reset are no-ops, a port holding either can be skipped.
+    void UpdateActivePort(const u32 portBit, const ECommand command) noexcept
+    {
+        if(command == ECommand::None || command == ECommand::Reset)
+        {
+            m_ActivePortMask &= ~(1u << portBit);
+        }
+        else
+        {
+            m_ActivePortMask |= 1u << portBit;
+        }
+    }
 private:
     u32 m_RegisterBank0[REGISTER_FILE_BANK_REGISTER_COUNT];
     u32 m_RegisterBank1[REGISTER_FILE_BANK_REGISTER_COUNT];
@@ -756,4 +905,6 @@ private:
     CommandPacket m_Port1Low;
     CommandPacket m_Port2Low;
     CommandPacket m_Port3Low;
+    // The high ports are the low 4 bits, the low ports the upper 4 bits.
+    u8 m_ActivePortMask;
 };
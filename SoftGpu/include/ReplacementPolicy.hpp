@@ -0,0 +1,346 @@
+#pragma once
+
+#include <cstring>
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+enum class EReplacementPolicy : u8
+{
+    RoundRobin = 0,
+    Lru,
+    TreePlru,
+    Srrip,
+    Brrip
+};
+
+/*
+ *   Every policy has the same shape. SetState is the per-set metadata,
+ * stored by the cache alongside each set, while the policy object
+ * itself holds anything shared by the whole cache (or L2 bank). The
+ * cache calls OnHit for demand hits and OnFill once a line has been
+ * (re)allocated. OnDemote makes a way the next victim, for lines the
+ * access hinted won't be reused. SelectVictim is only called when every
+ * way of the set is valid.
+ */
+
+/**
+ * \brief Round robin over the ways, with one selector shared by every set.
+ *
+ *   This is the original policy, kept for comparison.
+ */
+template<uSys WayCount>
+class RoundRobinReplacement final
+{
+    DEFAULT_DESTRUCT(RoundRobinReplacement);
+    DELETE_CM(RoundRobinReplacement);
+public:
+    struct SetState final
+    { };
+public:
+    RoundRobinReplacement() noexcept
+        : m_RollingSelector(0)
+    { }
+
+    void Reset() noexcept { m_RollingSelector = 0; }
+    static void ResetSet(SetState&) noexcept { }
+
+    void OnHit(SetState&, uSys) noexcept { }
+    void OnFill(SetState&, uSys) noexcept { }
+    // The selector is shared by every set, so there is no per-set order to change.
+    void OnDemote(SetState&, uSys) noexcept { }
+
+    [[nodiscard]] uSys SelectVictim(SetState&) noexcept
+    {
+        // This will be implemented as an n-bit rolling integer.
+        return (m_RollingSelector++) % WayCount;
+    }
+private:
+    u32 m_RollingSelector;
+};
+
+/**
+ * \brief True LRU, each way holds its rank in the set, 0 being the most recently used.
+ */
+template<uSys WayCount>
+class LruReplacement final
+{
+    DEFAULT_CONSTRUCT_PU(LruReplacement);
+    DEFAULT_DESTRUCT(LruReplacement);
+    DELETE_CM(LruReplacement);
+public:
+    static_assert(WayCount <= 256, "LRU ranks are 8 bits.");
+
+    struct SetState final
+    {
+        u8 Ranks[WayCount];
+    };
+public:
+    void Reset() noexcept { }
+
+    static void ResetSet(SetState& state) noexcept
+    {
+        for(uSys i = 0; i < WayCount; ++i)
+        {
+            state.Ranks[i] = static_cast<u8>(i);
+        }
+    }
+
+    void OnHit(SetState& state, const uSys way) noexcept { Touch(state, way); }
+    void OnFill(SetState& state, const uSys way) noexcept { Touch(state, way); }
+
+    void OnDemote(SetState& state, const uSys way) noexcept
+    {
+        const u8 rank = state.Ranks[way];
+
+        for(uSys i = 0; i < WayCount; ++i)
+        {
+            if(state.Ranks[i] > rank)
+            {
+                --state.Ranks[i];
+            }
+        }
+
+        state.Ranks[way] = static_cast<u8>(WayCount - 1);
+    }
+
+    [[nodiscard]] uSys SelectVictim(SetState& state) noexcept
+    {
+        for(uSys i = 0; i < WayCount; ++i)
+        {
+            if(state.Ranks[i] == WayCount - 1)
+            {
+                return i;
+            }
+        }
+
+        return 0;
+    }
+private:
+    static void Touch(SetState& state, const uSys way) noexcept
+    {
+        const u8 rank = state.Ranks[way];
+
+        for(uSys i = 0; i < WayCount; ++i)
+        {
+            if(state.Ranks[i] < rank)
+            {
+                ++state.Ranks[i];
+            }
+        }
+
+        state.Ranks[way] = 0;
+    }
+};
+
+/**
+ * \brief Tree pseudo LRU.
+ *
+ *   The ways are the leaves of a binary tree, node n has children 2n
+ * and 2n + 1 with the root at 1. Each node's bit points towards the
+ * less recently used half, an access flips the bits on its path to
+ * point away from it.
+ */
+template<uSys WayCount>
+class TreePlruReplacement final
+{
+    DEFAULT_CONSTRUCT_PU(TreePlruReplacement);
+    DEFAULT_DESTRUCT(TreePlruReplacement);
+    DELETE_CM(TreePlruReplacement);
+public:
+    static_assert((WayCount & (WayCount - 1)) == 0, "Tree PLRU needs a power of 2 way count.");
+    static_assert(WayCount <= 64, "Tree PLRU nodes are stored in a 64 bit mask.");
+
+    struct SetState final
+    {
+        u64 Nodes;
+    };
+public:
+    void Reset() noexcept { }
+    static void ResetSet(SetState& state) noexcept { state.Nodes = 0; }
+
+    void OnHit(SetState& state, const uSys way) noexcept { Touch(state, way); }
+    void OnFill(SetState& state, const uSys way) noexcept { Touch(state, way); }
+
+    void OnDemote(SetState& state, const uSys way) noexcept
+    {
+        uSys node = WayCount + way;
+
+        while(node > 1)
+        {
+            const u64 side = node & 0x1;
+            node >>= 1;
+
+            // Point the parent at this child.
+            state.Nodes = (state.Nodes & ~(1ull << node)) | (side << node);
+        }
+    }
+
+    [[nodiscard]] uSys SelectVictim(SetState& state) noexcept
+    {
+        uSys node = 1;
+
+        while(node < WayCount)
+        {
+            node = node * 2 + ((state.Nodes >> node) & 0x1);
+        }
+
+        return node - WayCount;
+    }
+private:
+    static void Touch(SetState& state, const uSys way) noexcept
+    {
+        uSys node = WayCount + way;
+
+        while(node > 1)
+        {
+            const u64 side = node & 0x1;
+            node >>= 1;
+
+            // Point the parent at the other child.
+            state.Nodes = (state.Nodes & ~(1ull << node)) | ((side ^ 0x1) << node);
+        }
+    }
+};
+
+/**
+ * \brief Static and bimodal re-reference interval prediction.
+ *
+ *   Each way has a 2 bit re-reference prediction, hits predict a near
+ * re-reference and the victim is the first way predicted distant,
+ * ageing the whole set until there is one. SRRIP inserts with a long
+ * prediction. BRRIP inserts with a distant prediction and only every
+ * BRRIP_LONG_INSERT_PERIOD fills with a long one, which keeps streaming
+ * data from washing out the set.
+ */
+template<uSys WayCount, bool Bimodal>
+class RripReplacement final
+{
+    DEFAULT_DESTRUCT(RripReplacement);
+    DELETE_CM(RripReplacement);
+public:
+    static inline constexpr u8 MAX_RRPV = 3;
+    static inline constexpr u8 LONG_RRPV = MAX_RRPV - 1;
+    static inline constexpr u32 BRRIP_LONG_INSERT_PERIOD = 32;
+
+    struct SetState final
+    {
+        u8 Rrpvs[WayCount];
+    };
+public:
+    RripReplacement() noexcept
+        : m_FillCount(0)
+    { }
+
+    void Reset() noexcept { m_FillCount = 0; }
+
+    static void ResetSet(SetState& state) noexcept
+    {
+        (void) ::std::memset(state.Rrpvs, MAX_RRPV, sizeof(state.Rrpvs));
+    }
+
+    void OnHit(SetState& state, const uSys way) noexcept
+    {
+        state.Rrpvs[way] = 0;
+    }
+
+    void OnFill(SetState& state, const uSys way) noexcept
+    {
+        if constexpr(Bimodal)
+        {
+            state.Rrpvs[way] = (m_FillCount++ % BRRIP_LONG_INSERT_PERIOD) == 0 ? LONG_RRPV : MAX_RRPV;
+        }
+        else
+        {
+            state.Rrpvs[way] = LONG_RRPV;
+        }
+    }
+
+    void OnDemote(SetState& state, const uSys way) noexcept
+    {
+        state.Rrpvs[way] = MAX_RRPV;
+    }
+
+    [[nodiscard]] uSys SelectVictim(SetState& state) noexcept
+    {
+        while(true)
+        {
+            for(uSys i = 0; i < WayCount; ++i)
+            {
+                if(state.Rrpvs[i] == MAX_RRPV)
+                {
+                    return i;
+                }
+            }
+
+            for(uSys i = 0; i < WayCount; ++i)
+            {
+                ++state.Rrpvs[i];
+            }
+        }
+    }
+private:
+    u32 m_FillCount;
+};
+
+template<EReplacementPolicy Policy, uSys WayCount>
+struct ReplacementPolicySelector;
+
+template<uSys WayCount>
+struct ReplacementPolicySelector<EReplacementPolicy::RoundRobin, WayCount> final
+{
+    using Type = RoundRobinReplacement<WayCount>;
+};
+
+template<uSys WayCount>
+struct ReplacementPolicySelector<EReplacementPolicy::Lru, WayCount> final
+{
+    using Type = LruReplacement<WayCount>;
+};
+
+template<uSys WayCount>
+struct ReplacementPolicySelector<EReplacementPolicy::TreePlru, WayCount> final
+{
+    using Type = TreePlruReplacement<WayCount>;
+};
+
+template<uSys WayCount>
+struct ReplacementPolicySelector<EReplacementPolicy::Srrip, WayCount> final
+{
+    using Type = RripReplacement<WayCount, false>;
+};
+
+template<uSys WayCount>
+struct ReplacementPolicySelector<EReplacementPolicy::Brrip, WayCount> final
+{
+    using Type = RripReplacement<WayCount, true>;
+};
+
+template<EReplacementPolicy Policy, uSys WayCount>
+using ReplacementPolicy = typename ReplacementPolicySelector<Policy, WayCount>::Type;
+
+/**
+ * \brief The policy's victim, passing over the ways in keptMask unless every way is in it.
+ *
+ *   A kept victim is promoted to move the policy on to its next choice,
+ * each policy gets through every way within WayCount promotions. If it
+ * somehow doesn't the last choice is evicted anyway, keeping is a hint.
+ */
+template<uSys WayCount, typename Policy>
+[[nodiscard]] uSys SelectUnkeptVictim(Policy& policy, typename Policy::SetState& state, const u32 keptMask) noexcept
+{
+    uSys way = policy.SelectVictim(state);
+
+    if(keptMask == static_cast<u32>((1ull << WayCount) - 1))
+    {
+        return way;
+    }
+
+    for(uSys i = 0; i < WayCount && (keptMask & (1u << way)) != 0; ++i)
+    {
+        policy.OnHit(state, way);
+        way = policy.SelectVictim(state);
+    }
+
+    return way;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+#include <atomic>
+#include <thread>
+
+#include "GpuTopology.hpp"
+
+class Processor;
+
+// Clocks each StreamingMultiprocessor on its own host thread.
+//
+// The processor thread drives SM 0, the remaining SMs each get a persistent worker.
+// Every cycle is bracketed by a generation counter (start) and a pending counter (end),
+// both of which are spun on before falling back to std::atomic::wait.
+//
+// Access to shared memory (the CacheController and physical memory) is granted in SM
+// index order. An SM may only touch shared memory once every lower indexed SM has
+// retired its clock for the current cycle, this reproduces the exact access order of
+// the serial model, so the snoop traffic between the L0 caches is identical cycle for
+// cycle. Work done before the first shared access, and the entire cycle of SMs that
+// do not touch memory, runs in parallel.
+class SmWorkerPool final
+{
+    DELETE_CM(SmWorkerPool);
+public:
+    static inline constexpr u32 SmCount = Topology.SmCount;
+    static inline constexpr u32 WorkerCount = SmCount - 1;
+    static inline constexpr u32 SpinCount = 256;
+public:
+    SmWorkerPool(Processor* const processor) noexcept
+        : m_Processor(processor)
+        , m_Workers { }
+        , m_Generation(0)
+        , m_PendingCount(0)
+        , m_SleepingCount(0)
+        , m_RetiredGeneration { }
+        , m_ShouldExit(false)
+        , m_InParallelPhase(false)
+        , m_Running(false)
+    { }
+
+    ~SmWorkerPool() noexcept
+    {
+        Stop();
+    }
+
+    void Start() noexcept;
+    void Stop() noexcept;
+
+    [[nodiscard]] bool IsRunning() const noexcept { return m_Running; }
+    [[nodiscard]] bool InParallelPhase() const noexcept { return m_InParallelPhase.load(::std::memory_order_relaxed); }
+
+    // Clocks every SM for a single cycle, returns once all of them have retired.
+    void Clock() noexcept;
+
+    // Blocks until every SM with a lower index has retired the current cycle.
+    void WaitForSharedMemory(u32 smIndex) const noexcept;
+private:
+    void WorkerFunc(u32 smIndex, u32 generation) noexcept;
+
+    void Retire(u32 smIndex, u32 generation) noexcept;
+private:
+    Processor* m_Processor;
+    ::std::thread m_Workers[WorkerCount];
+    ::std::atomic<u32> m_Generation;
+    ::std::atomic<u32> m_PendingCount;
+    ::std::atomic<u32> m_SleepingCount;
+    ::std::atomic<u32> m_RetiredGeneration[SmCount];
+    ::std::atomic_bool m_ShouldExit;
+    ::std::atomic_bool m_InParallelPhase;
+    bool m_Running;
+};
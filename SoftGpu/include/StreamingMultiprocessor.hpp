@@ -7,107 +7,295 @@
 #include "DebugManager.hpp"
 #include "RegisterAllocator.hpp"
 #include "MMU.hpp"
+#include "MissStatusHoldingRegisters.hpp"
+#include "WriteCombiningBuffer.hpp"
+#include "DecodedInstructionCache.hpp"
+#include "ThreadedBlockInterpreter.hpp"
+#include "GpuTopology.hpp"
+
+#include <immintrin.h>
+#include <utility>
 
 class Processor;
 
+enum class EExecutionMode : u8
+{
+    // Every unit is clocked and communicates over the register file ports.
+    Cycle = 0,
+    // Instructions are executed directly against the register file and memory, timing is not modeled.
+    Functional
+};
+
 class StreamingMultiprocessor final
 {
     DEFAULT_DESTRUCT(StreamingMultiprocessor);
     DELETE_CM(StreamingMultiprocessor);
+public:
+    using Mshrs = MissStatusHoldingRegisters<Topology.L0MshrCount>;
+
+    // The core clock order interleaves the first half of each core type, then the second half.
+    static inline constexpr u32 FP_CORE_SPLIT = (Topology.FpCoreCount + 1) / 2;
+    static inline constexpr u32 INT_FP_CORE_SPLIT = (Topology.IntFpCoreCount + 1) / 2;
 public:
     StreamingMultiprocessor(Processor* const processor, const u32 smIndex) noexcept
+        : StreamingMultiprocessor(processor, smIndex, ::std::make_index_sequence<Topology.LdStCount>(), ::std::make_index_sequence<Topology.FpCoreCount>(), ::std::make_index_sequence<Topology.IntFpCoreCount>(), ::std::make_index_sequence<Topology.DispatchUnitCount>())
+    { }
+private:
+    // Expands an initializer for every unit in the topology.
+    template<uSys... LdStIndices, uSys... FpCoreIndices, uSys... IntFpCoreIndices, uSys... DispatchUnitIndices>
+    StreamingMultiprocessor(Processor* const processor, const u32 smIndex, ::std::index_sequence<LdStIndices...>, ::std::index_sequence<FpCoreIndices...>, ::std::index_sequence<IntFpCoreIndices...>, ::std::index_sequence<DispatchUnitIndices...>) noexcept
         : m_Processor(processor)
         , m_RegisterFile { }
         , m_Mmu(this)
-        , m_LdSt { { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 } }
-        , m_FpCores { { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 }, { this, 4 }, { this, 5 }, { this, 6 }, { this, 7 } }
-        , m_IntFpCores { { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 }, { this, 4 }, { this, 5 }, { this, 6 }, { this, 7 } }
-        , m_DispatchUnits { { this, 0 }, { this, 1 } }
+        , m_Mshrs { }
+        , m_WriteCombiner(processor, smIndex)
+        , m_LdSt { { this, LdStIndices }... }
+        , m_FpCores { { this, FpCoreIndices }... }
+        , m_IntFpCores { { this, IntFpCoreIndices }... }
+        , m_DispatchUnits { { this, DispatchUnitIndices }... }
+        , m_DecodeCache { }
+        , m_BlockCache { }
         , m_SMIndex(smIndex)
+        , m_CycleCount(0)
+        , m_HoldsSharedMemory(false)
+        , m_ExecutionMode(EExecutionMode::Cycle)
+        , m_BlockInterpreter(false)
+        , m_ActiveLdStMask(0)
+        , m_ActiveFpCoreMask(0)
+        , m_ActiveIntFpCoreMask(0)
     { }
-
+public:
     void Reset()
     {
         m_RegisterFile.Reset();
         m_Mmu.Reset();
-        m_LdSt[0].Reset();
-        m_LdSt[1].Reset();
-        m_LdSt[2].Reset();
-        m_LdSt[3].Reset();
+        m_Mshrs.Reset();
+        m_WriteCombiner.Reset();
 
-        for(u32 subClockIndex = 0; subClockIndex <= 5; ++subClockIndex)
+        for(u32 i = 0; i < Topology.LdStCount; ++i)
         {
-            for(u32 coreIndex = 0; coreIndex < 8; ++coreIndex)
-            {
-                m_FpCores[coreIndex].Reset();
-                m_IntFpCores[coreIndex].Reset();
-            }
+            m_LdSt[i].Reset();
+        }
+
+        for(u32 coreIndex = 0; coreIndex < Topology.FpCoreCount; ++coreIndex)
+        {
+            m_FpCores[coreIndex].Reset();
         }
 
-        m_DispatchUnits[0].Reset();
-        m_DispatchUnits[1].Reset();
+        for(u32 coreIndex = 0; coreIndex < Topology.IntFpCoreCount; ++coreIndex)
+        {
+            m_IntFpCores[coreIndex].Reset();
+        }
+
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].Reset();
+        }
+
+        m_DecodeCache.Reset();
+        m_BlockCache.Reset();
+        m_CycleCount = 0;
+        m_ActiveLdStMask = 0;
+        m_ActiveFpCoreMask = 0;
+        m_ActiveIntFpCoreMask = 0;
+    }
+
+    // Only called by the processor on cycles the debugger is polled on.
+    void ReportToDebugger() const noexcept
+    {
+        m_RegisterFile.ReportRegisters(m_SMIndex);
+
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].ReportBaseRegisters(m_SMIndex);
+        }
     }
 
     void Clock() noexcept
     {
-        if(GlobalDebug.IsAttached())
+        m_HoldsSharedMemory = false;
+        ++m_CycleCount;
+
+        if(m_WriteCombiner.HasExpired(m_CycleCount))
         {
-            m_RegisterFile.ReportRegisters(m_SMIndex);
-            m_DispatchUnits[0].ReportBaseRegisters(m_SMIndex);
-            m_DispatchUnits[1].ReportBaseRegisters(m_SMIndex);
+            DrainExpiredWrites();
         }
 
-        for(uSys i = 0; i < LoadStore::MAX_EXECUTION_STAGE; ++i)
+        if(m_ExecutionMode == EExecutionMode::Functional)
         {
-            m_LdSt[0].Clock();
-            m_LdSt[1].Clock();
-            m_LdSt[2].Clock();
-            m_LdSt[3].Clock();
-            m_RegisterFile.Clock();
+            ClockFunctional();
+            return;
         }
 
-        for(u32 subClockIndex = 0; subClockIndex <= 5; ++subClockIndex)
+        // Idle units are skipped, units only become active through dispatch which happens after this.
+        // The register file is still pulsed as often as before, but that is free without pending packets.
+        if(m_ActiveLdStMask != 0 || m_RegisterFile.HasActivePorts())
         {
-            for(u32 coreIndex = 0; coreIndex < 4; ++coreIndex)
+            for(uSys i = 0; i < LoadStore::MAX_EXECUTION_STAGE; ++i)
             {
-                m_FpCores[coreIndex].Clock(subClockIndex);
+                for(u32 activeMask = m_ActiveLdStMask; activeMask != 0; activeMask &= activeMask - 1)
+                {
+                    m_LdSt[_tzcnt_u32(activeMask)].Clock();
+                }
                 m_RegisterFile.Clock();
             }
-            for(u32 coreIndex = 0; coreIndex < 4; ++coreIndex)
+
+            for(u32 activeMask = m_ActiveLdStMask; activeMask != 0; activeMask &= activeMask - 1)
             {
-                m_IntFpCores[coreIndex].Clock(subClockIndex);
-                m_RegisterFile.Clock();
+                const u32 unitIndex = _tzcnt_u32(activeMask);
+
+                if(!m_LdSt[unitIndex].IsActive())
+                {
+                    m_ActiveLdStMask &= ~(1u << unitIndex);
+                }
             }
-            for(u32 coreIndex = 4; coreIndex < 8; ++coreIndex)
+        }
+
+        if((m_ActiveFpCoreMask | m_ActiveIntFpCoreMask) != 0 || m_RegisterFile.HasActivePorts())
+        {
+            for(u32 subClockIndex = 0; subClockIndex <= 5; ++subClockIndex)
             {
-                m_FpCores[coreIndex].Clock(subClockIndex);
-                m_RegisterFile.Clock();
+                for(u32 coreIndex = 0; coreIndex < FP_CORE_SPLIT; ++coreIndex)
+                {
+                    if(m_ActiveFpCoreMask & (1u << coreIndex))
+                    {
+                        m_FpCores[coreIndex].Clock(subClockIndex);
+                    }
+                    m_RegisterFile.Clock();
+                }
+                for(u32 coreIndex = 0; coreIndex < INT_FP_CORE_SPLIT; ++coreIndex)
+                {
+                    if(m_ActiveIntFpCoreMask & (1u << coreIndex))
+                    {
+                        m_IntFpCores[coreIndex].Clock(subClockIndex);
+                    }
+                    m_RegisterFile.Clock();
+                }
+                for(u32 coreIndex = FP_CORE_SPLIT; coreIndex < Topology.FpCoreCount; ++coreIndex)
+                {
+                    if(m_ActiveFpCoreMask & (1u << coreIndex))
+                    {
+                        m_FpCores[coreIndex].Clock(subClockIndex);
+                    }
+                    m_RegisterFile.Clock();
+                }
+                for(u32 coreIndex = INT_FP_CORE_SPLIT; coreIndex < Topology.IntFpCoreCount; ++coreIndex)
+                {
+                    if(m_ActiveIntFpCoreMask & (1u << coreIndex))
+                    {
+                        m_IntFpCores[coreIndex].Clock(subClockIndex);
+                    }
+                    m_RegisterFile.Clock();
+                }
             }
-            for(u32 coreIndex = 4; coreIndex < 8; ++coreIndex)
+
+            for(u32 coreIndex = 0; coreIndex < Topology.FpCoreCount; ++coreIndex)
             {
-                m_IntFpCores[coreIndex].Clock(subClockIndex);
-                m_RegisterFile.Clock();
+                if(!m_FpCores[coreIndex].IsActive())
+                {
+                    m_ActiveFpCoreMask &= ~(1u << coreIndex);
+                }
+            }
+
+            for(u32 coreIndex = 0; coreIndex < Topology.IntFpCoreCount; ++coreIndex)
+            {
+                if(!m_IntFpCores[coreIndex].IsActive())
+                {
+                    m_ActiveIntFpCoreMask &= ~(1u << coreIndex);
+                }
             }
         }
 
-        m_DispatchUnits[0].ResetCycle();
-        m_DispatchUnits[1].ResetCycle();
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].ResetCycle();
+        }
 
         for(u32 i = 0; i < 6; ++i)
         {
-            m_DispatchUnits[0].Clock();
-            m_DispatchUnits[1].Clock();
+            for(u32 j = 0; j < Topology.DispatchUnitCount; ++j)
+            {
+                m_DispatchUnits[j].Clock();
+            }
+        }
+    }
+
+    // Whether clocking this SM would change anything other than the statistics counters.
+    [[nodiscard]] bool IsIdle() const noexcept
+    {
+        // Buffered stores still have to drain on their timeout.
+        if((m_ActiveLdStMask | m_ActiveFpCoreMask | m_ActiveIntFpCoreMask) != 0 || m_RegisterFile.HasActivePorts() || m_WriteCombiner.HasPending())
+        {
+            return false;
+        }
+
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            if(!m_DispatchUnits[i].IsIdle())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void AdvanceIdleCycles(const u64 cycleCount) noexcept
+    {
+        m_CycleCount += cycleCount;
+
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].AdvanceIdleCycles(cycleCount);
         }
     }
 
+    // SM clocks since the last reset, including skipped idle cycles.
+    [[nodiscard]] u64 CycleCount() const noexcept { return m_CycleCount; }
+
+    [[nodiscard]] const MshrStatistics& L0MshrStatistics() const noexcept { return m_Mshrs.Statistics(); }
+    [[nodiscard]] const WriteCombiningStatistics& WriteCombinerStatistics() const noexcept { return m_WriteCombiner.Statistics(); }
+
+    // Hardware prefetches never take the last MSHR, it is kept for the demand miss that triggered them.
+    [[nodiscard]] bool CanTrackPrefetch() noexcept { return m_Mshrs.FreeCount(m_CycleCount) > 1; }
+
+    // A hardware prefetch filled a line, demand accesses to it wait until the fill would have arrived.
+    void TrackPrefetch(const u64 physicalAddress, const bool external, const ECacheLevel servedBy) noexcept
+    {
+        m_Mshrs.Allocate(physicalAddress >> 3, external, m_CycleCount + Mshrs::MissLatency(servedBy));
+    }
+
+    [[nodiscard]] EExecutionMode ExecutionMode() const noexcept { return m_ExecutionMode; }
+
+    // Switching modes drops any work in flight in the execution units, this should only be done while idle.
+    void SetExecutionMode(const EExecutionMode executionMode) noexcept
+    {
+        m_ExecutionMode = executionMode;
+    }
+
+    [[nodiscard]] bool BlockInterpreter() const noexcept { return m_BlockInterpreter; }
+
+    // Only affects the functional execution mode.
+    void SetBlockInterpreter(const bool blockInterpreter) noexcept
+    {
+        m_BlockInterpreter = blockInterpreter;
+    }
+
     void TestLoadProgram(const u32 dispatchPort, const u8 replicationMask, const u64 program)
     {
+        // Smaller topologies have fewer dispatch units than the ISA allows for.
+        assert(dispatchPort < Topology.DispatchUnitCount);
+
         const u16 baseRegisters[4] = { static_cast<u16>((dispatchPort * 4 + 0) * 256), static_cast<u16>((dispatchPort * 4 + 1) * 256), static_cast<u16>((dispatchPort * 4 + 2) * 256), static_cast<u16>((dispatchPort * 4 + 3) * 256) };
         m_DispatchUnits[dispatchPort].LoadIP(replicationMask, baseRegisters, program);
     }
 
+    [[nodiscard]] Mmu& TestMmu() noexcept { return m_Mmu; }
+
     void TestLoadRegister(const u32 dispatchPort, const u32 replicationIndex, const u8 registerIndex, const u32 registerValue)
     {
+        assert(dispatchPort < Topology.DispatchUnitCount);
+
         u32 value = registerValue;
         bool successful = false;
         bool unsuccessful = false;
@@ -151,8 +339,55 @@ public:
         m_DispatchUnits[dispatchPort].LoadWarp(enabledMask, completedMask, baseRegisters, instructionPointer);
     }
 
-    [[nodiscard]] u32 Read(u64 address) noexcept;
-    void Write(u64 address, u32 value) noexcept;
+    [[nodiscard]] u32 GetRegister(const u32 registerIndex) const noexcept
+    {
+        return m_RegisterFile.GetRegister(registerIndex);
+    }
+
+    void SetRegister(const u32 registerIndex, const u32 value) noexcept
+    {
+        m_RegisterFile.SetRegister(registerIndex, value);
+    }
+
+    [[nodiscard]] bool CanReadRegister(const u32 registerIndex) const noexcept
+    {
+        return m_RegisterFile.CanReadRegister(registerIndex);
+    }
+
+    [[nodiscard]] bool CanWriteRegister(const u32 registerIndex) const noexcept
+    {
+        return m_RegisterFile.CanWriteRegister(registerIndex);
+    }
+
+    void LockRegisterRead(const u32 registerIndex) noexcept
+    {
+        m_RegisterFile.LockRegisterRead(registerIndex);
+    }
+
+    void LockRegisterWrite(const u32 registerIndex) noexcept
+    {
+        m_RegisterFile.LockRegisterWrite(registerIndex);
+    }
+
+    void ReleaseRegisterContestation(const u32 registerIndex) noexcept
+    {
+        m_RegisterFile.ReleaseRegisterContestation(registerIndex);
+    }
+
+    [[nodiscard]] u32 Read(u64 address, ECacheHint hint = ECacheHint::Normal) noexcept;
+    /**
+     * \brief The cycle model's load, which tracks misses in the MSHRs.
+     *
+     *   The value is read immediately but only becomes visible to the
+     * LoadStore unit from *readyCycle on, which is later than the
+     * current cycle for a miss. Returns false without reading anything
+     * if the load misses while every MSHR is in use, *readyCycle is then
+     * when to try again.
+     */
+    [[nodiscard]] bool ReadAsync(u64 address, u32* value, u64* readyCycle, ECacheHint hint = ECacheHint::Normal) noexcept;
+    // Same as Read, but translated through the instruction TLB.
+    [[nodiscard]] u32 ReadInstruction(u64 address) noexcept;
+    void Write(u64 address, u32 value, ECacheHint hint = ECacheHint::Normal) noexcept;
     void Prefetch(u64 address) noexcept;
 
     void InvokeRegisterFileHigh(const u32 port, const RegisterFile::CommandPacket packet) noexcept
@@ -187,60 +422,144 @@ public:
 
     void ReportFpCoreReady(const u32 unitIndex) noexcept
     {
-        m_DispatchUnits[0].ReportUnitReady(unitIndex + FP_AVAIL_OFFSET);
-        m_DispatchUnits[1].ReportUnitReady(unitIndex + FP_AVAIL_OFFSET);
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].ReportUnitReady(unitIndex + FP_AVAIL_OFFSET);
+        }
     }
 
     void ReportIntFpCoreReady(const u32 unitIndex) noexcept
     {
-        m_DispatchUnits[0].ReportUnitReady(unitIndex + INT_FP_AVAIL_OFFSET);
-        m_DispatchUnits[1].ReportUnitReady(unitIndex + INT_FP_AVAIL_OFFSET);
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].ReportUnitReady(unitIndex + INT_FP_AVAIL_OFFSET);
+        }
     }
 
     void ReportLdStReady(const u32 unitIndex) noexcept
     {
-        m_DispatchUnits[0].ReportUnitReady(unitIndex + LDST_AVAIL_OFFSET);
-        m_DispatchUnits[1].ReportUnitReady(unitIndex + LDST_AVAIL_OFFSET);
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].ReportUnitReady(unitIndex + LDST_AVAIL_OFFSET);
+        }
     }
     
     void DispatchLdSt(const u32 ldStIndex, const LoadStoreInstruction instructionInfo) noexcept
     {
-        m_DispatchUnits[0].ReportUnitBusy(ldStIndex + LDST_AVAIL_OFFSET);
-        m_DispatchUnits[1].ReportUnitBusy(ldStIndex + LDST_AVAIL_OFFSET);
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].ReportUnitBusy(ldStIndex + LDST_AVAIL_OFFSET);
+        }
 
         m_LdSt[ldStIndex].PrepareExecution(instructionInfo);
+        m_ActiveLdStMask |= 1u << ldStIndex;
     }
 
     void DispatchFpu(const u32 fpIndex, const FpuInstruction instructionInfo) noexcept
     {
-        if(fpIndex < 8)
+        if(fpIndex < MAX_FP_CORE_COUNT)
         {
-            m_DispatchUnits[0].ReportUnitBusy(fpIndex + FP_AVAIL_OFFSET);
-            m_DispatchUnits[1].ReportUnitBusy(fpIndex + FP_AVAIL_OFFSET);
+            for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+            {
+                m_DispatchUnits[i].ReportUnitBusy(fpIndex + FP_AVAIL_OFFSET);
+            }
             m_FpCores[fpIndex].InitiateInstruction(instructionInfo);
+            m_ActiveFpCoreMask |= 1u << fpIndex;
         }
         else
         {
-            m_DispatchUnits[0].ReportUnitBusy(fpIndex - 8 + INT_FP_AVAIL_OFFSET);
-            m_DispatchUnits[1].ReportUnitBusy(fpIndex - 8 + INT_FP_AVAIL_OFFSET);
-            m_IntFpCores[fpIndex - 8].InitiateInstructionFP(instructionInfo);
+            for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+            {
+                m_DispatchUnits[i].ReportUnitBusy(fpIndex - MAX_FP_CORE_COUNT + INT_FP_AVAIL_OFFSET);
+            }
+            m_IntFpCores[fpIndex - MAX_FP_CORE_COUNT].InitiateInstructionFP(instructionInfo);
+            m_ActiveIntFpCoreMask |= 1u << (fpIndex - MAX_FP_CORE_COUNT);
         }
     }
 
-    void LoadPageDirectoryPointer(const u64 pageDirectoryPhysicalAddress) noexcept
+    void LoadPageDirectoryPointer(const u64 pageDirectoryPhysicalAddress, const u16 asid) noexcept
+    {
+        m_Mmu.LoadPageDirectoryPointer(pageDirectoryPhysicalAddress, asid);
+        // The decode cache is keyed by virtual address.
+        m_DecodeCache.Invalidate();
+    }
+
+    [[nodiscard]] u16 Asid() const noexcept { return m_Mmu.Asid(); }
+
+    void InvalidateMmuAsid(const u16 asid) noexcept
+    {
+        m_Mmu.InvalidateAsid(asid);
+        m_DecodeCache.Invalidate();
+    }
+
+    void InvalidateMmuPage(const u64 virtualAddress, const u16 asid) noexcept
     {
-        m_Mmu.LoadPageDirectoryPointer(pageDirectoryPhysicalAddress);
+        m_Mmu.InvalidatePage(virtualAddress, asid);
+        m_DecodeCache.Invalidate();
     }
 
     void FlushMmuCache() noexcept
     {
         m_Mmu.FlushCache();
+        m_DecodeCache.Invalidate();
+    }
+
+    [[nodiscard]] const DecodedInstruction* LookupDecodedInstruction(u64 instructionPointer) noexcept;
+
+    void InsertDecodedInstruction(const u64 instructionPointer, const u64 nextInstructionPointer, const EInstruction instruction, const InstructionDecodeData::InstructionData& data) noexcept
+    {
+        m_DecodeCache.Insert(instructionPointer, nextInstructionPointer, instruction, data);
     }
 
-    void WriteMmuPageInfo(u64 physicalAddress, u64 pageTableEntry) noexcept;
+    // May be called from any thread, address is the physical word address.
+    void NotifyCodeWrite(const u64 physicalAddress) noexcept
+    {
+        m_DecodeCache.NotifyWrite(physicalAddress);
+    }
+
+    /**
+     * \brief Applies the code writes from other SMs and the host.
+     *
+     *   This is only called by the processor between cycles, before any
+     * SM is clocked. A lookup mid cycle would otherwise see a racing
+     * store from another SM depending on thread timing, so the threaded
+     * clock wouldn't match the serial one. Our own stores are applied
+     * right away in Write, which holds shared memory.
+     */
+    void SyncPendingInvalidate() noexcept
+    {
+        m_DecodeCache.SyncPendingInvalidate();
+    }
+
+    // Threaded blocks are invalidated along with the decode cache.
+    [[nodiscard]] u32 DecodeEpoch() const noexcept { return m_DecodeCache.Epoch(); }
+
+    [[nodiscard]] const ThreadedBlock* LookupThreadedBlock(u64 instructionPointer) noexcept;
+
+    [[nodiscard]] ThreadedBlock& AllocateThreadedBlock(const u64 instructionPointer) noexcept
+    {
+        return m_BlockCache.Allocate(instructionPointer, m_DecodeCache.Epoch());
+    }
+
+    void WriteMmuPageFlags(u64 physicalAddress, u32 pageFlags) noexcept;
 
     void FlushCache() noexcept;
 
+    // Called when a warp halts, the host may inspect the page tables once it has.
+    void WriteBackPageEntries() noexcept;
+
+    // Called when a warp halts, along with WriteBackPageEntries.
+    void DrainWriteCombiner() noexcept;
+
+    // Only called by another SM while it holds the shared memory, or by the host between cycles.
+    void DrainUncachedWrites(const u64 physicalAddress, const bool external) noexcept
+    {
+        m_WriteCombiner.DrainUncachedLine(physicalAddress, external);
+    }
+
+    // May be called from any thread.
+    [[nodiscard]] bool HasPendingWrites() const noexcept { return m_WriteCombiner.HasPending(); }
+
     u16 AllocateRegisters(const u16 registerCount) noexcept
     {
         return m_RegisterAllocator.AllocateRegisterBlock(registerCount);
@@ -250,14 +569,51 @@ public:
     {
         m_RegisterAllocator.FreeRegisterBlock(registerBase, registerCount);
     }
+private:
+    void ClockFunctional() noexcept
+    {
+        for(u32 i = 0; i < Topology.DispatchUnitCount; ++i)
+        {
+            m_DispatchUnits[i].ResetCycle();
+        }
+
+        // Match the 6 dispatch slots per cycle of the cycle model.
+        for(u32 i = 0; i < 6; ++i)
+        {
+            for(u32 j = 0; j < Topology.DispatchUnitCount; ++j)
+            {
+                m_DispatchUnits[j].ExecuteFunctional();
+            }
+        }
+    }
+
+    void DrainExpiredWrites() noexcept;
+
+    // Drains every SM's buffered stores to the line before an uncached access to it.
+    void DrainWritesToLine(u64 physicalAddress, bool external) noexcept;
+
+    // Orders this SM's shared memory traffic behind the lower indexed SMs when clocked in parallel.
+    void AcquireSharedMemory() noexcept;
 private:
     Processor* m_Processor;
     RegisterFile m_RegisterFile;
     RegisterAllocator m_RegisterAllocator;
     Mmu m_Mmu;
-    LoadStore m_LdSt[4];
-    FpCore m_FpCores[8];
-    IntFpCore m_IntFpCores[8];
-    DispatchUnit m_DispatchUnits[2];
+    Mshrs m_Mshrs;
+    WriteCombiningBuffer m_WriteCombiner;
+    LoadStore m_LdSt[Topology.LdStCount];
+    FpCore m_FpCores[Topology.FpCoreCount];
+    IntFpCore m_IntFpCores[Topology.IntFpCoreCount];
+    DispatchUnit m_DispatchUnits[Topology.DispatchUnitCount];
+    DecodedInstructionCache m_DecodeCache;
+    ThreadedBlockCache m_BlockCache;
     u32 m_SMIndex;
+    u64 m_CycleCount;
+    bool m_HoldsSharedMemory;
+    EExecutionMode m_ExecutionMode;
+    bool m_BlockInterpreter;
+    // Units with work in flight, only these are clocked.
+    u8 m_ActiveLdStMask;
+    u8 m_ActiveFpCoreMask;
+    u8 m_ActiveIntFpCoreMask;
 };
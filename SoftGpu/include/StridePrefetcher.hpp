@@ -0,0 +1,246 @@
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+struct PrefetcherStatistics final
+{
+    // Demand misses the prefetcher trained on.
+    u64 DemandMisses;
+    // Lines filled ahead of demand.
+    u64 Issued;
+    // Prefetched lines that were hit by a demand access before being replaced.
+    u64 Useful;
+};
+
+/**
+ * \brief A stride and stream prefetcher for an SM's L0 cache.
+ *
+ *   Trains on the L0's demand misses, and on the first demand hit to
+ * each line it prefetched, so a stream it is running ahead of keeps
+ * training. Each stream entry tracks the last line a region touched and
+ * the stride between its accesses, once the same stride has repeated
+ * the next Degree lines along it are filled ahead of demand. A stride of
+ * 1 is a plain stream.
+ *
+ *   The degree is throttled by accuracy. After every ACCURACY_WINDOW
+ * prefetches the fraction of them demand went on to hit raises or
+ * lowers it. At degree 0 nothing is issued, the prefetcher tries again
+ * at degree 1 after ACCURACY_WINDOW more misses.
+ *
+ *   Prefetches never leave the page of the access that triggered them,
+ * the physical page after it may not exist.
+ */
+class StridePrefetcher final
+{
+    DEFAULT_DESTRUCT(StridePrefetcher);
+    DELETE_CM(StridePrefetcher);
+public:
+    static inline constexpr u32 STREAM_COUNT = 8;
+    static inline constexpr u32 MAX_DEGREE = 4;
+    static inline constexpr u32 INITIAL_DEGREE = 2;
+    // Accesses further apart than this, in lines, belong to different streams.
+    static inline constexpr i64 MAX_STRIDE = 16;
+    // Repeats of the same stride before a stream prefetches.
+    static inline constexpr u8 CONFIDENCE_THRESHOLD = 1;
+    static inline constexpr u8 MAX_CONFIDENCE = 3;
+    static inline constexpr u64 ACCURACY_WINDOW = 64;
+    // GpuPageSize in lines.
+    static inline constexpr u64 PAGE_LINE_BITS = 11;
+public:
+    StridePrefetcher() noexcept
+        : m_Streams{ }
+        , m_NextStream(0)
+        , m_Degree(INITIAL_DEGREE)
+        , m_WindowIssued(0)
+        , m_WindowUseful(0)
+        , m_IdleMisses(0)
+        , m_Statistics{ }
+    { }
+
+    void Reset() noexcept
+    {
+        for(u32 i = 0; i < STREAM_COUNT; ++i)
+        {
+            m_Streams[i].Valid = false;
+        }
+
+        m_NextStream = 0;
+        m_Degree = INITIAL_DEGREE;
+        m_WindowIssued = 0;
+        m_WindowUseful = 0;
+        m_IdleMisses = 0;
+        m_Statistics = { };
+    }
+
+    /**
+     * \brief Trains on an access to lineAddress.
+     *
+     * \param prefetchHit Set for a demand hit on a prefetched line, otherwise the access missed.
+     * \param lines Receives the lines to prefetch.
+     * \return The number of lines written to lines.
+     */
+    [[nodiscard]] u32 Train(const u64 lineAddress, const bool external, const bool prefetchHit, u64 lines[MAX_DEGREE]) noexcept
+    {
+        if(prefetchHit)
+        {
+            ++m_Statistics.Useful;
+            ++m_WindowUseful;
+        }
+        else
+        {
+            ++m_Statistics.DemandMisses;
+
+            if(m_Degree == 0 && ++m_IdleMisses == ACCURACY_WINDOW)
+            {
+                m_Degree = 1;
+                m_IdleMisses = 0;
+            }
+        }
+
+        Stream* const stream = FindStream(lineAddress, external);
+
+        if(!stream)
+        {
+            Stream& newStream = m_Streams[m_NextStream];
+            m_NextStream = (m_NextStream + 1) % STREAM_COUNT;
+
+            newStream.LastLine = lineAddress;
+            newStream.Stride = 0;
+            newStream.Confidence = 0;
+            newStream.External = external;
+            newStream.Valid = true;
+            return 0;
+        }
+
+        const i64 stride = static_cast<i64>(lineAddress - stream->LastLine);
+
+        // Another word of the same line.
+        if(stride == 0)
+        {
+            return 0;
+        }
+
+        if(stride == stream->Stride)
+        {
+            if(stream->Confidence < MAX_CONFIDENCE)
+            {
+                ++stream->Confidence;
+            }
+        }
+        else
+        {
+            stream->Stride = stride;
+            stream->Confidence = 0;
+        }
+
+        stream->LastLine = lineAddress;
+
+        if(stream->Confidence < CONFIDENCE_THRESHOLD)
+        {
+            return 0;
+        }
+
+        u32 lineCount = 0;
+
+        for(u32 i = 1; i <= m_Degree; ++i)
+        {
+            const u64 line = lineAddress + static_cast<u64>(stride * static_cast<i64>(i));
+
+            if((line >> PAGE_LINE_BITS) != (lineAddress >> PAGE_LINE_BITS))
+            {
+                break;
+            }
+
+            lines[lineCount++] = line;
+        }
+
+        return lineCount;
+    }
+
+    // A line returned by Train was actually filled, rather than already present.
+    void OnPrefetchIssued() noexcept
+    {
+        ++m_Statistics.Issued;
+
+        if(++m_WindowIssued == ACCURACY_WINDOW)
+        {
+            AdjustDegree();
+        }
+    }
+
+    [[nodiscard]] u32 Degree() const noexcept { return m_Degree; }
+    [[nodiscard]] const PrefetcherStatistics& Statistics() const noexcept { return m_Statistics; }
+private:
+    struct Stream final
+    {
+        u64 LastLine;
+        i64 Stride;
+        u8 Confidence;
+        bool External;
+        bool Valid;
+    };
+
+    // The nearest stream within MAX_STRIDE of the line.
+    [[nodiscard]] Stream* FindStream(const u64 lineAddress, const bool external) noexcept
+    {
+        Stream* nearest = nullptr;
+        i64 nearestDistance = MAX_STRIDE + 1;
+
+        for(u32 i = 0; i < STREAM_COUNT; ++i)
+        {
+            Stream& stream = m_Streams[i];
+
+            if(!stream.Valid || stream.External != external)
+            {
+                continue;
+            }
+
+            i64 distance = static_cast<i64>(lineAddress - stream.LastLine);
+
+            if(distance < 0)
+            {
+                distance = -distance;
+            }
+
+            if(distance < nearestDistance)
+            {
+                nearest = &stream;
+                nearestDistance = distance;
+            }
+        }
+
+        return nearest;
+    }
+
+    void AdjustDegree() noexcept
+    {
+        // Above 3/4 useful go further ahead, below 1/4 back off.
+        if(m_WindowUseful * 4 >= m_WindowIssued * 3)
+        {
+            if(m_Degree < MAX_DEGREE)
+            {
+                ++m_Degree;
+            }
+        }
+        else if(m_WindowUseful * 4 < m_WindowIssued)
+        {
+            if(m_Degree > 0)
+            {
+                --m_Degree;
+            }
+        }
+
+        m_WindowIssued = 0;
+        m_WindowUseful = 0;
+        m_IdleMisses = 0;
+    }
+private:
+    Stream m_Streams[STREAM_COUNT];
+    u32 m_NextStream;
+    u32 m_Degree;
+    u64 m_WindowIssued;
+    u64 m_WindowUseful;
+    u64 m_IdleMisses;
+    PrefetcherStatistics m_Statistics;
+};
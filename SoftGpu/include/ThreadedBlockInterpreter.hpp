@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+#include <cstring>
+
+#include "DispatchUnit.hpp"
+
+class StreamingMultiprocessor;
+
+// A precompiled handler specialized for a single instruction form, executes every replication set in replicationMask.
+using ThreadedOpHandler = void(*)(StreamingMultiprocessor* sm, const InstructionDecodeData::InstructionData& data, const u16 baseRegisters[8], u32 replicationMask) noexcept;
+
+struct ThreadedOp final
+{
+    ThreadedOpHandler Handler;
+    u64 NextInstructionPointer;
+    InstructionDecodeData::InstructionData Data;
+};
+
+struct ThreadedBlock final
+{
+    static inline constexpr u32 MAX_OP_COUNT = 16;
+
+    u64 InstructionPointer;
+    u32 Epoch;
+    u32 OpCount;
+    ThreadedOp Ops[MAX_OP_COUNT];
+};
+
+/**
+ * \brief Picks the specialized handler for a decoded instruction.
+ *
+ *   This is a threaded block interpreter, no host code is generated.
+ * Straight line runs of LoadImmediate, LoadStore and FPU binary ops are
+ * decoded once into a block of handler pointers, each handler compiled
+ * ahead of time for a specific operation, precision and element count.
+ * Running a block calls them in turn without going back through decode
+ * or the instruction switch. Anything else ends the block and is left to
+ * the switch interpreter.
+ *
+ * \return The handler, or nullptr if the instruction has none.
+ */
+[[nodiscard]] ThreadedOpHandler SelectThreadedOpHandler(EInstruction instruction, const InstructionDecodeData::InstructionData& data) noexcept;
+
+/**
+ * \brief A direct mapped cache of threaded blocks, keyed by the instruction pointer of their first instruction.
+ *
+ *   Blocks are tagged with the epoch of the SM's decoded instruction
+ * cache, so they are invalidated by exactly the same events.
+ */
+class ThreadedBlockCache final
+{
+    DEFAULT_DESTRUCT(ThreadedBlockCache);
+    DELETE_CM(ThreadedBlockCache);
+public:
+    static inline constexpr uSys ENTRY_COUNT = 64;
+public:
+    ThreadedBlockCache() noexcept
+        : m_Blocks { }
+    { }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Blocks, 0, sizeof(m_Blocks));
+    }
+
+    [[nodiscard]] const ThreadedBlock* Lookup(const u64 instructionPointer, const u32 epoch) const noexcept
+    {
+        const ThreadedBlock& block = m_Blocks[instructionPointer % ENTRY_COUNT];
+
+        // A block with no ops is kept as well, it records that the first instruction has no handler.
+        if(block.Epoch != epoch || block.InstructionPointer != instructionPointer)
+        {
+            return nullptr;
+        }
+
+        return &block;
+    }
+
+    [[nodiscard]] ThreadedBlock& Allocate(const u64 instructionPointer, const u32 epoch) noexcept
+    {
+        ThreadedBlock& block = m_Blocks[instructionPointer % ENTRY_COUNT];
+        block.InstructionPointer = instructionPointer;
+        block.Epoch = epoch;
+        block.OpCount = 0;
+        return block;
+    }
+private:
+    ThreadedBlock m_Blocks[ENTRY_COUNT];
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include "Cache.hpp"
+
+#include <atomic>
+
+class Processor;
+
+struct WriteCombiningStatistics final
+{
+    // Stores that went into the buffer.
+    u64 Stores;
+    // Writes the buffer made to memory, one per contiguous run of words.
+    u64 MemoryWrites;
+};
+
+/**
+ * \brief Merges an SM's write-through and uncached stores into line sized memory writes.
+ *
+ *   Each entry covers one line. An uncached store keeps its word in the
+ * entry until the entry drains, then contiguous words are written to
+ * memory together. A write-through store has already been written to
+ * the L0, its entry only remembers that the line still owes memory a
+ * write, which the drain makes by flushing the line. If another SM takes
+ * the line in the meantime the data goes with it, the drain then flushes
+ * it from that SM's L0, so memory still sees the store and a late drain
+ * never overwrites newer data.
+ *
+ *   Entries drain once every word of the line has been written, when
+ * the entry is needed for another line, TIMEOUT_CYCLES after the first
+ * store, and at the fences (FlushCache and Hlt). An SM with buffered
+ * stores isn't idle, so the timeout is kept while nothing runs. Uncached accesses
+ * from any SM drain the line they touch from every SM's buffer first,
+ * as do host BAR1 accesses.
+ *
+ *   Other SMs and the host only ever drain uncached entries. SMs do so
+ * while they hold the shared memory and the host between cycles, so the
+ * owner only races them on the valid mask.
+ */
+class WriteCombiningBuffer final
+{
+    DEFAULT_DESTRUCT(WriteCombiningBuffer);
+    DELETE_CM(WriteCombiningBuffer);
+public:
+    static inline constexpr u32 ENTRY_COUNT = 4;
+    static inline constexpr u64 TIMEOUT_CYCLES = 64;
+
+    static inline constexpr u32 FULL_WORD_MASK = (1u << CACHE_LINE_WORD_COUNT) - 1;
+public:
+    WriteCombiningBuffer(Processor* const processor, const u32 smIndex) noexcept
+        : m_Processor(processor)
+        , m_SMIndex(smIndex)
+        , m_Entries{ }
+        , m_ValidMask(0)
+        , m_Statistics{ }
+    { }
+
+    // Drops anything still buffered.
+    void Reset() noexcept
+    {
+        m_ValidMask.store(0, ::std::memory_order_relaxed);
+        m_Statistics = { };
+    }
+
+    // A write-through store must already have been written to the L0.
+    void Write(u64 address, u32 value, bool external, bool writeThrough, u64 cycle) noexcept;
+
+    // Drains any stores to the line, so a read from memory sees them.
+    void DrainLine(u64 address, bool external) noexcept;
+    // Drains uncached stores to the line on behalf of another SM or the host, write-through stores are already visible in the L0.
+    void DrainUncachedLine(u64 address, bool external) noexcept;
+    void DrainExpired(u64 cycle) noexcept;
+    void DrainAll() noexcept;
+
+    [[nodiscard]] bool HasExpired(const u64 cycle) const noexcept
+    {
+        for(u32 validMask = ValidMask(); validMask != 0; validMask &= validMask - 1)
+        {
+            if(m_Entries[_tzcnt_u32(validMask)].Deadline <= cycle)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // May be called from any thread.
+    [[nodiscard]] bool HasPending() const noexcept { return ValidMask() != 0; }
+    [[nodiscard]] const WriteCombiningStatistics& Statistics() const noexcept { return m_Statistics; }
+private:
+    struct Entry final
+    {
+        u64 LineAddress;
+        u64 Deadline;
+        u32 Data[CACHE_LINE_WORD_COUNT];
+        u32 WordMask;
+        bool External;
+        bool WriteThrough;
+    };
+
+    void Drain(u32 entryIndex) noexcept;
+
+    [[nodiscard]] u32 ValidMask() const noexcept { return m_ValidMask.load(::std::memory_order_relaxed); }
+
+    // Whoever holds the shared memory is the only writer, so this needs no read-modify-write.
+    void SetValidMask(const u32 validMask) noexcept { m_ValidMask.store(validMask, ::std::memory_order_relaxed); }
+private:
+    Processor* m_Processor;
+    u32 m_SMIndex;
+    Entry m_Entries[ENTRY_COUNT];
+    ::std::atomic<u32> m_ValidMask;
+    WriteCombiningStatistics m_Statistics;
+};
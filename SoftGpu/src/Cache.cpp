@@ -1,18 +1,101 @@
 #include "Cache.hpp"
 #include "Processor.hpp"
 
-void CacheController::ReadCacheLine(const u64 address, u32 data[8], const bool external) noexcept
+void CacheController::ReadMemoryLine(const u64 address, u32 data[8], const bool external) noexcept
 {
-    for(uSys i = 0; i < 8; ++i)
+    m_Processor->MemReadPhyBlock(address, data, CACHE_LINE_WORD_COUNT, external);
+}
+
+void CacheController::WriteMemoryLine(const u64 address, const u32 data[8], const bool external) noexcept
+{
+    m_Processor->MemWritePhyBlock(address, data, CACHE_LINE_WORD_COUNT, external);
+}
+
+void CacheController::TrainPrefetcher(const u32 requestorLine, const u64 address, const bool external, const bool prefetchHit, const ECacheHint hint) noexcept
+{
+    StridePrefetcher& prefetcher = m_Prefetchers[requestorLine];
+    // Lines fetched ahead of a streaming access are streamed too, keep is left to demand.
+    const ECacheHint prefetchHint = hint == ECacheHint::Streaming ? ECacheHint::Streaming : ECacheHint::Normal;
+
+    u64 lines[StridePrefetcher::MAX_DEGREE];
+    const u32 lineCount = prefetcher.Train(address >> 3, external, prefetchHit, lines);
+
+    for(u32 i = 0; i < lineCount; ++i)
+    {
+        // Prefetches are dropped once the SM has no MSHR to spare for them.
+        if(!m_Processor->CanTrackL0Prefetch(requestorLine))
+        {
+            break;
+        }
+
+        const u64 lineAddress = lines[i] << 3;
+
+        ECacheLevel servedBy;
+        if(m_L0Caches[requestorLine].PrefetchLine(lineAddress, external, &servedBy, prefetchHint))
+        {
+            prefetcher.OnPrefetchIssued();
+            m_Processor->TrackL0Prefetch(requestorLine, lineAddress, external, servedBy);
+        }
+    }
+}
+
+void CacheController::HostRead(const u64 address, u32* const data, const u64 wordCount, const bool external) noexcept
+{
+    if(!m_L2Cache.MayHold(address, wordCount))
+    {
+        m_Processor->MemReadPhyBlock(address, data, wordCount, external);
+        return;
+    }
+
+    const u64 endAddress = address + wordCount;
+    // The start of the words not yet read, they are read from memory together once a cached line ends the run.
+    u64 runStart = address;
+
+    for(u64 word = address; word < endAddress;)
+    {
+        const u64 lineAddress = word & ~static_cast<u64>(CACHE_LINE_WORD_COUNT - 1);
+        const u64 lineEnd = lineAddress + CACHE_LINE_WORD_COUNT < endAddress ? lineAddress + CACHE_LINE_WORD_COUNT : endAddress;
+
+        u32 lineData[CACHE_LINE_WORD_COUNT];
+        if(m_L2Cache.HostReadLine(lineAddress, external, lineData))
+        {
+            if(runStart != word)
+            {
+                m_Processor->MemReadPhyBlock(runStart, data + (runStart - address), word - runStart, external);
+            }
+
+            (void) ::std::memcpy(data + (word - address), lineData + (word - lineAddress), (lineEnd - word) * sizeof(u32));
+            runStart = lineEnd;
+        }
+
+        word = lineEnd;
+    }
+
+    if(runStart != endAddress)
     {
-        data[i] = m_Processor->MemReadPhy(address + i, external);
+        m_Processor->MemReadPhyBlock(runStart, data + (runStart - address), endAddress - runStart, external);
     }
 }
 
-void CacheController::WriteCacheLine(const u64 address, const u32 data[8], const bool external) noexcept
+void CacheController::HostWrite(const u64 address, const u32* const data, const u64 wordCount, const bool external) noexcept
 {
-    for(uSys i = 0; i < 8; ++i)
+    // Memory always takes the write, so only the lines still cached need updating.
+    m_Processor->MemWritePhyBlock(address, data, wordCount, external);
+
+    if(!m_L2Cache.MayHold(address, wordCount))
+    {
+        return;
+    }
+
+    const u64 endAddress = address + wordCount;
+
+    for(u64 word = address; word < endAddress;)
     {
-        m_Processor->MemWritePhy(address + i, data[i], external);
+        const u64 lineAddress = word & ~static_cast<u64>(CACHE_LINE_WORD_COUNT - 1);
+        const u64 lineEnd = lineAddress + CACHE_LINE_WORD_COUNT < endAddress ? lineAddress + CACHE_LINE_WORD_COUNT : endAddress;
+
+        (void) m_L2Cache.HostWriteLine(lineAddress, external, word - lineAddress, data + (word - address), lineEnd - word);
+
+        word = lineEnd;
     }
 }
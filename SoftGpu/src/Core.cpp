@@ -11,6 +11,21 @@ void FpCore::InvokeRegisterFileLow(const RegisterFile::CommandPacket packet) noe
     m_SM->InvokeRegisterFileLow(m_UnitIndex & 0x2, packet);
 }
 
+u32 FpCore::GetRegister(const u32 registerIndex) const noexcept
+{
+    return m_SM->GetRegister(registerIndex);
+}
+
+void FpCore::SetRegister(const u32 registerIndex, const u32 value) noexcept
+{
+    m_SM->SetRegister(registerIndex, value);
+}
+
+void FpCore::ReleaseRegisterContestation(const u32 registerIndex) noexcept
+{
+    m_SM->ReleaseRegisterContestation(registerIndex);
+}
+
 void FpCore::ReportReady() const noexcept
 {
     m_SM->ReportFpCoreReady(m_UnitIndex);
@@ -26,6 +41,21 @@ void IntFpCore::InvokeRegisterFileLow(const RegisterFile::CommandPacket packet)
     m_SM->InvokeRegisterFileLow(m_UnitIndex & 0x2, packet);
 }
 
+u32 IntFpCore::GetRegister(const u32 registerIndex) const noexcept
+{
+    return m_SM->GetRegister(registerIndex);
+}
+
+void IntFpCore::SetRegister(const u32 registerIndex, const u32 value) noexcept
+{
+    m_SM->SetRegister(registerIndex, value);
+}
+
+void IntFpCore::ReleaseRegisterContestation(const u32 registerIndex) noexcept
+{
+    m_SM->ReleaseRegisterContestation(registerIndex);
+}
+
 void IntFpCore::ReportReady() const noexcept
 {
     m_SM->ReportIntFpCoreReady(m_UnitIndex);
@@ -71,85 +71,43 @@ void CoreRegisterManager::RegisterRead() noexcept
     {
         return;
     }
-            // TODO: FIX
-    //
-    // if(m_Read64Bit)
-    // {
-    //     RegisterFile::CommandPacket packetHigh;
-    //     packetHigh.Command = RegisterFile::ECommand::ReadRegister;
-    //     packetHigh.Successful = &m_SuccessfulHigh;
-    //     packetHigh.Unsuccessful = &m_UnsuccessfulHigh;
-    //
-    //     RegisterFile::CommandPacket packetLow;
-    //     packetLow.Command = RegisterFile::ECommand::ReadRegister;
-    //     packetLow.Successful = &m_SuccessfulLow;
-    //     packetLow.Unsuccessful = &m_UnsuccessfulLow;
-    //
-    //     // Does the base register start at high?
-    //     if(m_RegisterReadA & 0x1)
-    //     {
-    //         packetHigh.TargetRegister = (m_RegisterReadA + 1u) >> 1u;
-    //         packetLow.TargetRegister = (m_RegisterReadA + 1u) >> 1u;
-    //
-    //         packetHigh.Value = &m_BaseAddressLow;
-    //         packetLow.Value = &m_BaseAddressHigh;
-    //     }
-    //     // The base register starts at low
-    //     else
-    //     {
-    //         packetHigh.TargetRegister = m_RegisterReadA >> 1u;
-    //         packetLow.TargetRegister = m_RegisterReadA >> 1u;
-    //
-    //         packetHigh.Value = &m_BaseAddressHigh;
-    //         packetLow.Value = &m_BaseAddressLow;
-    //     }
-    //
-    //     m_Core->InvokeRegisterFileHigh(packetHigh);
-    //     m_Core->InvokeRegisterFileLow(packetLow);
-    //
-    //     const u32 aLow = m_Core->GetRegister(m_RegisterReadA);
-    //     const u32 aHigh = m_Core->GetRegister(m_RegisterReadA + 1);
-    //
-    //     const u64 a = (static_cast<u64>(aHigh) << 32) | aLow;
-    //     u64 b = 0;
-    //     u64 c = 0;
-    //
-    //     if(m_RegisterReadEnabledCount >= 1u)
-    //     {
-    //         const u32 bLow = m_Core->GetRegister(m_RegisterReadB);
-    //         const u32 bHigh = m_Core->GetRegister(m_RegisterReadB + 1);
-    //
-    //         b = (static_cast<u64>(bHigh) << 32) | bLow;
-    //
-    //         if(m_RegisterReadEnabledCount >= 2u)
-    //         {
-    //             const u32 cLow = m_Core->GetRegister(m_RegisterReadC);
-    //             const u32 cHigh = m_Core->GetRegister(m_RegisterReadC + 1);
-    //
-    //             c = (static_cast<u64>(cHigh) << 32) | cLow;
-    //         }
-    //     }
-    //
-    //     m_Core->ReportRegisterValues(a, b, c);
-    // }
-    // else
-    // {
-    //     const u64 a = m_Core->GetRegister(m_RegisterReadA);
-    //     u64 b = 0;
-    //     u64 c = 0;
-    //
-    //     if(m_RegisterReadEnabledCount >= 1u)
-    //     {
-    //         b = m_Core->GetRegister(m_RegisterReadB);
-    //
-    //         if(m_RegisterReadEnabledCount >= 2u)
-    //         {
-    //             c = m_Core->GetRegister(m_RegisterReadC);
-    //         }
-    //     }
-    //
-    //     m_Core->ReportRegisterValues(a, b, c);
-    // }
+
+    if(m_Read64Bit)
+    {
+        const u64 a = ReadRegister64(m_RegisterReadA);
+        u64 b = 0;
+        u64 c = 0;
+
+        if(m_RegisterReadEnabledCount >= 1u)
+        {
+            b = ReadRegister64(m_RegisterReadB);
+
+            if(m_RegisterReadEnabledCount >= 2u)
+            {
+                c = ReadRegister64(m_RegisterReadC);
+            }
+        }
+
+        m_Core->ReportRegisterValues(a, b, c);
+    }
+    else
+    {
+        const u64 a = m_Core->GetRegister(m_RegisterReadA);
+        u64 b = 0;
+        u64 c = 0;
+
+        if(m_RegisterReadEnabledCount >= 1u)
+        {
+            b = m_Core->GetRegister(m_RegisterReadB);
+
+            if(m_RegisterReadEnabledCount >= 2u)
+            {
+                c = m_Core->GetRegister(m_RegisterReadC);
+            }
+        }
+
+        m_Core->ReportRegisterValues(a, b, c);
+    }
 }
 
 void CoreRegisterManager::ReadLockRelease() noexcept
@@ -158,39 +116,35 @@ void CoreRegisterManager::ReadLockRelease() noexcept
     {
         return;
     }
-            // TODO: FIX
-    //
-    // if(m_ReadLock64Bit)
-    // {
-    //     m_Core->ReleaseRegisterContestation(m_RegisterReadA);
-    //     m_Core->ReleaseRegisterContestation(m_RegisterReadA + 1);
-    //
-    //     if(m_RegisterReadLockEnabledCount >= 1u)
-    //     {
-    //         m_Core->ReleaseRegisterContestation(m_RegisterReadB);
-    //         m_Core->ReleaseRegisterContestation(m_RegisterReadB + 1);
-    //
-    //         if(m_RegisterReadLockEnabledCount >= 2u)
-    //         {
-    //             m_Core->ReleaseRegisterContestation(m_RegisterReadC);
-    //             m_Core->ReleaseRegisterContestation(m_RegisterReadC + 1);
-    //         }
-    //     }
-    // }
-    // else
-    // {
-    //     m_Core->ReleaseRegisterContestation(m_RegisterReadA);
-    //
-    //     if(m_RegisterReadLockEnabledCount >= 1u)
-    //     {
-    //         m_Core->ReleaseRegisterContestation(m_RegisterReadB);
-    //
-    //         if(m_RegisterReadLockEnabledCount >= 2u)
-    //         {
-    //             m_Core->ReleaseRegisterContestation(m_RegisterReadC);
-    //         }
-    //     }
-    // }
+
+    m_RegisterReadLockReleaseReady = false;
+
+    m_Core->ReleaseRegisterContestation(m_RegisterReadLockA);
+
+    if(m_ReadLock64Bit)
+    {
+        m_Core->ReleaseRegisterContestation(m_RegisterReadLockA + 1);
+    }
+
+    if(m_RegisterReadLockEnabledCount >= 1u)
+    {
+        m_Core->ReleaseRegisterContestation(m_RegisterReadLockB);
+
+        if(m_ReadLock64Bit)
+        {
+            m_Core->ReleaseRegisterContestation(m_RegisterReadLockB + 1);
+        }
+
+        if(m_RegisterReadLockEnabledCount >= 2u)
+        {
+            m_Core->ReleaseRegisterContestation(m_RegisterReadLockC);
+
+            if(m_ReadLock64Bit)
+            {
+                m_Core->ReleaseRegisterContestation(m_RegisterReadLockC + 1);
+            }
+        }
+    }
 }
 
 void CoreRegisterManager::RegisterWrite() noexcept
@@ -199,20 +153,19 @@ void CoreRegisterManager::RegisterWrite() noexcept
     {
         return;
     }
-            // TODO: FIX
-    //
-    // if(m_Write64Bit)
-    // {
-    //     u32 words[2];
-    //     (void) ::std::memcpy(words, &m_RegisterWriteValue, sizeof(m_RegisterWriteValue));
-    //
-    //     m_Core->SetRegister(m_RegisterWrite, words[0]);
-    //     m_Core->SetRegister(m_RegisterWrite + 1, words[1]);
-    // }
-    // else
-    // {
-    //     m_Core->SetRegister(m_RegisterWrite, static_cast<u32>(m_RegisterWriteValue));
-    // }
+
+    if(m_Write64Bit)
+    {
+        u32 words[2];
+        (void) ::std::memcpy(words, &m_RegisterWriteValue, sizeof(m_RegisterWriteValue));
+
+        m_Core->SetRegister(m_RegisterWrite, words[0]);
+        m_Core->SetRegister(m_RegisterWrite + 1, words[1]);
+    }
+    else
+    {
+        m_Core->SetRegister(m_RegisterWrite, static_cast<u32>(m_RegisterWriteValue));
+    }
 }
 
 void CoreRegisterManager::WriteLockRelease() noexcept
@@ -221,12 +174,21 @@ void CoreRegisterManager::WriteLockRelease() noexcept
     {
         return;
     }
-            // TODO: FIX
-    //
-    // m_Core->ReleaseRegisterContestation(m_RegisterWrite);
-    //
-    // if(m_WriteLock64Bit)
-    // {
-    //     m_Core->ReleaseRegisterContestation(m_RegisterWrite + 1);
-    // }
+
+    m_RegisterWriteLockReleaseReady = false;
+
+    m_Core->ReleaseRegisterContestation(m_RegisterWriteLock);
+
+    if(m_WriteLock64Bit)
+    {
+        m_Core->ReleaseRegisterContestation(m_RegisterWriteLock + 1);
+    }
+}
+
+u64 CoreRegisterManager::ReadRegister64(const u32 registerIndex) const noexcept
+{
+    const u32 low = m_Core->GetRegister(registerIndex);
+    const u32 high = m_Core->GetRegister(registerIndex + 1);
+
+    return (static_cast<u64>(high) << 32) | low;
 }
@@ -1,6 +1,7 @@
 #include "DispatchUnit.hpp"
 #include "StreamingMultiprocessor.hpp"
 #include "LoadStore.hpp"
+#include "ThreadedBlockInterpreter.hpp"
 
 #include <cstring>
 
@@ -11,9 +12,9 @@ void DispatchUnit::ResetCycle() noexcept
     m_IsStalled = false;
     m_ClockIndex = 0;
     ++m_TotalIterationsTracker;
-    m_FpSaturationTracker += 8 - _mm_popcnt_u32(m_FpAvailabilityMap);
-    m_IntFpSaturationTracker += 8 - _mm_popcnt_u32(m_IntFpAvailabilityMap);
-    m_LdStSaturationTracker += 4 - _mm_popcnt_u32(m_LdStAvailabilityMap);
+    m_FpSaturationTracker += Topology.FpCoreCount - _mm_popcnt_u32(m_FpAvailabilityMap);
+    m_IntFpSaturationTracker += Topology.IntFpCoreCount - _mm_popcnt_u32(m_IntFpAvailabilityMap);
+    m_LdStSaturationTracker += Topology.LdStCount - _mm_popcnt_u32(m_LdStAvailabilityMap);
     m_TextureSaturationTracker += 2 - _mm_popcnt_u32(m_TextureSamplerAvailabilityMap);
 }
 
@@ -34,92 +35,7 @@ void DispatchUnit::Clock() noexcept
 
     if(m_NeedToDecode)
     {
-        u64 localInstructionPointer = m_InstructionPointer;
-
-        u32 wordIndex = localInstructionPointer & 0x3;
-
-        u8 instructionBytes[4];
-        {
-            const u64 wordAddress = localInstructionPointer >> 2;
-            const u32 instructionWord = m_SM->Read(wordAddress);
-            (void) ::std::memcpy(instructionBytes, &instructionWord, sizeof(instructionWord));
-        }
-
-        m_CurrentInstruction = static_cast<EInstruction>(instructionBytes[wordIndex]);
-
-        switch(m_CurrentInstruction)
-        {
-            case EInstruction::LoadStore: DecodeLdSt(localInstructionPointer, wordIndex, instructionBytes); break;
-            case EInstruction::LoadImmediate: DecodeLoadImmediate(localInstructionPointer, wordIndex, instructionBytes); break;
-            case EInstruction::LoadZero: DecodeLoadZero(localInstructionPointer, wordIndex, instructionBytes); break;
-            case EInstruction::WriteStatistics: DecodeWriteStatistics(localInstructionPointer, wordIndex, instructionBytes); break;
-            case EInstruction::AddF:
-            case EInstruction::AddVec2F:
-            case EInstruction::AddVec3F:
-            case EInstruction::AddVec4F:
-            case EInstruction::AddH:
-            case EInstruction::AddVec2H:
-            case EInstruction::AddVec3H:
-            case EInstruction::AddVec4H:
-            case EInstruction::AddD:
-            case EInstruction::AddVec2D:
-            case EInstruction::AddVec3D:
-            case EInstruction::AddVec4D:
-            case EInstruction::SubF:
-            case EInstruction::SubVec2F:
-            case EInstruction::SubVec3F:
-            case EInstruction::SubVec4F:
-            case EInstruction::SubH:
-            case EInstruction::SubVec2H:
-            case EInstruction::SubVec3H:
-            case EInstruction::SubVec4H:
-            case EInstruction::SubD:
-            case EInstruction::SubVec2D:
-            case EInstruction::SubVec3D:
-            case EInstruction::SubVec4D:
-            case EInstruction::MulF:
-            case EInstruction::MulVec2F:
-            case EInstruction::MulVec3F:
-            case EInstruction::MulVec4F:
-            case EInstruction::MulH:
-            case EInstruction::MulVec2H:
-            case EInstruction::MulVec3H:
-            case EInstruction::MulVec4H:
-            case EInstruction::MulD:
-            case EInstruction::MulVec2D:
-            case EInstruction::MulVec3D:
-            case EInstruction::MulVec4D:
-            case EInstruction::DivF:
-            case EInstruction::DivVec2F:
-            case EInstruction::DivVec3F:
-            case EInstruction::DivVec4F:
-            case EInstruction::DivH:
-            case EInstruction::DivVec2H:
-            case EInstruction::DivVec3H:
-            case EInstruction::DivVec4H:
-            case EInstruction::DivD:
-            case EInstruction::DivVec2D:
-            case EInstruction::DivVec3D:
-            case EInstruction::DivVec4D:
-            case EInstruction::RemF:
-            case EInstruction::RemVec2F:
-            case EInstruction::RemVec3F:
-            case EInstruction::RemVec4F:
-            case EInstruction::RemH:
-            case EInstruction::RemVec2H:
-            case EInstruction::RemVec3H:
-            case EInstruction::RemVec4H:
-            case EInstruction::RemD:
-            case EInstruction::RemVec2D:
-            case EInstruction::RemVec3D:
-            case EInstruction::RemVec4D:
-                DecodeFpuBinOp(localInstructionPointer, wordIndex, instructionBytes);
-                break;
-            default: break;
-        }
-
-        m_InstructionPointer = localInstructionPointer + 1;
-        m_NeedToDecode = false;
+        Decode();
         return;
     }
 
@@ -161,7 +77,9 @@ void DispatchUnit::Clock() noexcept
 
     switch(m_CurrentInstruction)
     {
-        case EInstruction::Nop: break;
+        case EInstruction::Nop:
+            m_ReplicationCompletedMask |= 1 << replicationIndex;
+            break;
         case EInstruction::Hlt:
         {
             switch(replicationIndex)
@@ -188,6 +106,8 @@ void DispatchUnit::Clock() noexcept
             if(m_ReplicationMask == 0x0u)
             {
                 m_IsStalled = true;
+                m_SM->WriteBackPageEntries();
+                m_SM->DrainWriteCombiner();
             }
 
             break;
@@ -205,6 +125,7 @@ void DispatchUnit::Clock() noexcept
             //     }
             // }
             m_SM->FlushCache();
+            m_ReplicationCompletedMask |= 1 << replicationIndex;
             break;
         case EInstruction::ResetStatistics:
         {
@@ -213,6 +134,7 @@ void DispatchUnit::Clock() noexcept
             m_LdStSaturationTracker = 0;
             m_TextureSaturationTracker = 0;
             m_TotalIterationsTracker = 0;
+            m_ReplicationCompletedMask |= 1 << replicationIndex;
             break;
         }
         case EInstruction::WriteStatistics: DispatchWriteStatistics(replicationIndex); break;
@@ -292,6 +214,254 @@ void DispatchUnit::Clock() noexcept
     }
 }
 
+void DispatchUnit::ExecuteFunctional() noexcept
+{
+    if(!m_InstructionPointer)
+    {
+        return;
+    }
+
+    // A halted warp sits on its Hlt instruction, the same as in the cycle model.
+    if(!m_NeedToDecode && m_CurrentInstruction == EInstruction::Hlt)
+    {
+        return;
+    }
+
+    if(m_NeedToDecode)
+    {
+        if(m_SM->BlockInterpreter() && ExecuteThreadedBlock())
+        {
+            return;
+        }
+
+        Decode();
+    }
+
+    // Without a replication mask only replication 0 executes.
+    const u32 replicationMask = m_ReplicationMask != 0x0u ? static_cast<u32>(m_ReplicationMask) : 0x1u;
+
+    if(m_CurrentInstruction == EInstruction::Hlt)
+    {
+        m_ReplicationMask = 0x0;
+        m_ReplicationCompletedMask = 0x0;
+        m_SM->WriteBackPageEntries();
+        m_SM->DrainWriteCombiner();
+        return;
+    }
+
+    // Loads, stores and FPU ops share their handlers with the threaded block interpreter.
+    if(const ThreadedOpHandler handler = SelectThreadedOpHandler(m_CurrentInstruction, m_DecodedInstructionData))
+    {
+        handler(m_SM, m_DecodedInstructionData, m_BaseRegisters, replicationMask);
+
+        m_ReplicationCompletedMask = 0x0;
+        m_NeedToDecode = true;
+        return;
+    }
+
+    for(u32 replicationIndex = 0; replicationIndex < 8; ++replicationIndex)
+    {
+        if((replicationMask & (1u << replicationIndex)) == 0x0u)
+        {
+            continue;
+        }
+
+        switch(m_CurrentInstruction)
+        {
+            case EInstruction::LoadZero:
+                for(u32 i = 0; i < m_DecodedInstructionData.LoadZero.RegisterCount + 1u; ++i)
+                {
+                    SetRegister(m_DecodedInstructionData.LoadZero.StartRegister + i, replicationIndex, 0);
+                }
+                break;
+            case EInstruction::FlushCache: m_SM->FlushCache(); break;
+            case EInstruction::ResetStatistics:
+                m_FpSaturationTracker = 0;
+                m_IntFpSaturationTracker = 0;
+                m_LdStSaturationTracker = 0;
+                m_TextureSaturationTracker = 0;
+                m_TotalIterationsTracker = 0;
+                break;
+            case EInstruction::WriteStatistics: ExecuteWriteStatisticsFunctional(replicationIndex); break;
+            default: break;
+        }
+    }
+
+    m_ReplicationCompletedMask = 0x0;
+    m_NeedToDecode = true;
+}
+
+bool DispatchUnit::ExecuteThreadedBlock() noexcept
+{
+    const ThreadedBlock* block = m_SM->LookupThreadedBlock(m_InstructionPointer);
+
+    if(!block)
+    {
+        block = &BuildThreadedBlock();
+    }
+
+    // The first instruction has no handler, leave it to the switch interpreter.
+    if(block->OpCount == 0)
+    {
+        return false;
+    }
+
+    const u32 replicationMask = m_ReplicationMask != 0x0u ? static_cast<u32>(m_ReplicationMask) : 0x1u;
+    const u32 epoch = m_SM->DecodeEpoch();
+
+    for(u32 i = 0; i < block->OpCount; ++i)
+    {
+        const ThreadedOp& op = block->Ops[i];
+
+        op.Handler(m_SM, op.Data, m_BaseRegisters, replicationMask);
+
+        m_InstructionPointer = op.NextInstructionPointer;
+
+        // A store hit the code we're running, anything past this point has to be decoded again.
+        if(m_SM->DecodeEpoch() != epoch)
+        {
+            break;
+        }
+    }
+
+    m_ReplicationCompletedMask = 0x0;
+    m_NeedToDecode = true;
+    return true;
+}
+
+const ThreadedBlock& DispatchUnit::BuildThreadedBlock() noexcept
+{
+    const u64 startInstructionPointer = m_InstructionPointer;
+
+    ThreadedBlock& block = m_SM->AllocateThreadedBlock(startInstructionPointer);
+
+    while(block.OpCount < ThreadedBlock::MAX_OP_COUNT)
+    {
+        Decode();
+
+        const ThreadedOpHandler handler = SelectThreadedOpHandler(m_CurrentInstruction, m_DecodedInstructionData);
+
+        if(!handler)
+        {
+            break;
+        }
+
+        ThreadedOp& op = block.Ops[block.OpCount++];
+        op.Handler = handler;
+        op.NextInstructionPointer = m_InstructionPointer;
+        op.Data = m_DecodedInstructionData;
+    }
+
+    // Decoding only looked ahead, nothing has executed yet.
+    m_InstructionPointer = startInstructionPointer;
+    m_NeedToDecode = true;
+
+    return block;
+}
+
+void DispatchUnit::Decode() noexcept
+{
+    if(const DecodedInstruction* const decoded = m_SM->LookupDecodedInstruction(m_InstructionPointer))
+    {
+        m_CurrentInstruction = decoded->Instruction;
+        m_DecodedInstructionData = decoded->Data;
+        m_InstructionPointer = decoded->NextInstructionPointer;
+        m_VectorOpIndex = 0;
+        m_NeedToDecode = false;
+        return;
+    }
+
+    const u64 instructionPointer = m_InstructionPointer;
+    u64 localInstructionPointer = m_InstructionPointer;
+
+    u32 wordIndex = localInstructionPointer & 0x3;
+
+    u8 instructionBytes[4];
+    {
+        const u64 wordAddress = localInstructionPointer >> 2;
+        const u32 instructionWord = m_SM->ReadInstruction(wordAddress);
+        (void) ::std::memcpy(instructionBytes, &instructionWord, sizeof(instructionWord));
+    }
+
+    m_CurrentInstruction = static_cast<EInstruction>(instructionBytes[wordIndex]);
+
+    switch(m_CurrentInstruction)
+    {
+        case EInstruction::LoadStore: DecodeLdSt(localInstructionPointer, wordIndex, instructionBytes); break;
+        case EInstruction::LoadImmediate: DecodeLoadImmediate(localInstructionPointer, wordIndex, instructionBytes); break;
+        case EInstruction::LoadZero: DecodeLoadZero(localInstructionPointer, wordIndex, instructionBytes); break;
+        case EInstruction::WriteStatistics: DecodeWriteStatistics(localInstructionPointer, wordIndex, instructionBytes); break;
+        case EInstruction::AddF:
+        case EInstruction::AddVec2F:
+        case EInstruction::AddVec3F:
+        case EInstruction::AddVec4F:
+        case EInstruction::AddH:
+        case EInstruction::AddVec2H:
+        case EInstruction::AddVec3H:
+        case EInstruction::AddVec4H:
+        case EInstruction::AddD:
+        case EInstruction::AddVec2D:
+        case EInstruction::AddVec3D:
+        case EInstruction::AddVec4D:
+        case EInstruction::SubF:
+        case EInstruction::SubVec2F:
+        case EInstruction::SubVec3F:
+        case EInstruction::SubVec4F:
+        case EInstruction::SubH:
+        case EInstruction::SubVec2H:
+        case EInstruction::SubVec3H:
+        case EInstruction::SubVec4H:
+        case EInstruction::SubD:
+        case EInstruction::SubVec2D:
+        case EInstruction::SubVec3D:
+        case EInstruction::SubVec4D:
+        case EInstruction::MulF:
+        case EInstruction::MulVec2F:
+        case EInstruction::MulVec3F:
+        case EInstruction::MulVec4F:
+        case EInstruction::MulH:
+        case EInstruction::MulVec2H:
+        case EInstruction::MulVec3H:
+        case EInstruction::MulVec4H:
+        case EInstruction::MulD:
+        case EInstruction::MulVec2D:
+        case EInstruction::MulVec3D:
+        case EInstruction::MulVec4D:
+        case EInstruction::DivF:
+        case EInstruction::DivVec2F:
+        case EInstruction::DivVec3F:
+        case EInstruction::DivVec4F:
+        case EInstruction::DivH:
+        case EInstruction::DivVec2H:
+        case EInstruction::DivVec3H:
+        case EInstruction::DivVec4H:
+        case EInstruction::DivD:
+        case EInstruction::DivVec2D:
+        case EInstruction::DivVec3D:
+        case EInstruction::DivVec4D:
+        case EInstruction::RemF:
+        case EInstruction::RemVec2F:
+        case EInstruction::RemVec3F:
+        case EInstruction::RemVec4F:
+        case EInstruction::RemH:
+        case EInstruction::RemVec2H:
+        case EInstruction::RemVec3H:
+        case EInstruction::RemVec4H:
+        case EInstruction::RemD:
+        case EInstruction::RemVec2D:
+        case EInstruction::RemVec3D:
+        case EInstruction::RemVec4D:
+            DecodeFpuBinOp(localInstructionPointer, wordIndex, instructionBytes);
+            break;
+        default: break;
+    }
+
+    m_InstructionPointer = localInstructionPointer + 1;
+    m_NeedToDecode = false;
+
+    m_SM->InsertDecodedInstruction(instructionPointer, m_InstructionPointer, m_CurrentInstruction, m_DecodedInstructionData);
+}
+
 void DispatchUnit::NextInstruction(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) const noexcept
 {
     ++localInstructionPointer;
@@ -301,47 +471,41 @@ void DispatchUnit::NextInstruction(u64& localInstructionPointer, u32& wordIndex,
     if(wordIndex == 0)
     {
         const u64 wordAddress = localInstructionPointer >> 2;
-        const u32 instructionWord = m_SM->Read(wordAddress);
+        const u32 instructionWord = m_SM->ReadInstruction(wordAddress);
         (void) ::std::memcpy(instructionBytes, &instructionWord, sizeof(instructionWord));
     }
 }
 
 bool DispatchUnit::CanReadRegister(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-            // TODO: FIX
-    // return m_SM->CanReadRegister(m_BaseRegisters[replicationIndex] + registerIndex);
-    return false;
+    return m_SM->CanReadRegister(m_BaseRegisters[replicationIndex] + registerIndex);
 }
 
 bool DispatchUnit::CanWriteRegister(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-            // TODO: FIX
-    // return m_SM->CanWriteRegister(m_BaseRegisters[replicationIndex] + registerIndex);
-    return false;
+    return m_SM->CanWriteRegister(m_BaseRegisters[replicationIndex] + registerIndex);
 }
 
 void DispatchUnit::ReleaseRegisterContestation(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-            // TODO: FIX
-    // m_SM->ReleaseRegisterContestation(m_BaseRegisters[replicationIndex] + registerIndex);
+    m_SM->ReleaseRegisterContestation(m_BaseRegisters[replicationIndex] + registerIndex);
 }
 
 void DispatchUnit::LockRegisterRead(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-            // TODO: FIX
-    // m_SM->LockRegisterRead(m_BaseRegisters[replicationIndex] + registerIndex);
+    m_SM->LockRegisterRead(m_BaseRegisters[replicationIndex] + registerIndex);
 }
 
 void DispatchUnit::LockRegisterWrite(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-            // TODO: FIX
-    // m_SM->LockRegisterWrite(m_BaseRegisters[replicationIndex] + registerIndex);
+    m_SM->LockRegisterWrite(m_BaseRegisters[replicationIndex] + registerIndex);
 }
 
 void DispatchUnit::DecodeLdSt(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept
 {
     NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
 
+    const u32 hasCacheHint = (instructionBytes[wordIndex] >> 7) & 0x1;
     const u32 readWrite = (instructionBytes[wordIndex] >> 6) & 0x1;
     const u32 indexExponent = (instructionBytes[wordIndex] >> 3) & 0x7;
     const u32 registerCount = instructionBytes[wordIndex] & 0x7;
@@ -373,6 +537,16 @@ void DispatchUnit::DecodeLdSt(u64& localInstructionPointer, u32& wordIndex, u8 i
 
     const i16 offset = static_cast<i16>((static_cast<u16>(offsetHigh) << 8) | offsetLow);
 
+    u8 cacheHint = static_cast<u8>(ECacheHint::Normal);
+
+    if(hasCacheHint)
+    {
+        NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
+
+        // The upper bits are reserved.
+        cacheHint = instructionBytes[wordIndex] & 0x3;
+    }
+
     m_DecodedInstructionData.LoadStore.Pad = 0;
     m_DecodedInstructionData.LoadStore.ReadWrite = readWrite;
     m_DecodedInstructionData.LoadStore.IndexExponent = indexExponent;
@@ -381,6 +555,7 @@ void DispatchUnit::DecodeLdSt(u64& localInstructionPointer, u32& wordIndex, u8 i
     m_DecodedInstructionData.LoadStore.IndexRegister = indexRegister;;
     m_DecodedInstructionData.LoadStore.TargetRegister = targetRegister;
     m_DecodedInstructionData.LoadStore.Offset = offset;
+    m_DecodedInstructionData.LoadStore.CacheHint = cacheHint;
 }
 
 void DispatchUnit::DecodeLoadImmediate(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept
@@ -545,6 +720,7 @@ void DispatchUnit::DispatchLdSt(const u32 replicationIndex) noexcept
     instruction.BaseRegister = m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.LoadStore.BaseRegister;
     instruction.IndexRegister = m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.LoadStore.IndexRegister;
     instruction.TargetRegister = m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.LoadStore.TargetRegister;
+    instruction.CacheHint = m_DecodedInstructionData.LoadStore.CacheHint;
     instruction.Offset = m_DecodedInstructionData.LoadStore.Offset;
 
     m_SM->DispatchLdSt(ldStUnit, instruction);
@@ -560,8 +736,7 @@ void DispatchUnit::DispatchLoadImmediate(const u32 replicationIndex) noexcept
         return;
     }
 
-            // TODO: FIX
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.LoadImmediate.Register, m_DecodedInstructionData.LoadImmediate.Value);
+    SetRegister(m_DecodedInstructionData.LoadImmediate.Register, replicationIndex, m_DecodedInstructionData.LoadImmediate.Value);
     m_ReplicationCompletedMask |= 1 << replicationIndex;
 }
 
@@ -578,8 +753,7 @@ void DispatchUnit::DispatchLoadZero(const u32 replicationIndex) noexcept
 
     for(u32 i = 0; i < m_DecodedInstructionData.LoadZero.RegisterCount + 1u; ++i)
     {
-            // TODO: FIX
-        // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + static_cast<u32>(m_DecodedInstructionData.LoadZero.StartRegister) + i, 0);
+        SetRegister(m_DecodedInstructionData.LoadZero.StartRegister + i, replicationIndex, 0);
     }
 
     m_ReplicationCompletedMask |= 1 << replicationIndex;
@@ -614,9 +788,8 @@ void DispatchUnit::DispatchWriteStatistics(const u32 replicationIndex) noexcept
     u32 clockWords[2];
     (void) ::std::memcpy(clockWords, &m_TotalIterationsTracker, sizeof(m_TotalIterationsTracker));
 
-            // TODO: FIX
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.ClockStartRegister, clockWords[0]);
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.ClockStartRegister + 1, clockWords[1]);
+    SetRegister(m_DecodedInstructionData.WriteStatistics.ClockStartRegister, replicationIndex, clockWords[0]);
+    SetRegister(m_DecodedInstructionData.WriteStatistics.ClockStartRegister + 1, replicationIndex, clockWords[1]);
 
     u64 targetStatistic = 0;
     if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 0)
@@ -639,9 +812,8 @@ void DispatchUnit::DispatchWriteStatistics(const u32 replicationIndex) noexcept
     u32 statisticWords[2];
     (void) ::std::memcpy(statisticWords, &targetStatistic, sizeof(targetStatistic));
 
-            // TODO: FIX
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.StartRegister, statisticWords[0]);
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.StartRegister + 1, statisticWords[1]);
+    SetRegister(m_DecodedInstructionData.WriteStatistics.StartRegister, replicationIndex, statisticWords[0]);
+    SetRegister(m_DecodedInstructionData.WriteStatistics.StartRegister + 1, replicationIndex, statisticWords[1]);
 
     m_ReplicationCompletedMask |= 1 << replicationIndex;
 }
@@ -800,6 +972,44 @@ void DispatchUnit::DispatchFpuBinOp(const u32 replicationIndex) noexcept
     }
 }
 
+void DispatchUnit::SetRegister(const u32 registerIndex, const u32 replicationIndex, const u32 value) noexcept
+{
+    m_SM->SetRegister(m_BaseRegisters[replicationIndex] + registerIndex, value);
+}
+
+void DispatchUnit::ExecuteWriteStatisticsFunctional(const u32 replicationIndex) noexcept
+{
+    u32 clockWords[2];
+    (void) ::std::memcpy(clockWords, &m_TotalIterationsTracker, sizeof(m_TotalIterationsTracker));
+
+    SetRegister(m_DecodedInstructionData.WriteStatistics.ClockStartRegister, replicationIndex, clockWords[0]);
+    SetRegister(m_DecodedInstructionData.WriteStatistics.ClockStartRegister + 1, replicationIndex, clockWords[1]);
+
+    u64 targetStatistic = 0;
+    if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 0)
+    {
+        targetStatistic = m_FpSaturationTracker;
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 1)
+    {
+        targetStatistic = m_IntFpSaturationTracker;
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 2)
+    {
+        targetStatistic = m_LdStSaturationTracker;
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 3)
+    {
+        targetStatistic = m_TextureSaturationTracker;
+    }
+
+    u32 statisticWords[2];
+    (void) ::std::memcpy(statisticWords, &targetStatistic, sizeof(targetStatistic));
+
+    SetRegister(m_DecodedInstructionData.WriteStatistics.StartRegister, replicationIndex, statisticWords[0]);
+    SetRegister(m_DecodedInstructionData.WriteStatistics.StartRegister + 1, replicationIndex, statisticWords[1]);
+}
+
 static u32 GetElementCount(const EInstruction instruction) noexcept
 {
     switch(instruction)
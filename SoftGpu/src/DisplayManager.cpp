@@ -2,6 +2,12 @@
 #include "Processor.hpp"
 #include "PCIControlRegisters.hpp"
 
+void DisplayManager::SetDisplayVSyncEvent(const u32 display) noexcept
+{
+    m_VSyncEvent = display + 1;
+    m_Processor->RingDoorbell();
+}
+
 void DisplayManager::HandleVSyncEvent() noexcept
 {
     if(m_VSyncEvent > 0)
@@ -224,24 +224,22 @@ f32 Fpu::BasicBinOpF32(const f32 valueA, const f32 valueB, const EBinOp op) noex
     switch(op)
     {
         case EBinOp::Add:
-            m_ExecutionStage = 4;
-            return valueA + valueB;
         case EBinOp::Subtract:
             m_ExecutionStage = 4;
-            return valueA - valueB;
+            break;
         case EBinOp::Multiply:
             m_ExecutionStage = 5;
-            return valueA * valueB;
+            break;
         case EBinOp::Divide:
-            m_ExecutionStage = 6;
-            return valueA / valueB;
         case EBinOp::Remainder:
             m_ExecutionStage = 6;
-            return ::std::fmod(valueA, valueB);
+            break;
         default:
             m_ExecutionStage = 1;
-            return ::std::numeric_limits<f32>::quiet_NaN();
+            break;
     }
+
+    return EvaluateBinOp(valueA, valueB, op);
 }
 
 f64 Fpu::BasicBinOpF64(const f64 valueA, const f64 valueB, const EBinOp op) noexcept
@@ -249,23 +247,47 @@ f64 Fpu::BasicBinOpF64(const f64 valueA, const f64 valueB, const EBinOp op) noex
     switch(op)
     {
         case EBinOp::Add:
-            m_ExecutionStage = 8;
-            return valueA + valueB;
         case EBinOp::Subtract:
             m_ExecutionStage = 8;
-            return valueA - valueB;
+            break;
         case EBinOp::Multiply:
             m_ExecutionStage = 10;
-            return valueA * valueB;
+            break;
         case EBinOp::Divide:
-            m_ExecutionStage = 12;
-            return valueA / valueB;
         case EBinOp::Remainder:
             m_ExecutionStage = 12;
-            return ::std::fmod(valueA, valueB);
+            break;
         default:
             m_ExecutionStage = 1;
-            return ::std::numeric_limits<f64>::quiet_NaN();
+            break;
+    }
+
+    return EvaluateBinOp(valueA, valueB, op);
+}
+
+f32 Fpu::EvaluateBinOp(const f32 valueA, const f32 valueB, const EBinOp op) noexcept
+{
+    switch(op)
+    {
+        case EBinOp::Add: return EvaluateBinOp<EBinOp::Add>(valueA, valueB);
+        case EBinOp::Subtract: return EvaluateBinOp<EBinOp::Subtract>(valueA, valueB);
+        case EBinOp::Multiply: return EvaluateBinOp<EBinOp::Multiply>(valueA, valueB);
+        case EBinOp::Divide: return EvaluateBinOp<EBinOp::Divide>(valueA, valueB);
+        case EBinOp::Remainder: return EvaluateBinOp<EBinOp::Remainder>(valueA, valueB);
+        default: return ::std::numeric_limits<f32>::quiet_NaN();
+    }
+}
+
+f64 Fpu::EvaluateBinOp(const f64 valueA, const f64 valueB, const EBinOp op) noexcept
+{
+    switch(op)
+    {
+        case EBinOp::Add: return EvaluateBinOp<EBinOp::Add>(valueA, valueB);
+        case EBinOp::Subtract: return EvaluateBinOp<EBinOp::Subtract>(valueA, valueB);
+        case EBinOp::Multiply: return EvaluateBinOp<EBinOp::Multiply>(valueA, valueB);
+        case EBinOp::Divide: return EvaluateBinOp<EBinOp::Divide>(valueA, valueB);
+        case EBinOp::Remainder: return EvaluateBinOp<EBinOp::Remainder>(valueA, valueB);
+        default: return ::std::numeric_limits<f64>::quiet_NaN();
     }
 }
 
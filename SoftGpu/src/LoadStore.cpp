@@ -13,21 +13,19 @@ void LoadStore::PipelineReadBaseRegister() noexcept
     packetLow.Successful = &m_SuccessfulLow;
     packetLow.Unsuccessful = &m_UnsuccessfulLow;
 
+    // The high port holds the odd register of the pair, the low port the even one.
+    packetHigh.TargetRegister = m_Instruction.BaseRegister >> 1u;
+    packetLow.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
+
     // Does the base register start at high?
     if(m_Instruction.BaseRegister & 0x1)
     {
-        packetHigh.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
-        packetLow.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
-
         packetHigh.Value = &m_BaseAddressLow;
         packetLow.Value = &m_BaseAddressHigh;
     }
     // The base register starts at low
     else
     {
-        packetHigh.TargetRegister = m_Instruction.BaseRegister >> 1u;
-        packetLow.TargetRegister = m_Instruction.BaseRegister >> 1u;
-
         packetHigh.Value = &m_BaseAddressHigh;
         packetLow.Value = &m_BaseAddressLow;
     }
@@ -38,16 +36,9 @@ void LoadStore::PipelineReadBaseRegister() noexcept
 
 void LoadStore::PipelineReleaseReadLockBaseRegister() noexcept
 {
-    if((!m_SuccessfulHigh && !m_UnsuccessfulHigh) || (!m_SuccessfulLow && !m_UnsuccessfulLow))
-    {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
-    }
-
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh || !m_UnsuccessfulLow)
+    if(RetryFailedStage())
     {
-        --m_ExecutionStage;
+        return;
     }
 
     RegisterFile::CommandPacket packetHigh;
@@ -62,18 +53,8 @@ void LoadStore::PipelineReleaseReadLockBaseRegister() noexcept
     packetLow.Successful = &m_SuccessfulHigh;
     packetLow.Unsuccessful = &m_UnsuccessfulHigh;
 
-    // Does the base register start at high?
-    if(m_Instruction.BaseRegister & 0x1)
-    {
-        packetHigh.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
-        packetLow.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
-    }
-    // The base register starts at low
-    else
-    {
-        packetHigh.TargetRegister = m_Instruction.BaseRegister >> 1u;
-        packetLow.TargetRegister = m_Instruction.BaseRegister >> 1u;
-    }
+    packetHigh.TargetRegister = m_Instruction.BaseRegister >> 1u;
+    packetLow.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
 
     m_SM->InvokeRegisterFileHigh(m_UnitIndex, packetHigh);
     m_SM->InvokeRegisterFileLow(m_UnitIndex, packetLow);
@@ -166,16 +147,9 @@ void LoadStore::PipelineReleaseReadLockBaseRegister() noexcept
 
 void LoadStore::Pipeline4() noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    if(RetryFailedStage())
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
-    }
-
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
-    {
-        --m_ExecutionStage;
+        return;
     }
 
     RegisterFile::CommandPacket resetPacket {};
@@ -195,7 +169,7 @@ void LoadStore::Pipeline4() noexcept
 
     RegisterFile::CommandPacket packet {};
     packet.Command = RegisterFile::ECommand::ReadRegister;
-    packet.TargetRegister = m_Instruction.IndexRegister;
+    packet.TargetRegister = m_Instruction.IndexRegister >> 1u;
     packet.Value = &m_IndexRegister;
     packet.Successful = &m_SuccessfulHigh;
     packet.Unsuccessful = &m_UnsuccessfulHigh;
@@ -214,16 +188,9 @@ void LoadStore::Pipeline4() noexcept
 
 void LoadStore::Pipeline5() noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    if(RetryFailedStage())
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
-    }
-
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
-    {
-        --m_ExecutionStage;
+        return;
     }
 
     RegisterFile::CommandPacket resetPacket {};
@@ -245,7 +212,7 @@ void LoadStore::Pipeline5() noexcept
 
     RegisterFile::CommandPacket packet {};
     packet.Command = RegisterFile::ECommand::Unlock;
-    packet.TargetRegister = m_Instruction.IndexRegister;
+    packet.TargetRegister = m_Instruction.IndexRegister >> 1u;
     packet.Value = nullptr;
     packet.Successful = &m_SuccessfulHigh;
     packet.Unsuccessful = &m_UnsuccessfulHigh;
@@ -264,16 +231,9 @@ void LoadStore::Pipeline5() noexcept
 
 void LoadStore::Pipeline6() noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
-    {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
-    }
-
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    if(RetryFailedStage())
     {
-        --m_ExecutionStage;
+        return;
     }
 
     RegisterFile::CommandPacket resetPacket {};
@@ -286,6 +246,9 @@ void LoadStore::Pipeline6() noexcept
     m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
     m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
 
+    // Add the offset
+    m_Address += static_cast<u64>(static_cast<i64>(m_Instruction.Offset));
+
     // Being able to read up to 8 registers we can be in at most be in two cache lines.
     // If the last register is in another cache line we'll prefetch it. This has no effect in software, but would have a substantial effect in hardware.
 
@@ -307,16 +270,11 @@ void LoadStore::Pipeline23() noexcept
 
 void LoadStore::PipelineRWHandler(const u32 index) noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
-    {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
-    }
+    const u32 stage = m_ExecutionStage;
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    if(RetryFailedStage())
     {
-        --m_ExecutionStage;
+        return;
     }
 
     RegisterFile::CommandPacket resetPacket {};
@@ -334,23 +292,31 @@ void LoadStore::PipelineRWHandler(const u32 index) noexcept
     }
 
     RegisterFile::CommandPacket packet {};
-    packet.TargetRegister = m_CurrentRegister;
+    packet.TargetRegister = m_CurrentRegister >> 1u;
     packet.Value = &m_TargetValue;
     packet.Successful = &m_SuccessfulHigh;
     packet.Unsuccessful = &m_UnsuccessfulHigh;
 
+    // A store reads the register, the release stage then writes it to memory.
     if(m_Instruction.ReadWrite)
     {
-        packet.Command = RegisterFile::ECommand::WriteRegister;
+        packet.Command = RegisterFile::ECommand::ReadRegister;
     }
     else
     {
-        // This needs to be changed to handle pipelining.
-        m_TargetValue = m_SM->Read(m_Address);
-        packet.Command = RegisterFile::ECommand::ReadRegister;
+        if(!IssueLoad())
+        {
+            // Stall on this stage, leaving the register file ports idle until the data arrives.
+            m_ExecutionStage = stage + 1;
+            m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
+            m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+            return;
+        }
+
+        packet.Command = RegisterFile::ECommand::WriteRegister;
     }
 
-    if(m_Instruction.IndexRegister & 0x1)
+    if(m_CurrentRegister & 0x1)
     {
         m_SM->InvokeRegisterFileHigh(m_UnitIndex, packet);
         m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
@@ -362,18 +328,60 @@ void LoadStore::PipelineRWHandler(const u32 index) noexcept
     }
 }
 
-void LoadStore::PipelineReleaseHandler(const u32 index) noexcept
+bool LoadStore::IssueLoad() noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    if(!m_LoadPending)
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
+        if(!m_SM->ReadAsync(m_Address, &m_TargetValue, &m_ReadyCycle, static_cast<ECacheHint>(m_Instruction.CacheHint)))
+        {
+            // No MSHR was free, try the load again once one is.
+            return false;
+        }
+
+        m_LoadPending = true;
     }
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    if(m_ReadyCycle > CurrentCycle())
     {
-        --m_ExecutionStage;
+        return false;
+    }
+
+    m_LoadPending = false;
+    return true;
+}
+
+u64 LoadStore::CurrentCycle() const noexcept
+{
+    return m_SM->CycleCount();
+}
+
+bool LoadStore::RetryFailedStage() noexcept
+{
+    if(!m_UnsuccessfulHigh && !m_UnsuccessfulLow)
+    {
+        return false;
+    }
+
+    // The command the previous stage issued failed, go back a stage to issue it again.
+    m_ExecutionStage += 2;
+
+    RegisterFile::CommandPacket resetPacket {};
+    resetPacket.Command = RegisterFile::ECommand::Reset;
+    resetPacket.TargetRegister = 0;
+    resetPacket.Value = nullptr;
+    resetPacket.Successful = nullptr;
+    resetPacket.Unsuccessful = nullptr;
+
+    m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
+    m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+    return true;
+}
+
+void LoadStore::PipelineReleaseHandler(const u32 index) noexcept
+{
+    if(RetryFailedStage())
+    {
+        return;
     }
 
     RegisterFile::CommandPacket resetPacket {};
@@ -392,18 +400,23 @@ void LoadStore::PipelineReleaseHandler(const u32 index) noexcept
 
     RegisterFile::CommandPacket packet {};
     packet.Command = RegisterFile::ECommand::Unlock;
-    packet.TargetRegister = m_CurrentRegister;
-    packet.Value = &m_TargetValue;
+    packet.TargetRegister = m_CurrentRegister >> 1u;
+    packet.Value = nullptr;
     packet.Successful = &m_SuccessfulHigh;
     packet.Unsuccessful = &m_UnsuccessfulHigh;
 
-    // This needs to be changed to handle pipelining.
-    m_SM->Write(m_Address, m_TargetValue);
+    const bool high = m_CurrentRegister & 0x1;
+
+    if(m_Instruction.ReadWrite)
+    {
+        // This needs to be changed to handle pipelining.
+        m_SM->Write(m_Address, m_TargetValue, static_cast<ECacheHint>(m_Instruction.CacheHint));
+    }
 
     ++m_Address;
     ++m_CurrentRegister;
 
-    if(m_Instruction.IndexRegister & 0x1)
+    if(high)
     {
         m_SM->InvokeRegisterFileHigh(m_UnitIndex, packet);
         m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
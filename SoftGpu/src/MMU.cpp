@@ -2,6 +2,22 @@
 #include "StreamingMultiprocessor.hpp"
 
 u64 Mmu::TranslateAddress(const u64 virtualAddress, bool* const success, bool* const readWrite, bool* const execute, bool* const writeThrough, bool* const cacheDisable, bool* const external) noexcept
+{
+    return Translate<false>(m_DataTlb, virtualAddress, success, readWrite, execute, writeThrough, cacheDisable, external);
+}
+
+u64 Mmu::TranslateWriteAddress(const u64 virtualAddress, bool* const success, bool* const readWrite, bool* const execute, bool* const writeThrough, bool* const cacheDisable, bool* const external) noexcept
+{
+    return Translate<true>(m_DataTlb, virtualAddress, success, readWrite, execute, writeThrough, cacheDisable, external);
+}
+
+u64 Mmu::TranslateInstructionAddress(const u64 virtualAddress, bool* const success, bool* const cacheDisable, bool* const external) noexcept
+{
+    return Translate<false>(m_InstructionTlb, virtualAddress, success, nullptr, nullptr, nullptr, cacheDisable, external);
+}
+
+template<bool Write, uSys SetCount, uSys WayCount>
+u64 Mmu::Translate(Tlb<SetCount, WayCount>& l1Tlb, const u64 virtualAddress, bool* const success, bool* const readWrite, bool* const execute, bool* const writeThrough, bool* const cacheDisable, bool* const external) noexcept
 {
     if(!m_ValueLoaded)
     {
@@ -63,112 +79,259 @@ u64 Mmu::TranslateAddress(const u64 virtualAddress, bool* const success, bool* c
         return 0xFFFFFFFFFFFFFFFF;
     }
 
-    // And by 0x3FFF instead of 0xFFFF because of 4 byte granularity
-    const u64 pageBits = virtualAddress & 0x3FFF;
-    // Shift by 14 instead of 16 because of 4 byte granularity
-    const u64 pageTableBits = (virtualAddress >> 14) & 0xFFFF;
-    // Shift by 30 instead of 32 because of 4 byte granularity
-    const u64 pageDirectoryBits = (virtualAddress >> 30) & 0xFFFF;
+    TlbEntry* const tlbEntry = LookupPage(l1Tlb, virtualAddress >> PAGE_OFFSET_BITS);
 
-    if(m_CacheDirty || pageDirectoryBits != m_CachedTableIndex)
+    if(!tlbEntry)
     {
-        // Translate the address to be in bytes.
-        const u64 pageTableAddress = m_PageDirectoryCache[pageDirectoryBits].PhysicalAddress << 16;
-        // Convert the address to a C++ Pointer.
-        void* const pageTablePtr = reinterpret_cast<void*>(pageTableAddress);
+        if(success)
+        {
+            *success = false;
+        }
+        return 0xFFFFFFFFFFFFFFFF;
+    }
 
-        // Copy the memory into our cache.
-        (void) ::std::memcpy(m_PageTableCache, pageTablePtr, GpuPageSize);
+    // Only stores the caller will let through dirty the page.
+    const bool dirty = Write && tlbEntry->Entry.ReadWrite && !tlbEntry->Entry.Execute;
 
-        m_CachedTableIndex = pageDirectoryBits;
+    if(!tlbEntry->Entry.Accessed || (dirty && !tlbEntry->Entry.Dirty))
+    {
+        UpdatePageEntry(*tlbEntry, dirty);
     }
 
-    if(m_PageTableCache[pageTableBits].Present)
+    if(success)
     {
-        if(!m_PageTableCache[pageTableBits].Accessed)
-        {
-            // Translate the address to be in bytes.
-            const u64 pageTableAddress = m_PageDirectoryCache[pageDirectoryBits].PhysicalAddress << 16;
+        *success = true;
+    }
+    // Return the optional page info bits. These will be done with out ports.
+    if(readWrite)
+    {
+        *readWrite = tlbEntry->Entry.ReadWrite;
+    }
+    if(execute)
+    {
+        *execute = tlbEntry->Entry.Execute;
+    }
+    if(writeThrough)
+    {
+        *writeThrough = tlbEntry->Entry.WriteThrough;
+    }
+    if(cacheDisable)
+    {
+        *cacheDisable = tlbEntry->Entry.CacheDisable;
+    }
+    if(external)
+    {
+        *external = tlbEntry->Entry.External;
+    }
 
-            const u64 pageEntryAddress = pageTableAddress + pageTableBits * sizeof(PageEntry);
+    return (tlbEntry->Entry.PhysicalAddress << PAGE_OFFSET_BITS) | (virtualAddress & PAGE_OFFSET_MASK);
+}
 
-            // Flag that the page was accessed.
-            m_PageTableCache[pageTableBits].Accessed = true;
-            m_SM->WriteMmuPageInfo(pageEntryAddress >> 2, m_PageTableCache[pageTableBits].Value);
-        }
+template<uSys SetCount, uSys WayCount>
+TlbEntry* Mmu::LookupPage(Tlb<SetCount, WayCount>& l1Tlb, const u64 virtualPage) noexcept
+{
+    if(TlbEntry* const l1Entry = l1Tlb.Lookup(virtualPage, m_Asid))
+    {
+        return l1Entry;
+    }
 
-        if(success)
-        {
-            *success = true;
-        }
-        // Return the optional page info bits. These will be done with out ports.
-        if(readWrite)
-        {
-            *readWrite = m_PageTableCache[pageTableBits].ReadWrite;
-        }
-        if(execute)
-        {
-            *execute = m_PageTableCache[pageTableBits].Execute;
-        }
-        if(writeThrough)
-        {
-            *writeThrough = m_PageTableCache[pageTableBits].WriteThrough;
-        }
-        if(cacheDisable)
-        {
-            *cacheDisable = m_PageTableCache[pageTableBits].CacheDisable;
-        }
-        if(external)
-        {
-            *external = m_PageTableCache[pageTableBits].External;
-        }
+    if(const TlbEntry* const l2Entry = m_L2Tlb.Lookup(virtualPage, m_Asid))
+    {
+        return l1Tlb.Insert(*l2Entry);
+    }
 
-        return (m_PageTableCache[pageTableBits].PhysicalAddress << 14) | pageBits;
+    if(const TlbEntry* const mediumEntry = m_MediumTlb.Lookup(virtualPage >> GpuMediumPageShift, m_Asid))
+    {
+        return l1Tlb.Insert(SplitSpan(*mediumEntry, virtualPage));
     }
-    else
+
+    if(const TlbEntry* const largeEntry = m_LargeTlb.Lookup(virtualPage >> GpuLargePageShift, m_Asid))
     {
-        if(success)
-        {
-            *success = false;
-        }
-        return 0xFFFFFFFFFFFFFFFF;
+        return l1Tlb.Insert(SplitSpan(*largeEntry, virtualPage));
     }
+
+    TlbEntry entry;
+    if(!WalkPageTables(virtualPage, &entry))
+    {
+        return nullptr;
+    }
+
+    if(entry.PageShift == GpuLargePageShift)
+    {
+        (void) InsertBacking(m_LargeTlb, entry);
+        return l1Tlb.Insert(SplitSpan(entry, virtualPage));
+    }
+
+    if(entry.PageShift == GpuMediumPageShift)
+    {
+        (void) InsertBacking(m_MediumTlb, entry);
+        return l1Tlb.Insert(SplitSpan(entry, virtualPage));
+    }
+
+    (void) InsertBacking(m_L2Tlb, entry);
+    return l1Tlb.Insert(entry);
 }
 
-void Mmu::MarkDirty(const u64 virtualAddress) noexcept
+bool Mmu::WalkPageTables(const u64 virtualPage, TlbEntry* const entry) const noexcept
 {
-    if(!m_ValueLoaded)
+    const u64 pageTableIndex = virtualPage & 0xFFFF;
+    const u64 pageDirectoryIndex = (virtualPage >> 16) & 0xFFFF;
+
+    // Translate the address to be in bytes.
+    const u64 pageDirectoryEntryAddress = (m_PageDirectoryPhysicalAddress << 16) + pageDirectoryIndex * sizeof(PageEntry);
+
+    PageEntry pageDirectoryEntry;
+    (void) ::std::memcpy(&pageDirectoryEntry, reinterpret_cast<const void*>(pageDirectoryEntryAddress), sizeof(PageEntry));
+
+    if(!pageDirectoryEntry.Present)
     {
-        return;
+        return false;
     }
-    
-    // Shift by 14 instead of 16 because of 4 byte granularity
-    const u64 pageTableBits = (virtualAddress >> 14) & 0xFFFF;
-    // Shift by 30 instead of 32 because of 4 byte granularity
-    const u64 pageDirectoryBits = (virtualAddress >> 30) & 0xFFFF;
 
-    if(m_CacheDirty || pageDirectoryBits != m_CachedTableIndex)
+    if(pageDirectoryEntry.LargePage)
     {
-        // Translate the address to be in bytes.
-        const u64 pageTableAddress = m_PageDirectoryCache[pageDirectoryBits].PhysicalAddress << 16;
-        // Convert the address to a C++ Pointer.
-        void* const pageTablePtr = reinterpret_cast<void*>(pageTableAddress);
+        entry->VirtualPage = virtualPage >> GpuLargePageShift;
+        entry->Entry = pageDirectoryEntry;
+        entry->Asid = m_Asid;
+        entry->PageEntryAddress = pageDirectoryEntryAddress >> 2;
+        entry->Valid = true;
+        entry->PageShift = GpuLargePageShift;
+        entry->WritebackPending = false;
+        return true;
+    }
+
+    const u64 pageEntryAddress = (pageDirectoryEntry.PhysicalAddress << 16) + pageTableIndex * sizeof(PageEntry);
 
-        // Copy the memory into our cache.
-        (void) ::std::memcpy(m_PageTableCache, pageTablePtr, GpuPageSize);
+    (void) ::std::memcpy(&entry->Entry, reinterpret_cast<const void*>(pageEntryAddress), sizeof(PageEntry));
 
-        m_CachedTableIndex = pageDirectoryBits;
+    if(!entry->Entry.Present)
+    {
+        return false;
     }
 
-    if(!m_PageTableCache[pageTableBits].Dirty)
+    entry->VirtualPage = virtualPage;
+    entry->Asid = m_Asid;
+    // Shift right 2 to match the memory granularity of 4 bytes.
+    entry->PageEntryAddress = pageEntryAddress >> 2;
+    entry->Valid = true;
+    entry->PageShift = 0;
+    entry->WritebackPending = false;
+
+    if(entry->Entry.LargePage)
     {
-        // Translate the address to be in bytes.
-        const u64 pageTableAddress = m_PageDirectoryCache[pageDirectoryBits].PhysicalAddress << 16;
+        // Part of a medium page, rebase it to the start of the run. Whichever page is walked, the Accessed and Dirty bits come from and go to the first entry of the run.
+        const u64 spanIndex = virtualPage & ((1ull << GpuMediumPageShift) - 1);
+        const u64 runEntryAddress = pageEntryAddress - spanIndex * sizeof(PageEntry);
 
-        const u64 pageEntryAddress = pageTableAddress + pageTableBits * sizeof(PageEntry);
+        PageEntry runEntry;
+        (void) ::std::memcpy(&runEntry, reinterpret_cast<const void*>(runEntryAddress), sizeof(PageEntry));
 
-        // Flag that the page was accessed.
-        m_PageTableCache[pageTableBits].Dirty = true;
-        m_SM->WriteMmuPageInfo(pageEntryAddress >> 2, m_PageTableCache[pageTableBits].Value);
+        entry->VirtualPage = virtualPage >> GpuMediumPageShift;
+        entry->PageEntryAddress = runEntryAddress >> 2;
+        entry->Entry.PhysicalAddress = entry->Entry.PhysicalAddress - spanIndex;
+        entry->Entry.Accessed = runEntry.Accessed;
+        entry->Entry.Dirty = runEntry.Dirty;
+        entry->PageShift = GpuMediumPageShift;
     }
+
+    return true;
+}
+
+template<uSys SetCount, uSys WayCount>
+TlbEntry* Mmu::InsertBacking(Tlb<SetCount, WayCount>& tlb, const TlbEntry& entry) noexcept
+{
+    TlbEntry evicted;
+    evicted.Valid = false;
+
+    TlbEntry* const backingEntry = tlb.Insert(entry, &evicted);
+
+    if(evicted.Valid && evicted.WritebackPending)
+    {
+        WriteBackPageEntry(evicted);
+        --m_PendingWritebackCount;
+    }
+
+    return backingEntry;
+}
+
+TlbEntry Mmu::SplitSpan(const TlbEntry& spanEntry, const u64 virtualPage) noexcept
+{
+    TlbEntry entry = spanEntry;
+    entry.VirtualPage = virtualPage;
+    entry.Entry.PhysicalAddress = spanEntry.Entry.PhysicalAddress + (virtualPage & ((1ull << spanEntry.PageShift) - 1));
+    entry.WritebackPending = false;
+    return entry;
+}
+
+TlbEntry* Mmu::LookupBacking(const TlbEntry& entry) noexcept
+{
+    switch(entry.PageShift)
+    {
+        case 0: return m_L2Tlb.Lookup(entry.VirtualPage, entry.Asid);
+        case GpuMediumPageShift: return m_MediumTlb.Lookup(entry.VirtualPage >> GpuMediumPageShift, entry.Asid);
+        default: return m_LargeTlb.Lookup(entry.VirtualPage >> GpuLargePageShift, entry.Asid);
+    }
+}
+
+void Mmu::UpdatePageEntry(TlbEntry& entry, const bool dirty) noexcept
+{
+    entry.Entry.Accessed = true;
+
+    if(dirty)
+    {
+        entry.Entry.Dirty = true;
+    }
+
+    TlbEntry* const backingEntry = LookupBacking(entry);
+
+    if(!backingEntry)
+    {
+        // The backing copy was evicted while the L1 entry lived on, this is rare enough to just write it now.
+        WriteBackPageEntry(entry);
+        return;
+    }
+
+    // Only the flags, a span entry keeps its own base address and may have been dirtied through another page.
+    backingEntry->Entry.Accessed = true;
+
+    if(dirty)
+    {
+        backingEntry->Entry.Dirty = true;
+    }
+
+    if(!backingEntry->WritebackPending)
+    {
+        backingEntry->WritebackPending = true;
+        ++m_PendingWritebackCount;
+    }
+}
+
+void Mmu::WriteBackPendingEntries() noexcept
+{
+    WriteBackPendingEntries(m_L2Tlb);
+    WriteBackPendingEntries(m_MediumTlb);
+    WriteBackPendingEntries(m_LargeTlb);
+
+    m_PendingWritebackCount = 0;
+}
+
+template<uSys SetCount, uSys WayCount>
+void Mmu::WriteBackPendingEntries(Tlb<SetCount, WayCount>& tlb) noexcept
+{
+    TlbEntry* const entries = tlb.Entries();
+
+    for(uSys i = 0; i < Tlb<SetCount, WayCount>::ENTRY_COUNT; ++i)
+    {
+        if(entries[i].Valid && entries[i].WritebackPending)
+        {
+            WriteBackPageEntry(entries[i]);
+            entries[i].WritebackPending = false;
+        }
+    }
+}
+
+void Mmu::WriteBackPageEntry(const TlbEntry& entry) noexcept
+{
+    // Only the flags are written, and they are merged into the entry in memory so a concurrent edit of the mapping isn't lost.
+    m_SM->WriteMmuPageFlags(entry.PageEntryAddress, static_cast<u32>(entry.Entry.Value) & PAGE_ENTRY_ACCESSED_DIRTY_MASK);
 }
@@ -108,6 +108,22 @@ void PciControlRegisters::ExecuteRead() noexcept
             m_ReadState = 0;
         }
     }
+    else if(m_Bus.ReadAddress >= BASE_REGISTER_MMU && m_Bus.ReadAddress < BASE_REGISTER_MMU + SIZE_REGISTER_MMU * Topology.SmCount)
+    {
+        const u32 offset = m_Bus.ReadAddress - BASE_REGISTER_MMU;
+
+        const u32 smIndex = offset / SIZE_REGISTER_MMU;
+        const u32 registerOffset = offset % SIZE_REGISTER_MMU;
+
+        if(registerOffset == OFFSET_REGISTER_MMU_ACTIVE_ASID)
+        {
+            m_Bus.ReadResponse = m_Processor->Asid(smIndex);
+        }
+        else
+        {
+            m_Bus.ReadResponse = m_MmuRegisters[smIndex][registerOffset / sizeof(u32)];
+        }
+    }
 
     switch(m_Bus.ReadAddress)
     {
@@ -168,6 +184,12 @@ void PciControlRegisters::ExecuteWrite() noexcept
             m_WriteState = 0;
         }
     }
+    else if(m_Bus.WriteAddress >= BASE_REGISTER_MMU && m_Bus.WriteAddress < BASE_REGISTER_MMU + SIZE_REGISTER_MMU * Topology.SmCount)
+    {
+        const u32 offset = m_Bus.WriteAddress - BASE_REGISTER_MMU;
+
+        ExecuteMmuWrite(offset / SIZE_REGISTER_MMU, offset % SIZE_REGISTER_MMU);
+    }
 
     switch(m_Bus.WriteAddress)
     {
@@ -180,3 +202,37 @@ void PciControlRegisters::ExecuteWrite() noexcept
 
     m_Bus.WriteBusLocked = 2;
 }
+
+void PciControlRegisters::ExecuteMmuWrite(const u32 smIndex, const u32 registerOffset) noexcept
+{
+    u32* const registers = m_MmuRegisters[smIndex];
+
+    if(registerOffset == OFFSET_REGISTER_MMU_ACTIVE_ASID)
+    {
+        return;
+    }
+
+    registers[registerOffset / sizeof(u32)] = m_Bus.WriteValue;
+
+    const u16 asid = static_cast<u16>(registers[OFFSET_REGISTER_MMU_ASID / sizeof(u32)]);
+
+    switch(registerOffset)
+    {
+        case OFFSET_REGISTER_MMU_PAGE_DIRECTORY_HIGH:
+        {
+            const u64 pageDirectory = (static_cast<u64>(registers[OFFSET_REGISTER_MMU_PAGE_DIRECTORY_HIGH / sizeof(u32)]) << 32) | registers[OFFSET_REGISTER_MMU_PAGE_DIRECTORY_LOW / sizeof(u32)];
+            m_Processor->LoadPageDirectoryPointer(smIndex, pageDirectory, asid);
+            break;
+        }
+        case OFFSET_REGISTER_MMU_INVALIDATE_ASID:
+            m_Processor->InvalidateMmuAsid(smIndex, static_cast<u16>(m_Bus.WriteValue));
+            break;
+        case OFFSET_REGISTER_MMU_INVALIDATE_PAGE_HIGH:
+        {
+            const u64 virtualAddress = (static_cast<u64>(registers[OFFSET_REGISTER_MMU_INVALIDATE_PAGE_HIGH / sizeof(u32)]) << 32) | registers[OFFSET_REGISTER_MMU_INVALIDATE_PAGE_LOW / sizeof(u32)];
+            m_Processor->InvalidateMmuPage(smIndex, virtualAddress, asid);
+            break;
+        }
+        default: break;
+    }
+}
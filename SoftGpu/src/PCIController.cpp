@@ -1,6 +1,11 @@
 #include "PCIController.hpp"
 #include "Processor.hpp"
 
+void PciController::RingProcessorDoorbell() noexcept
+{
+    m_Processor->RingDoorbell();
+}
+
 void PciController::ExecuteMemRead() noexcept
 {
     ::std::lock_guard lock(m_ReadDataMutex);
@@ -82,16 +87,8 @@ void PciController::ExecuteMemRead() noexcept
 
     if(bar == 1)
     {
-        // Shift right 2 to match the MMU granularity of 4 bytes.
-        const u64 realAddress4 = (addressOffset + m_Processor->RamBaseAddress()) >> 2;
-
-        const u16 sizeWords = m_ReadRequestSize / 4;
-
-        for(u16 i = 0; i < sizeWords; ++i)
-        {
-            // ~Use the real address as that is mapped into the system virtual page.~
-            m_ReadRequestResponseData[i] = m_Processor->MemReadPhy(realAddress4 + i);
-        }
+        // Goes through the caches, a line an SM has dirtied in its L0 is newer than memory.
+        m_Processor->HostMemRead(addressOffset + m_Processor->RamBaseAddress(), m_ReadRequestResponseData, m_ReadRequestSize);
 
         *m_ReadCountResponse = m_ReadRequestSize;
 
@@ -179,16 +176,10 @@ void PciController::ExecuteMemWrite() noexcept
     }
     else if(bar == 1)
     {
-        // Shift right 2 to match the MMU granularity of 4 bytes.
-        const u64 realAddress4 = (addressOffset + m_Processor->RamBaseAddress()) >> 2;
-
-        const u16 sizeWords = m_WriteRequestSize / 4;
+        // Goes through the caches, so no SM keeps reading a stale copy of the line.
+        m_Processor->HostMemWrite(addressOffset + m_Processor->RamBaseAddress(), m_WriteRequestData, m_WriteRequestSize);
 
-        for(u16 i = 0; i < sizeWords; ++i)
-        {
-            // ~Use the real address as that is mapped into the system virtual page.~
-            m_Processor->MemWritePhy(realAddress4 + i, m_WriteRequestData[i]);
-        }
+        m_Processor->NotifyHostMemoryWrite(addressOffset + m_Processor->RamBaseAddress(), m_WriteRequestSize);
     }
 
     m_WriteRequestActive = false;
@@ -0,0 +1,125 @@
+#include "PageTableBuilder.hpp"
+
+static PageEntry MakeLeafEntry(const PageEntry flags, const u64 physicalPage, const bool largePage) noexcept
+{
+    PageEntry entry;
+    entry.Value = 0;
+    entry.Present = true;
+    entry.ReadWrite = flags.ReadWrite;
+    entry.Execute = flags.Execute;
+    entry.WriteThrough = flags.WriteThrough;
+    entry.CacheDisable = flags.CacheDisable;
+    entry.External = flags.External;
+    entry.PhysicalAddress = physicalPage;
+    entry.LargePage = largePage;
+    return entry;
+}
+
+bool PageTableBuilder::Map(u64 virtualPage, u64 physicalPage, u64 pageCount, const PageEntry flags) noexcept
+{
+    constexpr u64 largePagePageCount = 1ull << GpuLargePageShift;
+    constexpr u64 pageIndexMask = largePagePageCount - 1;
+
+    while(pageCount > 0)
+    {
+        const u64 pageDirectoryIndex = (virtualPage >> GpuLargePageShift) & 0xFFFF;
+        PageEntry& pageDirectoryEntry = m_PageDirectory[pageDirectoryIndex];
+
+        // A whole directory entry, map it in one go. If a page table is already there it is filled instead, so it isn't leaked.
+        if((virtualPage & pageIndexMask) == 0 && pageCount >= largePagePageCount && (!pageDirectoryEntry.Present || pageDirectoryEntry.LargePage))
+        {
+            pageDirectoryEntry = MakeLeafEntry(flags, physicalPage, true);
+
+            virtualPage += largePagePageCount;
+            physicalPage += largePagePageCount;
+            pageCount -= largePagePageCount;
+            continue;
+        }
+
+        PageEntry* const pageTable = GetPageTable(pageDirectoryIndex);
+
+        if(!pageTable)
+        {
+            return false;
+        }
+
+        // Fill in up to the end of this page table.
+        const u64 pageTableIndex = virtualPage & pageIndexMask;
+        const u64 remainingInTable = largePagePageCount - pageTableIndex;
+        const u64 fillCount = pageCount < remainingInTable ? pageCount : remainingInTable;
+
+        FillPageTable(pageTable, pageTableIndex, physicalPage, fillCount, flags);
+
+        virtualPage += fillCount;
+        physicalPage += fillCount;
+        pageCount -= fillCount;
+    }
+
+    return true;
+}
+
+void PageTableBuilder::FillPageTable(PageEntry* const pageTable, u64 pageTableIndex, u64 physicalPage, u64 pageCount, const PageEntry flags) noexcept
+{
+    constexpr u64 mediumPagePageCount = 1ull << GpuMediumPageShift;
+    constexpr u64 mediumPageIndexMask = mediumPagePageCount - 1;
+
+    while(pageCount > 0)
+    {
+        const u64 spanIndex = pageTableIndex & mediumPageIndexMask;
+        const u64 remainingInSpan = mediumPagePageCount - spanIndex;
+        const u64 fillCount = pageCount < remainingInSpan ? pageCount : remainingInSpan;
+
+        // Only a fully covered run can be a medium page, the physical pages are contiguous by construction.
+        const bool mediumPage = fillCount == mediumPagePageCount;
+
+        if(!mediumPage)
+        {
+            // The rest of a run that was a medium page keeps its mappings, but is no longer contiguous with these pages.
+            const u64 spanStart = pageTableIndex - spanIndex;
+
+            for(u64 i = 0; i < mediumPagePageCount; ++i)
+            {
+                pageTable[spanStart + i].LargePage = false;
+            }
+        }
+
+        for(u64 i = 0; i < fillCount; ++i)
+        {
+            pageTable[pageTableIndex + i] = MakeLeafEntry(flags, physicalPage + i, mediumPage);
+        }
+
+        pageTableIndex += fillCount;
+        physicalPage += fillCount;
+        pageCount -= fillCount;
+    }
+}
+
+PageEntry* PageTableBuilder::GetPageTable(const u64 pageDirectoryIndex) noexcept
+{
+    PageEntry& pageDirectoryEntry = m_PageDirectory[pageDirectoryIndex];
+
+    if(pageDirectoryEntry.Present)
+    {
+        // Splitting a large page would need to remap everything around it.
+        if(pageDirectoryEntry.LargePage)
+        {
+            return nullptr;
+        }
+
+        return reinterpret_cast<PageEntry*>(pageDirectoryEntry.PhysicalAddress * GpuPageSize);
+    }
+
+    PageEntry* const pageTable = m_AllocatePageTable(m_UserData);
+
+    if(!pageTable)
+    {
+        return nullptr;
+    }
+
+    pageDirectoryEntry.Value = 0;
+    pageDirectoryEntry.Present = true;
+    pageDirectoryEntry.ReadWrite = true;
+    pageDirectoryEntry.PhysicalAddress = reinterpret_cast<u64>(pageTable) / GpuPageSize;
+
+    return pageTable;
+}
@@ -0,0 +1,139 @@
+#include "SmWorkerPool.hpp"
+#include "Processor.hpp"
+#include <immintrin.h>
+
+static void SpinWait(u32& spins) noexcept
+{
+    if(++spins < SmWorkerPool::SpinCount)
+    {
+        _mm_pause();
+    }
+    else
+    {
+        ::std::this_thread::yield();
+    }
+}
+
+void SmWorkerPool::Start() noexcept
+{
+    if(m_Running)
+    {
+        return;
+    }
+
+    // Spinning workers would only fight over the cores with each other. A count of 0 means the host could not tell us, so assume it has enough.
+    const u32 hostThreadCount = ::std::thread::hardware_concurrency();
+    if(hostThreadCount != 0 && hostThreadCount < SmCount)
+    {
+        ConPrinter::PrintLn("Not enough host threads for a threaded clock, {} are required.", SmCount);
+        return;
+    }
+
+    m_ShouldExit.store(false, ::std::memory_order_relaxed);
+
+    // Hand the current generation to the workers so that a cycle started before a worker gets scheduled is not missed.
+    const u32 generation = m_Generation.load(::std::memory_order_relaxed);
+
+    for(u32 i = 0; i < WorkerCount; ++i)
+    {
+        m_Workers[i] = ::std::thread(&SmWorkerPool::WorkerFunc, this, i + 1, generation);
+    }
+
+    m_Running = true;
+}
+
+void SmWorkerPool::Stop() noexcept
+{
+    if(!m_Running)
+    {
+        return;
+    }
+
+    m_ShouldExit.store(true, ::std::memory_order_relaxed);
+    (void) m_Generation.fetch_add(1);
+    m_Generation.notify_all();
+
+    for(u32 i = 0; i < WorkerCount; ++i)
+    {
+        m_Workers[i].join();
+    }
+
+    m_Running = false;
+}
+
+void SmWorkerPool::Clock() noexcept
+{
+    m_InParallelPhase.store(true, ::std::memory_order_relaxed);
+    m_PendingCount.store(WorkerCount, ::std::memory_order_relaxed);
+
+    // Release the workers, only pay for the wake if one of them has gone to sleep.
+    const u32 generation = m_Generation.fetch_add(1) + 1;
+    if(m_SleepingCount.load() != 0)
+    {
+        m_Generation.notify_all();
+    }
+
+    m_Processor->ClockSM(0);
+    Retire(0, generation);
+
+    u32 spins = 0;
+    while(m_PendingCount.load(::std::memory_order_acquire) != 0)
+    {
+        SpinWait(spins);
+    }
+
+    m_InParallelPhase.store(false, ::std::memory_order_relaxed);
+}
+
+void SmWorkerPool::WaitForSharedMemory(const u32 smIndex) const noexcept
+{
+    const u32 generation = m_Generation.load(::std::memory_order_relaxed);
+
+    for(u32 i = 0; i < smIndex; ++i)
+    {
+        u32 spins = 0;
+        while(m_RetiredGeneration[i].load(::std::memory_order_acquire) != generation)
+        {
+            SpinWait(spins);
+        }
+    }
+}
+
+void SmWorkerPool::WorkerFunc(const u32 smIndex, u32 generation) noexcept
+{
+    while(true)
+    {
+        u32 spins = 0;
+        u32 nextGeneration;
+        while((nextGeneration = m_Generation.load(::std::memory_order_acquire)) == generation)
+        {
+            if(++spins < SpinCount)
+            {
+                _mm_pause();
+                continue;
+            }
+
+            (void) m_SleepingCount.fetch_add(1);
+            m_Generation.wait(generation);
+            (void) m_SleepingCount.fetch_sub(1);
+            spins = 0;
+        }
+
+        generation = nextGeneration;
+
+        if(m_ShouldExit.load(::std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        m_Processor->ClockSM(smIndex);
+        Retire(smIndex, generation);
+
+        (void) m_PendingCount.fetch_sub(1, ::std::memory_order_release);
+    }
+}
+
+void SmWorkerPool::Retire(const u32 smIndex, const u32 generation) noexcept
+{
+    m_RetiredGeneration[smIndex].store(generation, ::std::memory_order_release);
+}
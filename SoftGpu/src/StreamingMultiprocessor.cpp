@@ -1,8 +1,10 @@
 #include "StreamingMultiprocessor.hpp"
 #include "Processor.hpp"
 
-u32 StreamingMultiprocessor::Read(const u64 address) noexcept
+u32 StreamingMultiprocessor::Read(const u64 address, const ECacheHint hint) noexcept
 {
+    AcquireSharedMemory();
+
     bool success;
     bool cacheDisable;
     bool external;
@@ -14,18 +16,106 @@ u32 StreamingMultiprocessor::Read(const u64 address) noexcept
         return 0xFFFFFFFF;
     }
 
+    if(cacheDisable)
+    {
+        DrainWritesToLine(physicalAddress, external);
+    }
+
+    return m_Processor->Read(m_SMIndex, physicalAddress, cacheDisable, external, nullptr, hint);
+}
+
+bool StreamingMultiprocessor::ReadAsync(const u64 address, u32* const value, u64* const readyCycle, const ECacheHint hint) noexcept
+{
+    AcquireSharedMemory();
+
+    bool success;
+    bool cacheDisable;
+    bool external;
+    const u64 physicalAddress = m_Mmu.TranslateAddress(address, &success, nullptr, nullptr, nullptr, &cacheDisable, &external);
+
+    // Was the virtual address valid?
+    if(!success)
+    {
+        *value = 0xFFFFFFFF;
+        *readyCycle = m_CycleCount;
+        return true;
+    }
+
+    // Uncached loads bypass the L0, and with it the MSHRs.
+    if(cacheDisable)
+    {
+        DrainWritesToLine(physicalAddress, external);
+        *value = m_Processor->Read(m_SMIndex, physicalAddress, true, external);
+        *readyCycle = m_CycleCount + Mshrs::MEMORY_LATENCY;
+        return true;
+    }
+
+    const u64 lineAddress = physicalAddress >> 3;
+
+    // The line is already on its way, wait on that miss instead of allocating another entry.
+    if(const u64 pendingCycle = m_Mshrs.Merge(lineAddress, external, m_CycleCount); pendingCycle != 0)
+    {
+        *value = m_Processor->Read(m_SMIndex, physicalAddress, false, external, nullptr, hint);
+        *readyCycle = pendingCycle;
+        return true;
+    }
+
+    // Hits can still go under a full set of misses.
+    if(m_Mshrs.IsFull(m_CycleCount) && !m_Processor->CacheContains(m_SMIndex, physicalAddress, external))
+    {
+        *readyCycle = m_Mshrs.EarliestReadyCycle();
+        return false;
+    }
+
+    ECacheLevel servedBy;
+    *value = m_Processor->Read(m_SMIndex, physicalAddress, false, external, &servedBy, hint);
+    *readyCycle = m_CycleCount + Mshrs::MissLatency(servedBy);
+
+    if(servedBy != ECacheLevel::L0)
+    {
+        m_Mshrs.Allocate(lineAddress, external, *readyCycle);
+    }
+
+    return true;
+}
+
+u32 StreamingMultiprocessor::ReadInstruction(const u64 address) noexcept
+{
+    AcquireSharedMemory();
+
+    bool success;
+    bool cacheDisable;
+    bool external;
+    const u64 physicalAddress = m_Mmu.TranslateInstructionAddress(address, &success, &cacheDisable, &external);
+
+    // Was the virtual address valid?
+    if(!success)
+    {
+        return 0xFFFFFFFF;
+    }
+
+    // Anything decoded from this line has to be dropped if it is written.
+    m_DecodeCache.MarkCodeLine(physicalAddress);
+
+    if(cacheDisable)
+    {
+        DrainWritesToLine(physicalAddress, external);
+    }
+
     return m_Processor->Read(m_SMIndex, physicalAddress, cacheDisable, external);
 }
 
-void StreamingMultiprocessor::Write(const u64 address, const u32 value) noexcept
+void StreamingMultiprocessor::Write(const u64 address, const u32 value, const ECacheHint hint) noexcept
 {
+    AcquireSharedMemory();
+
     bool success;
     bool readWrite;
     bool execute;
     bool writeThrough;
     bool cacheDisable;
     bool external;
-    const u64 physicalAddress = m_Mmu.TranslateAddress(address, &success, &readWrite, &execute, &writeThrough, &cacheDisable, &external);
+    const u64 physicalAddress = m_Mmu.TranslateWriteAddress(address, &success, &readWrite, &execute, &writeThrough, &cacheDisable, &external);
 
     // Was the virtual address valid?
     if(!success)
@@ -45,13 +135,34 @@ void StreamingMultiprocessor::Write(const u64 address, const u32 value) noexcept
         return;
     }
 
-    m_Mmu.MarkDirty(address);
+    // Catch stores over instructions that any SM has already decoded, our own block has to stop right away.
+    m_Processor->NotifyCodeWrite(physicalAddress);
+    m_DecodeCache.SyncPendingInvalidate();
+
+    // Write-through and uncached stores reach memory through the write-combining buffer.
+    if(writeThrough || cacheDisable)
+    {
+        if(!cacheDisable)
+        {
+            m_Processor->Write(m_SMIndex, physicalAddress, value, false, false, external, hint);
+        }
+        else
+        {
+            // Older stores to the line from other SMs must not land after this one.
+            m_Processor->DrainWriteCombiningLine(m_SMIndex, physicalAddress, external);
+        }
 
-    m_Processor->Write(m_SMIndex, physicalAddress, value, writeThrough, cacheDisable, external);
+        m_WriteCombiner.Write(physicalAddress, value, external, !cacheDisable, m_CycleCount);
+        return;
+    }
+
+    m_Processor->Write(m_SMIndex, physicalAddress, value, writeThrough, cacheDisable, external, hint);
 }
 
 void StreamingMultiprocessor::Prefetch(u64 address) noexcept
 {
+    AcquireSharedMemory();
+
     bool success;
     bool cacheDisable;
     bool external;
@@ -69,16 +180,97 @@ void StreamingMultiprocessor::Prefetch(u64 address) noexcept
         return;
     }
 
-    m_Processor->Prefetch(m_SMIndex, physicalAddress, external);
+    const u64 lineAddress = physicalAddress >> 3;
+
+    // A prefetch is only a hint, it is dropped if the line is already outstanding or there is no MSHR to track it.
+    if(m_Mshrs.Lookup(lineAddress, external, m_CycleCount) != 0 || m_Mshrs.IsFull(m_CycleCount))
+    {
+        return;
+    }
+
+    ECacheLevel servedBy;
+    m_Processor->Prefetch(m_SMIndex, physicalAddress, external, &servedBy);
+
+    if(servedBy != ECacheLevel::L0)
+    {
+        m_Mshrs.Allocate(lineAddress, external, m_CycleCount + Mshrs::MissLatency(servedBy));
+    }
 }
 
 void StreamingMultiprocessor::FlushCache() noexcept
 {
+    AcquireSharedMemory();
+
+    m_Mmu.WriteBackPageEntries();
+    m_WriteCombiner.DrainAll();
     m_Processor->FlushCache(m_SMIndex);
+    m_DecodeCache.Invalidate();
+}
+
+void StreamingMultiprocessor::WriteBackPageEntries() noexcept
+{
+    if(!m_Mmu.HasPendingWriteback())
+    {
+        return;
+    }
+
+    AcquireSharedMemory();
+
+    m_Mmu.WriteBackPageEntries();
+}
+
+// Writes from other SMs and the host are only applied at the cycle boundary, see SyncPendingInvalidate.
+const DecodedInstruction* StreamingMultiprocessor::LookupDecodedInstruction(const u64 instructionPointer) noexcept
+{
+    return m_DecodeCache.Lookup(instructionPointer);
 }
 
-void StreamingMultiprocessor::WriteMmuPageInfo(const u64 physicalAddress, const u64 pageTableEntry) noexcept
+const ThreadedBlock* StreamingMultiprocessor::LookupThreadedBlock(const u64 instructionPointer) noexcept
 {
-    m_Processor->Write(m_SMIndex, physicalAddress, static_cast<u32>(pageTableEntry), true, true, false);
-    m_Processor->Write(m_SMIndex, physicalAddress + 1, static_cast<u32>(pageTableEntry >> 32), true, true, false);
+    return m_BlockCache.Lookup(instructionPointer, m_DecodeCache.Epoch());
+}
+
+void StreamingMultiprocessor::DrainWriteCombiner() noexcept
+{
+    if(!m_WriteCombiner.HasPending())
+    {
+        return;
+    }
+
+    AcquireSharedMemory();
+
+    m_WriteCombiner.DrainAll();
+}
+
+void StreamingMultiprocessor::DrainExpiredWrites() noexcept
+{
+    AcquireSharedMemory();
+
+    m_WriteCombiner.DrainExpired(m_CycleCount);
+}
+
+void StreamingMultiprocessor::WriteMmuPageFlags(const u64 physicalAddress, const u32 pageFlags) noexcept
+{
+    DrainWritesToLine(physicalAddress, false);
+    const u32 pageEntryLow = m_Processor->Read(m_SMIndex, physicalAddress, true, false);
+    m_Processor->Write(m_SMIndex, physicalAddress, pageEntryLow | pageFlags, true, true, false);
+}
+
+void StreamingMultiprocessor::DrainWritesToLine(const u64 physicalAddress, const bool external) noexcept
+{
+    m_WriteCombiner.DrainLine(physicalAddress, external);
+
+    // Uncached stores from other SMs can still be sitting in their buffers.
+    m_Processor->DrainWriteCombiningLine(m_SMIndex, physicalAddress, external);
+}
+
+void StreamingMultiprocessor::AcquireSharedMemory() noexcept
+{
+    if(m_HoldsSharedMemory)
+    {
+        return;
+    }
+
+    m_Processor->WaitForSharedMemory(m_SMIndex);
+    m_HoldsSharedMemory = true;
 }
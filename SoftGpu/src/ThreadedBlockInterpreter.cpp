@@ -0,0 +1,377 @@
+#include "ThreadedBlockInterpreter.hpp"
+#include "StreamingMultiprocessor.hpp"
+
+#include <immintrin.h>
+
+static void LoadImmediateHandler(StreamingMultiprocessor* const sm, const InstructionDecodeData::InstructionData& data, const u16 baseRegisters[8], const u32 replicationMask) noexcept
+{
+    for(u32 replicationIndex = 0; replicationIndex < 8; ++replicationIndex)
+    {
+        if(replicationMask & (1u << replicationIndex))
+        {
+            sm->SetRegister(baseRegisters[replicationIndex] + data.LoadImmediate.Register, data.LoadImmediate.Value);
+        }
+    }
+}
+
+template<bool Store, bool Indexed>
+static void LoadStoreHandler(StreamingMultiprocessor* const sm, const InstructionDecodeData::InstructionData& data, const u16 baseRegisters[8], const u32 replicationMask) noexcept
+{
+    const InstructionDecodeData::LoadStoreData& ldSt = data.LoadStore;
+
+    for(u32 replicationIndex = 0; replicationIndex < 8; ++replicationIndex)
+    {
+        if((replicationMask & (1u << replicationIndex)) == 0x0u)
+        {
+            continue;
+        }
+
+        const u32 baseRegister = baseRegisters[replicationIndex];
+
+        // Computes [BaseRegister + IndexRegister * 2**IndexExponent + Offset]
+        const u32 baseAddressLow = sm->GetRegister(baseRegister + ldSt.BaseRegister);
+        const u32 baseAddressHigh = sm->GetRegister(baseRegister + ldSt.BaseRegister + 1u);
+
+        u64 address = (static_cast<u64>(baseAddressHigh) << 32) | baseAddressLow;
+
+        if constexpr(Indexed)
+        {
+            address += static_cast<u64>(sm->GetRegister(baseRegister + ldSt.IndexRegister)) * (1u << static_cast<u32>(ldSt.IndexExponent));
+        }
+
+        address += static_cast<u64>(static_cast<i64>(ldSt.Offset));
+
+        const u32 targetRegister = baseRegister + ldSt.TargetRegister;
+        const ECacheHint hint = static_cast<ECacheHint>(ldSt.CacheHint);
+
+        for(u32 i = 0; i < ldSt.RegisterCount + 1u; ++i)
+        {
+            if constexpr(Store)
+            {
+                sm->Write(address + i, sm->GetRegister(targetRegister + i), hint);
+            }
+            else
+            {
+                sm->SetRegister(targetRegister + i, sm->Read(address + i, hint));
+            }
+        }
+    }
+}
+
+template<EBinOp Op>
+[[nodiscard]] static __m256 EvaluateBinOpV(const __m256 valueA, const __m256 valueB) noexcept
+{
+    if constexpr(Op == EBinOp::Add)
+    {
+        return _mm256_add_ps(valueA, valueB);
+    }
+    else if constexpr(Op == EBinOp::Subtract)
+    {
+        return _mm256_sub_ps(valueA, valueB);
+    }
+    else if constexpr(Op == EBinOp::Multiply)
+    {
+        return _mm256_mul_ps(valueA, valueB);
+    }
+    else if constexpr(Op == EBinOp::Divide)
+    {
+        return _mm256_div_ps(valueA, valueB);
+    }
+    else
+    {
+        // There is no vector fmod, compute each lane the same way the scalar path does.
+        alignas(32) f32 a[8];
+        alignas(32) f32 b[8];
+        _mm256_store_ps(a, valueA);
+        _mm256_store_ps(b, valueB);
+
+        for(uSys i = 0; i < 8; ++i)
+        {
+            a[i] = Fpu::EvaluateBinOp<Op>(a[i], b[i]);
+        }
+
+        return _mm256_load_ps(a);
+    }
+}
+
+template<EBinOp Op>
+[[nodiscard]] static __m256d EvaluateBinOpV(const __m256d valueA, const __m256d valueB) noexcept
+{
+    if constexpr(Op == EBinOp::Add)
+    {
+        return _mm256_add_pd(valueA, valueB);
+    }
+    else if constexpr(Op == EBinOp::Subtract)
+    {
+        return _mm256_sub_pd(valueA, valueB);
+    }
+    else if constexpr(Op == EBinOp::Multiply)
+    {
+        return _mm256_mul_pd(valueA, valueB);
+    }
+    else if constexpr(Op == EBinOp::Divide)
+    {
+        return _mm256_div_pd(valueA, valueB);
+    }
+    else
+    {
+        alignas(32) f64 a[4];
+        alignas(32) f64 b[4];
+        _mm256_store_pd(a, valueA);
+        _mm256_store_pd(b, valueB);
+
+        for(uSys i = 0; i < 4; ++i)
+        {
+            a[i] = Fpu::EvaluateBinOp<Op>(a[i], b[i]);
+        }
+
+        return _mm256_load_pd(a);
+    }
+}
+
+/**
+ * \brief Executes every element of every active replication as lanes of AVX operations.
+ *
+ *   The operands of all replications are gathered from the register file
+ * first, then computed 8 floats or 4 doubles at a time, and finally
+ * scattered back in the same order the scalar path writes them. Halves
+ * are widened and narrowed with F16C using the current rounding mode,
+ * exactly like _cvtsh_ss/_cvtss_sh, so every lane is bit identical to the
+ * scalar result.
+ */
+template<EBinOp Op, EPrecision Precision, u32 ElementCount>
+static void FpuBinOpHandler(StreamingMultiprocessor* const sm, const InstructionDecodeData::InstructionData& data, const u16 baseRegisters[8], const u32 replicationMask) noexcept
+{
+    // A double is split across 2 registers, low word first, which is its little endian layout.
+    constexpr u32 RegisterCount = ElementCount * (Precision == EPrecision::Double ? 2 : 1);
+    // 8 replications of up to 4 doubles.
+    constexpr u32 MaxWordCount = 8 * 4 * 2;
+
+    alignas(32) u32 valuesA[MaxWordCount];
+    alignas(32) u32 valuesB[MaxWordCount];
+    alignas(32) u32 results[MaxWordCount];
+
+    u32 wordCount = 0;
+
+    for(u32 replicationIndex = 0; replicationIndex < 8; ++replicationIndex)
+    {
+        if(replicationMask & (1u << replicationIndex))
+        {
+            const u32 registerA = baseRegisters[replicationIndex] + data.FpuBinOp.RegisterA;
+            const u32 registerB = baseRegisters[replicationIndex] + data.FpuBinOp.RegisterB;
+
+            for(u32 i = 0; i < RegisterCount; ++i, ++wordCount)
+            {
+                valuesA[wordCount] = sm->GetRegister(registerA + i);
+                valuesB[wordCount] = sm->GetRegister(registerB + i);
+            }
+        }
+    }
+
+    // Fill out the last vector, those lanes are computed but never written back.
+    for(u32 i = wordCount; i % 8 != 0; ++i)
+    {
+        valuesA[i] = 0;
+        valuesB[i] = 0;
+    }
+
+    if constexpr(Precision == EPrecision::Double)
+    {
+        for(u32 i = 0; i < wordCount; i += 8)
+        {
+            const __m256d valueA = _mm256_load_pd(reinterpret_cast<const f64*>(valuesA + i));
+            const __m256d valueB = _mm256_load_pd(reinterpret_cast<const f64*>(valuesB + i));
+
+            _mm256_store_pd(reinterpret_cast<f64*>(results + i), EvaluateBinOpV<Op>(valueA, valueB));
+        }
+    }
+    else if constexpr(Precision == EPrecision::Half)
+    {
+        for(u32 i = 0; i < wordCount; i += 8)
+        {
+            // Narrow the register words down to their low halves, packus works within each 128 bit lane.
+            const __m256i lowHalfMask = _mm256_set1_epi32(0xFFFF);
+            const __m256i packedA = _mm256_packus_epi32(_mm256_and_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(valuesA + i)), lowHalfMask), _mm256_setzero_si256());
+            const __m256i packedB = _mm256_packus_epi32(_mm256_and_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(valuesB + i)), lowHalfMask), _mm256_setzero_si256());
+
+            const __m256 valueA = _mm256_cvtph_ps(_mm256_castsi256_si128(_mm256_permute4x64_epi64(packedA, 0x08)));
+            const __m256 valueB = _mm256_cvtph_ps(_mm256_castsi256_si128(_mm256_permute4x64_epi64(packedB, 0x08)));
+
+            const __m128i result = _mm256_cvtps_ph(EvaluateBinOpV<Op>(valueA, valueB), _MM_FROUND_CUR_DIRECTION);
+
+            _mm256_store_si256(reinterpret_cast<__m256i*>(results + i), _mm256_cvtepu16_epi32(result));
+        }
+    }
+    else
+    {
+        for(u32 i = 0; i < wordCount; i += 8)
+        {
+            const __m256 valueA = _mm256_load_ps(reinterpret_cast<const f32*>(valuesA + i));
+            const __m256 valueB = _mm256_load_ps(reinterpret_cast<const f32*>(valuesB + i));
+
+            _mm256_store_ps(reinterpret_cast<f32*>(results + i), EvaluateBinOpV<Op>(valueA, valueB));
+        }
+    }
+
+    wordCount = 0;
+
+    for(u32 replicationIndex = 0; replicationIndex < 8; ++replicationIndex)
+    {
+        if(replicationMask & (1u << replicationIndex))
+        {
+            const u32 storageRegister = baseRegisters[replicationIndex] + data.FpuBinOp.StorageRegister;
+
+            for(u32 i = 0; i < RegisterCount; ++i, ++wordCount)
+            {
+                sm->SetRegister(storageRegister + i, results[wordCount]);
+            }
+        }
+    }
+}
+
+// Used when the storage registers partially overlap an operand, each element then has to see the results of the previous ones.
+template<EBinOp Op, EPrecision Precision, u32 ElementCount>
+static void FpuBinOpSequentialHandler(StreamingMultiprocessor* const sm, const InstructionDecodeData::InstructionData& data, const u16 baseRegisters[8], const u32 replicationMask) noexcept
+{
+    for(u32 replicationIndex = 0; replicationIndex < 8; ++replicationIndex)
+    {
+        if((replicationMask & (1u << replicationIndex)) == 0x0u)
+        {
+            continue;
+        }
+
+        const u32 registerA = baseRegisters[replicationIndex] + data.FpuBinOp.RegisterA;
+        const u32 registerB = baseRegisters[replicationIndex] + data.FpuBinOp.RegisterB;
+        const u32 storageRegister = baseRegisters[replicationIndex] + data.FpuBinOp.StorageRegister;
+
+        for(u32 i = 0; i < ElementCount; ++i)
+        {
+            if constexpr(Precision == EPrecision::Double)
+            {
+                const u32 registerOffset = i * 2;
+
+                const u64 a = (static_cast<u64>(sm->GetRegister(registerA + registerOffset + 1)) << 32) | sm->GetRegister(registerA + registerOffset);
+                const u64 b = (static_cast<u64>(sm->GetRegister(registerB + registerOffset + 1)) << 32) | sm->GetRegister(registerB + registerOffset);
+
+                f64 valueA;
+                f64 valueB;
+                (void) ::std::memcpy(&valueA, &a, sizeof(valueA));
+                (void) ::std::memcpy(&valueB, &b, sizeof(valueB));
+
+                const f64 result = Fpu::EvaluateBinOp<Op>(valueA, valueB);
+
+                u64 resultU;
+                (void) ::std::memcpy(&resultU, &result, sizeof(result));
+
+                sm->SetRegister(storageRegister + registerOffset, static_cast<u32>(resultU));
+                sm->SetRegister(storageRegister + registerOffset + 1, static_cast<u32>(resultU >> 32));
+            }
+            else if constexpr(Precision == EPrecision::Half)
+            {
+                const f32 valueA = _cvtsh_ss(static_cast<u16>(sm->GetRegister(registerA + i)));
+                const f32 valueB = _cvtsh_ss(static_cast<u16>(sm->GetRegister(registerB + i)));
+
+                const f32 result = Fpu::EvaluateBinOp<Op>(valueA, valueB);
+
+                sm->SetRegister(storageRegister + i, _cvtss_sh(result, _MM_FROUND_CUR_DIRECTION));
+            }
+            else
+            {
+                const u32 a = sm->GetRegister(registerA + i);
+                const u32 b = sm->GetRegister(registerB + i);
+
+                f32 valueA;
+                f32 valueB;
+                (void) ::std::memcpy(&valueA, &a, sizeof(valueA));
+                (void) ::std::memcpy(&valueB, &b, sizeof(valueB));
+
+                const f32 result = Fpu::EvaluateBinOp<Op>(valueA, valueB);
+
+                u32 resultU;
+                (void) ::std::memcpy(&resultU, &result, sizeof(result));
+
+                sm->SetRegister(storageRegister + i, resultU);
+            }
+        }
+    }
+}
+
+template<EBinOp Op, EPrecision Precision, u32 ElementCount>
+[[nodiscard]] static ThreadedOpHandler SelectFpuBinOpHandler(const InstructionDecodeData::FpuBinOpData& binOp) noexcept
+{
+    constexpr u32 RegisterCount = ElementCount * (Precision == EPrecision::Double ? 2 : 1);
+
+    // Writing element i would change an operand of a later element.
+    const bool overlapsA = binOp.StorageRegister > binOp.RegisterA && binOp.StorageRegister < binOp.RegisterA + RegisterCount;
+    const bool overlapsB = binOp.StorageRegister > binOp.RegisterB && binOp.StorageRegister < binOp.RegisterB + RegisterCount;
+
+    if(overlapsA || overlapsB)
+    {
+        return FpuBinOpSequentialHandler<Op, Precision, ElementCount>;
+    }
+
+    return FpuBinOpHandler<Op, Precision, ElementCount>;
+}
+
+template<EBinOp Op, EPrecision Precision>
+[[nodiscard]] static ThreadedOpHandler SelectFpuBinOpHandler(const InstructionDecodeData::FpuBinOpData& binOp) noexcept
+{
+    switch(binOp.RegisterCount)
+    {
+        case 1: return SelectFpuBinOpHandler<Op, Precision, 1>(binOp);
+        case 2: return SelectFpuBinOpHandler<Op, Precision, 2>(binOp);
+        case 3: return SelectFpuBinOpHandler<Op, Precision, 3>(binOp);
+        case 4: return SelectFpuBinOpHandler<Op, Precision, 4>(binOp);
+        default: return nullptr;
+    }
+}
+
+template<EBinOp Op>
+[[nodiscard]] static ThreadedOpHandler SelectFpuBinOpHandler(const EPrecision precision, const InstructionDecodeData::FpuBinOpData& binOp) noexcept
+{
+    switch(precision)
+    {
+        case EPrecision::Single: return SelectFpuBinOpHandler<Op, EPrecision::Single>(binOp);
+        case EPrecision::Half: return SelectFpuBinOpHandler<Op, EPrecision::Half>(binOp);
+        case EPrecision::Double: return SelectFpuBinOpHandler<Op, EPrecision::Double>(binOp);
+        default: return nullptr;
+    }
+}
+
+[[nodiscard]] static ThreadedOpHandler SelectFpuBinOpHandler(const InstructionDecodeData::FpuBinOpData& binOp) noexcept
+{
+    switch(binOp.BinOp)
+    {
+        case EBinOp::Add: return SelectFpuBinOpHandler<EBinOp::Add>(binOp.Precision, binOp);
+        case EBinOp::Subtract: return SelectFpuBinOpHandler<EBinOp::Subtract>(binOp.Precision, binOp);
+        case EBinOp::Multiply: return SelectFpuBinOpHandler<EBinOp::Multiply>(binOp.Precision, binOp);
+        case EBinOp::Divide: return SelectFpuBinOpHandler<EBinOp::Divide>(binOp.Precision, binOp);
+        case EBinOp::Remainder: return SelectFpuBinOpHandler<EBinOp::Remainder>(binOp.Precision, binOp);
+        default: return nullptr;
+    }
+}
+
+ThreadedOpHandler SelectThreadedOpHandler(const EInstruction instruction, const InstructionDecodeData::InstructionData& data) noexcept
+{
+    switch(instruction)
+    {
+        case EInstruction::LoadImmediate: return LoadImmediateHandler;
+        case EInstruction::LoadStore:
+            // If the exponent is 111 then ignore the indexing register.
+            if(data.LoadStore.ReadWrite)
+            {
+                return data.LoadStore.IndexExponent != 7u ? LoadStoreHandler<true, true> : LoadStoreHandler<true, false>;
+            }
+            else
+            {
+                return data.LoadStore.IndexExponent != 7u ? LoadStoreHandler<false, true> : LoadStoreHandler<false, false>;
+            }
+        default:
+            if(instruction >= EInstruction::AddF && instruction <= EInstruction::RemVec4D)
+            {
+                return SelectFpuBinOpHandler(data.FpuBinOp);
+            }
+
+            return nullptr;
+    }
+}
@@ -0,0 +1,141 @@
+#include "WriteCombiningBuffer.hpp"
+#include "Processor.hpp"
+
+void WriteCombiningBuffer::Write(const u64 address, const u32 value, const bool external, const bool writeThrough, const u64 cycle) noexcept
+{
+    const u64 lineAddress = address >> 3;
+    const u32 wordIndex = static_cast<u32>(address & (CACHE_LINE_WORD_COUNT - 1));
+
+    ++m_Statistics.Stores;
+
+    u32 entryIndex = ENTRY_COUNT;
+
+    for(u32 validMask = ValidMask(); validMask != 0; validMask &= validMask - 1)
+    {
+        const u32 i = _tzcnt_u32(validMask);
+        const Entry& entry = m_Entries[i];
+
+        if(entry.LineAddress == lineAddress && entry.External == external && entry.WriteThrough == writeThrough)
+        {
+            entryIndex = i;
+            break;
+        }
+    }
+
+    if(entryIndex == ENTRY_COUNT)
+    {
+        // Make room by draining the entry closest to its timeout, which is also the oldest.
+        if(ValidMask() == (1u << ENTRY_COUNT) - 1)
+        {
+            u32 oldestIndex = 0;
+
+            for(u32 i = 1; i < ENTRY_COUNT; ++i)
+            {
+                if(m_Entries[i].Deadline < m_Entries[oldestIndex].Deadline)
+                {
+                    oldestIndex = i;
+                }
+            }
+
+            Drain(oldestIndex);
+        }
+
+        entryIndex = _tzcnt_u32(~ValidMask());
+
+        Entry& entry = m_Entries[entryIndex];
+        entry.LineAddress = lineAddress;
+        entry.Deadline = cycle + TIMEOUT_CYCLES;
+        entry.WordMask = 0;
+        entry.External = external;
+        entry.WriteThrough = writeThrough;
+        SetValidMask(ValidMask() | (1u << entryIndex));
+    }
+
+    Entry& entry = m_Entries[entryIndex];
+    entry.Data[wordIndex] = value;
+    entry.WordMask |= 1u << wordIndex;
+
+    // Nothing more can combine into a complete line.
+    if(entry.WordMask == FULL_WORD_MASK)
+    {
+        Drain(entryIndex);
+    }
+}
+
+void WriteCombiningBuffer::DrainLine(const u64 address, const bool external) noexcept
+{
+    const u64 lineAddress = address >> 3;
+
+    for(u32 validMask = ValidMask(); validMask != 0; validMask &= validMask - 1)
+    {
+        const u32 i = _tzcnt_u32(validMask);
+
+        if(m_Entries[i].LineAddress == lineAddress && m_Entries[i].External == external)
+        {
+            Drain(i);
+        }
+    }
+}
+
+void WriteCombiningBuffer::DrainUncachedLine(const u64 address, const bool external) noexcept
+{
+    const u64 lineAddress = address >> 3;
+
+    for(u32 validMask = ValidMask(); validMask != 0; validMask &= validMask - 1)
+    {
+        const u32 i = _tzcnt_u32(validMask);
+
+        if(m_Entries[i].LineAddress == lineAddress && m_Entries[i].External == external && !m_Entries[i].WriteThrough)
+        {
+            Drain(i);
+        }
+    }
+}
+
+void WriteCombiningBuffer::DrainExpired(const u64 cycle) noexcept
+{
+    for(u32 validMask = ValidMask(); validMask != 0; validMask &= validMask - 1)
+    {
+        const u32 i = _tzcnt_u32(validMask);
+
+        if(m_Entries[i].Deadline <= cycle)
+        {
+            Drain(i);
+        }
+    }
+}
+
+void WriteCombiningBuffer::DrainAll() noexcept
+{
+    for(u32 validMask = ValidMask(); validMask != 0; validMask &= validMask - 1)
+    {
+        Drain(_tzcnt_u32(validMask));
+    }
+}
+
+void WriteCombiningBuffer::Drain(const u32 entryIndex) noexcept
+{
+    const Entry& entry = m_Entries[entryIndex];
+    const u64 address = entry.LineAddress << 3;
+
+    SetValidMask(ValidMask() & ~(1u << entryIndex));
+
+    if(entry.WriteThrough)
+    {
+        // An L0 holds the stores, ours or another SM's that took the line since, the flush writes it through the L2 to memory.
+        m_Processor->FlushSharedCacheLine(address, entry.External);
+        ++m_Statistics.MemoryWrites;
+        return;
+    }
+
+    for(u32 wordMask = entry.WordMask; wordMask != 0;)
+    {
+        const u32 firstWord = _tzcnt_u32(wordMask);
+        const u32 wordCount = _tzcnt_u32(~(wordMask >> firstWord));
+
+        m_Processor->MemWritePhyBlock(address + firstWord, entry.Data + firstWord, wordCount, entry.External);
+        ++m_Statistics.MemoryWrites;
+
+        wordMask &= ~(((1u << wordCount) - 1) << firstWord);
+    }
+}
@@ -0,0 +1,609 @@
+#include <ConPrinter.hpp>
+
+#include <PageTableBuilder.hpp>
+#include <Processor.hpp>
+
+#include <new>
+
+static void ResetCaches() noexcept;
+[[nodiscard]] static u64 LineAddress(u64 line) noexcept;
+[[nodiscard]] static u64 SetLineAddress(u64 way) noexcept;
+[[nodiscard]] static u32 MemoryValue(u64 address) noexcept;
+[[nodiscard]] static PageEntry* AllocatePageTable(void* userData) noexcept;
+static void FreePageTables() noexcept;
+
+static void TestSharedL2() noexcept;
+static void TestSharerTracking() noexcept;
+static void TestStridePrefetch() noexcept;
+static void TestOwnedSupply() noexcept;
+static void TestDirtyOnlyFlush() noexcept;
+static void TestNonTemporalBypass() noexcept;
+static void TestStreamingEvictedFirst() noexcept;
+static void TestKeepSurvivesEviction() noexcept;
+static void TestHostCoherence() noexcept;
+static void TestWriteThroughTakenLine() noexcept;
+static void TestSetTagCompare() noexcept;
+static void TestEveryWayHits() noexcept;
+
+// Lines this far apart map to the same L0 set.
+static inline constexpr u64 L0_SET_STRIDE = 1ull << Topology.L0IndexBits;
+static inline constexpr u64 TEST_LINE_COUNT = L0_SET_STRIDE * (Topology.L0SetLineCount * 3 + 1);
+// The prefetcher won't cross a 64 KiB page, so the test lines start on one.
+static inline constexpr u64 PAGE_WORD_COUNT = 16384;
+
+static Processor CacheProcessor;
+alignas(4096) static u32 MemoryBuffer[TEST_LINE_COUNT * CACHE_LINE_WORD_COUNT + PAGE_WORD_COUNT];
+// The test lines, and the word address of the first one, memory is addressed in host words.
+static u32* TestMemory;
+static u64 MemoryBase;
+
+// The page directory and the one page table SM 0 needs for a write-through page.
+static PageEntry* PageTables[2];
+static u32 PageTableCount = 0;
+
+namespace tau::test::cache {
+
+void RunTests() noexcept
+{
+    const uintptr_t pageBytes = PAGE_WORD_COUNT * sizeof(u32);
+    TestMemory = reinterpret_cast<u32*>((reinterpret_cast<uintptr_t>(MemoryBuffer) + pageBytes - 1) & ~(pageBytes - 1));
+    MemoryBase = reinterpret_cast<uintptr_t>(TestMemory) >> 2;
+
+    TestSharedL2();
+    TestSharerTracking();
+    TestStridePrefetch();
+    TestOwnedSupply();
+    TestDirtyOnlyFlush();
+    TestNonTemporalBypass();
+    TestStreamingEvictedFirst();
+    TestKeepSurvivesEviction();
+    TestHostCoherence();
+    TestWriteThroughTakenLine();
+    TestSetTagCompare();
+    TestEveryWayHits();
+}
+
+}
+
+static void ResetCaches() noexcept
+{
+    CacheProcessor.Reset();
+
+    // Every word holds its own offset, so a read shows where its data came from.
+    for(u64 i = 0; i < TEST_LINE_COUNT * CACHE_LINE_WORD_COUNT; ++i)
+    {
+        TestMemory[i] = static_cast<u32>(i);
+    }
+}
+
+static u64 LineAddress(const u64 line) noexcept
+{
+    return MemoryBase + line * CACHE_LINE_WORD_COUNT;
+}
+
+// The way-th line of the L0 set the test lines start in.
+static u64 SetLineAddress(const u64 way) noexcept
+{
+    return LineAddress(way * L0_SET_STRIDE);
+}
+
+static u32 MemoryValue(const u64 address) noexcept
+{
+    return static_cast<u32>(address - MemoryBase);
+}
+
+static void TestSharedL2() noexcept
+{
+    ResetCaches();
+
+    const u64 address = LineAddress(1) + 3;
+
+    ECacheLevel firstServedBy;
+    const u32 firstValue = CacheProcessor.Read(0, address, false, false, &firstServedBy);
+
+    // Push the line out of SM 0's L0, the L2 is inclusive of the L0s but not the other way around.
+    for(u64 i = 1; i <= Topology.L0SetLineCount; ++i)
+    {
+        (void) CacheProcessor.Read(0, LineAddress(1 + i * L0_SET_STRIDE));
+    }
+
+    ECacheLevel secondServedBy;
+    const u32 secondValue = CacheProcessor.Read(1, address, false, false, &secondServedBy);
+
+    const CacheStatistics statistics = CacheProcessor.L2CacheStatistics();
+
+    if(firstValue != MemoryValue(address) || secondValue != MemoryValue(address))
+    {
+        ConPrinter::PrintLn("The shared L2 returned {} and {}, expected {}.", firstValue, secondValue, MemoryValue(address));
+    }
+    else if(CacheProcessor.CacheContains(0, address))
+    {
+        ConPrinter::PrintLn("The line was not evicted from SM 0's L0.");
+    }
+    else if(firstServedBy != ECacheLevel::Memory || secondServedBy != ECacheLevel::L2 || statistics.ReadHits != 1)
+    {
+        ConPrinter::PrintLn("The first read was served by {}, the second by {} with {} L2 hits, expected memory, then the L2 with 1 hit.", static_cast<u32>(firstServedBy), static_cast<u32>(secondServedBy), statistics.ReadHits);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully served another SM's miss from the shared L2.");
+    }
+}
+
+static void TestSharerTracking() noexcept
+{
+    ResetCaches();
+
+    const u64 address = LineAddress(2);
+
+    (void) CacheProcessor.Read(0, address);
+
+    const u32 readSharers = CacheProcessor.L2Sharers(address);
+
+    // A store takes the line exclusively, the L0 that read it is snooped and invalidated.
+    CacheProcessor.Write(1, address, 0xC0DE);
+
+    const u32 writeSharers = CacheProcessor.L2Sharers(address);
+    const bool readerInvalidated = !CacheProcessor.CacheContains(0, address);
+    const u32 readBack = CacheProcessor.Read(0, address);
+    const u32 readBackSharers = CacheProcessor.L2Sharers(address);
+
+    if(readSharers != 0x1 || writeSharers != 0x2 || readBackSharers != 0x3)
+    {
+        ConPrinter::PrintLn("The L2 tracked sharers 0x{X} after the read, 0x{X} after the store and 0x{X} after the read back.", readSharers, writeSharers, readBackSharers);
+    }
+    else if(!readerInvalidated || readBack != 0xC0DE)
+    {
+        ConPrinter::PrintLn("The store left the reader's copy valid {} and the reader then read 0x{X}.", !readerInvalidated, readBack);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully tracked the sharers of a line through a store.");
+    }
+}
+
+static void TestStridePrefetch() noexcept
+{
+    ResetCaches();
+
+    // The first miss starts a stream, the second sets its stride and the third confirms it.
+    constexpr u64 stride = 3;
+
+    for(u64 i = 0; i < 3; ++i)
+    {
+        (void) CacheProcessor.Read(0, LineAddress(i * stride));
+    }
+
+    const u64 issued = CacheProcessor.L0PrefetcherStatistics(0).Issued;
+    const bool aheadPrefetched = CacheProcessor.CacheContains(0, LineAddress(3 * stride)) && CacheProcessor.CacheContains(0, LineAddress(4 * stride));
+    const bool betweenPrefetched = CacheProcessor.CacheContains(0, LineAddress(3 * stride - 1));
+
+    ECacheLevel servedBy;
+    const u32 value = CacheProcessor.Read(0, LineAddress(3 * stride) + 1, false, false, &servedBy);
+
+    if(issued != StridePrefetcher::INITIAL_DEGREE || !aheadPrefetched || betweenPrefetched)
+    {
+        ConPrinter::PrintLn("The prefetcher issued {} lines, the next {} along the stride present {}, a line off the stride present {}.", issued, StridePrefetcher::INITIAL_DEGREE, aheadPrefetched, betweenPrefetched);
+    }
+    else if(servedBy != ECacheLevel::L0 || value != MemoryValue(LineAddress(3 * stride) + 1) || CacheProcessor.L0PrefetcherStatistics(0).Useful != 1)
+    {
+        ConPrinter::PrintLn("The demand read of a prefetched line was served by {} with 0x{X}, {} prefetches useful.", static_cast<u32>(servedBy), value, CacheProcessor.L0PrefetcherStatistics(0).Useful);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully prefetched ahead of a stride of {} lines.", stride);
+    }
+}
+
+static void TestOwnedSupply() noexcept
+{
+    ResetCaches();
+
+    const u64 address = LineAddress(4) + 5;
+
+    CacheProcessor.Write(0, address, 0xD1D1);
+
+    // A peer reading a dirty line gets the data cache to cache. Under MOESI the writer keeps it Owned, MESI writes it back to the L2 first.
+    const u32 peerValue = CacheProcessor.Read(1, address);
+    const u64 supplyWriteBacks = CacheProcessor.L2CacheStatistics().WriteHits;
+    const bool writerKeptLine = CacheProcessor.CacheContains(0, address);
+
+    // The owner still has to write the line back when it is flushed.
+    CacheProcessor.FlushCache(0);
+
+    const u64 flushWriteBacks = CacheProcessor.L2CacheStatistics().WriteHits - supplyWriteBacks;
+    const u32 memoryValue = TestMemory[address - MemoryBase];
+
+    constexpr bool moesi = Topology.L0Coherence == ECoherenceProtocol::Moesi;
+    constexpr u64 expectedSupplyWriteBacks = moesi ? 0 : 1;
+    constexpr u64 expectedFlushWriteBacks = moesi ? 1 : 0;
+
+    if(peerValue != 0xD1D1 || !writerKeptLine)
+    {
+        ConPrinter::PrintLn("The peer read 0x{X} from the dirty line, the writer kept its copy {}.", peerValue, writerKeptLine);
+    }
+    else if(supplyWriteBacks != expectedSupplyWriteBacks || flushWriteBacks != expectedFlushWriteBacks)
+    {
+        ConPrinter::PrintLn("Supplying the peer wrote the line back {} times and the flush {} times, expected {} and {}.", supplyWriteBacks, flushWriteBacks, expectedSupplyWriteBacks, expectedFlushWriteBacks);
+    }
+    else if(memoryValue != 0xD1D1)
+    {
+        ConPrinter::PrintLn("Memory held 0x{X} after the flush.", memoryValue);
+    }
+    else if constexpr(moesi)
+    {
+        ConPrinter::PrintLn("Successfully supplied an Owned line to a peer L0.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully supplied a dirty line to a peer L0 through the L2.");
+    }
+}
+
+static void TestDirtyOnlyFlush() noexcept
+{
+    ResetCaches();
+
+    // Far enough apart that the stride prefetcher leaves them alone.
+    constexpr u64 lineStride = StridePrefetcher::MAX_STRIDE + 1;
+    constexpr u64 cleanLineCount = 6;
+
+    for(u64 i = 0; i < cleanLineCount; ++i)
+    {
+        (void) CacheProcessor.Read(0, LineAddress(i * lineStride));
+    }
+
+    CacheProcessor.Write(0, LineAddress(cleanLineCount * lineStride), 0xF1F1);
+    CacheProcessor.Write(0, LineAddress((cleanLineCount + 1) * lineStride), 0xF2F2);
+
+    CacheProcessor.FlushCache(0);
+
+    const CacheStatistics firstFlush = CacheProcessor.L2CacheStatistics();
+
+    // Everything is clean now, a second flush has nothing to write.
+    CacheProcessor.FlushCache(0);
+
+    const CacheStatistics secondFlush = CacheProcessor.L2CacheStatistics();
+
+    bool linesKept = true;
+
+    for(u64 i = 0; i < cleanLineCount + 2; ++i)
+    {
+        linesKept &= CacheProcessor.CacheContains(0, LineAddress(i * lineStride));
+    }
+
+    if(firstFlush.WriteHits != 2 || firstFlush.MemoryWrites != 2)
+    {
+        ConPrinter::PrintLn("Flushing 2 dirty and {} clean lines wrote {} lines to the L2 and {} to memory, expected 2 and 2.", cleanLineCount, firstFlush.WriteHits, firstFlush.MemoryWrites);
+    }
+    else if(secondFlush.WriteHits != firstFlush.WriteHits || secondFlush.MemoryWrites != firstFlush.MemoryWrites)
+    {
+        ConPrinter::PrintLn("Flushing a clean cache wrote {} lines to the L2 and {} to memory.", secondFlush.WriteHits - firstFlush.WriteHits, secondFlush.MemoryWrites - firstFlush.MemoryWrites);
+    }
+    else if(!linesKept || TestMemory[cleanLineCount * lineStride * CACHE_LINE_WORD_COUNT] != 0xF1F1)
+    {
+        ConPrinter::PrintLn("The flush dropped lines {} or left memory stale.", !linesKept);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully flushed only the dirty lines.");
+    }
+}
+
+static void TestNonTemporalBypass() noexcept
+{
+    ResetCaches();
+
+    for(u64 i = 0; i < Topology.L0SetLineCount; ++i)
+    {
+        (void) CacheProcessor.Read(0, SetLineAddress(i));
+    }
+
+    // As many non-temporal misses again in the full set, none of them may take a way.
+    bool valuesCorrect = true;
+    bool bypassed = true;
+
+    for(u64 i = Topology.L0SetLineCount; i < Topology.L0SetLineCount * 2; ++i)
+    {
+        valuesCorrect &= CacheProcessor.Read(0, SetLineAddress(i), false, false, nullptr, ECacheHint::NonTemporal) == MemoryValue(SetLineAddress(i));
+        bypassed &= !CacheProcessor.CacheContains(0, SetLineAddress(i));
+    }
+
+    bool linesKept = true;
+
+    for(u64 i = 0; i < Topology.L0SetLineCount; ++i)
+    {
+        linesKept &= CacheProcessor.CacheContains(0, SetLineAddress(i));
+    }
+
+    if(!valuesCorrect || !bypassed || !linesKept)
+    {
+        ConPrinter::PrintLn("Non-temporal reads: values correct {}, bypassed the L0 {}, resident lines kept {}.", valuesCorrect, bypassed, linesKept);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully read {} non-temporal lines without disturbing a full L0 set.", Topology.L0SetLineCount);
+    }
+}
+
+static void TestStreamingEvictedFirst() noexcept
+{
+    ResetCaches();
+
+    // Fill the set, the streaming line last. It must be the next victim rather than any of the lines in use.
+    for(u64 i = 0; i < Topology.L0SetLineCount - 1; ++i)
+    {
+        CacheProcessor.Write(0, SetLineAddress(i), 0xA000 + static_cast<u32>(i));
+    }
+
+    const u64 streamingLine = SetLineAddress(Topology.L0SetLineCount - 1);
+    (void) CacheProcessor.Read(0, streamingLine, false, false, nullptr, ECacheHint::Streaming);
+    const bool streamingAllocated = CacheProcessor.CacheContains(0, streamingLine);
+
+    (void) CacheProcessor.Read(0, SetLineAddress(Topology.L0SetLineCount));
+
+    bool linesKept = true;
+
+    for(u64 i = 0; i < Topology.L0SetLineCount - 1; ++i)
+    {
+        linesKept &= CacheProcessor.CacheContains(0, SetLineAddress(i));
+    }
+
+    if(!streamingAllocated || CacheProcessor.CacheContains(0, streamingLine) || !linesKept)
+    {
+        ConPrinter::PrintLn("Streaming read: allocated {}, evicted first {}, other lines kept {}.", streamingAllocated, !CacheProcessor.CacheContains(0, streamingLine), linesKept);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully evicted a streaming line before the lines in use.");
+    }
+}
+
+static void TestKeepSurvivesEviction() noexcept
+{
+    ResetCaches();
+
+    const u64 keptLine = SetLineAddress(0);
+    (void) CacheProcessor.Read(0, keptLine, false, false, nullptr, ECacheHint::Keep);
+
+    // Cycle enough lines through the set to replace every way several times over.
+    for(u64 i = 1; i <= Topology.L0SetLineCount * 3; ++i)
+    {
+        (void) CacheProcessor.Read(0, SetLineAddress(i));
+    }
+
+    ECacheLevel servedBy;
+    const u32 value = CacheProcessor.Read(0, keptLine, false, false, &servedBy);
+
+    if(servedBy != ECacheLevel::L0 || value != MemoryValue(keptLine))
+    {
+        ConPrinter::PrintLn("The kept line was served by {} with 0x{X} after {} other lines went through its set.", static_cast<u32>(servedBy), value, Topology.L0SetLineCount * 3);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully kept a line through {} evictions from its set.", Topology.L0SetLineCount * 3 - (Topology.L0SetLineCount - 1));
+    }
+}
+
+static void TestHostCoherence() noexcept
+{
+    ResetCaches();
+
+    const u64 address = LineAddress(5) + 2;
+    // BAR1 accesses are in bytes.
+    const u64 hostAddress = address << 2;
+
+    CacheProcessor.Write(0, address, 0x11223344);
+    CacheProcessor.Write(0, address + 1, 0x55667788);
+
+    // The stores are only in SM 0's L0, the host has to snoop them.
+    u32 gpuStores[2];
+    CacheProcessor.HostMemRead(hostAddress, gpuStores, sizeof(gpuStores));
+
+    // A partial write over the middle of the first word, the bytes around it must keep the GPU's data.
+    const u16 hostHalf = 0xAABB;
+    CacheProcessor.HostMemWrite(hostAddress + 1, &hostHalf, sizeof(hostHalf));
+
+    u32 hostRead;
+    CacheProcessor.HostMemRead(hostAddress, &hostRead, sizeof(hostRead));
+
+    ECacheLevel servedBy;
+    const u32 gpuRead = CacheProcessor.Read(0, address, false, false, &servedBy);
+    const u32 gpuReadNext = CacheProcessor.Read(0, address + 1);
+
+    if(gpuStores[0] != 0x11223344 || gpuStores[1] != 0x55667788)
+    {
+        ConPrinter::PrintLn("The host read 0x{X} 0x{X} after the GPU stores.", gpuStores[0], gpuStores[1]);
+    }
+    else if(hostRead != 0x11AABB44 || gpuRead != 0x11AABB44 || gpuReadNext != 0x55667788)
+    {
+        ConPrinter::PrintLn("After the host write the host read 0x{X} and the GPU 0x{X} 0x{X}, expected 0x11AABB44 and 0x11AABB44 0x55667788.", hostRead, gpuRead, gpuReadNext);
+    }
+    else if(servedBy == ECacheLevel::L0)
+    {
+        ConPrinter::PrintLn("The host write left SM 0's stale copy of the line in its L0.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully kept host writes coherent with GPU stores.");
+    }
+}
+
+static void TestWriteThroughTakenLine() noexcept
+{
+    ResetCaches();
+
+    const u64 address = LineAddress(6);
+    const u64 page = address >> Mmu::PAGE_OFFSET_BITS;
+
+    PageEntry flags;
+    flags.Value = 0;
+    flags.ReadWrite = true;
+    flags.WriteThrough = true;
+
+    // SM 0 sees the test memory as a write-through page, SM 1 has no page tables and caches it as usual.
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    if(!pageDirectory || !builder.Map(page, page, 1, flags))
+    {
+        ConPrinter::PrintLn("Failed to map the write-through page.");
+        FreePageTables();
+        return;
+    }
+
+    CacheProcessor.TestMmu(0).LoadPageDirectoryPointer(reinterpret_cast<u64>(pageDirectory) / GpuPageSize, 0);
+
+    // SM 1 takes the line SM 0's store left in its L0 before SM 0's buffer drains, under MOESI the dirty data goes with it.
+    CacheProcessor.TestWrite(0, address, 0x11223344);
+    CacheProcessor.TestWrite(1, address + 1, 0x55667788);
+
+    // Nothing runs, the buffered store alone has to keep the processor clocking until it times out.
+    for(u64 i = 0; i <= WriteCombiningBuffer::TIMEOUT_CYCLES; ++i)
+    {
+        CacheProcessor.Clock();
+    }
+
+    const u32 memoryValue = TestMemory[address - MemoryBase];
+
+    if(memoryValue != 0x11223344)
+    {
+        ConPrinter::PrintLn("Memory held 0x{X} after a write-through store drained from a line another SM took, expected 0x11223344.", memoryValue);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully wrote through a store whose line another SM took.");
+    }
+
+    CacheProcessor.Reset();
+    FreePageTables();
+}
+
+static void TestSetTagCompare() noexcept
+{
+    // 5 ways pad the keys to 8, so way 4 is compared in the second AVX2 lane group next to 3 padding keys.
+    using TestSet = CacheSet<5>;
+    static_assert(TestSet::KEY_COUNT == 8);
+
+    TestSet set;
+    set.Reset();
+
+    for(uSys way = 0; way < 5; ++way)
+    {
+        set.Keys[way] = TestSet::MakeKey(0x100 + way, way == 4);
+        (void) set.SetState(way, MESI::Exclusive);
+    }
+
+    bool waysFound = true;
+
+    for(uSys way = 0; way < 5; ++way)
+    {
+        const u64 key = TestSet::MakeKey(0x100 + way, way == 4);
+        waysFound &= set.FindWay(key) == way && set.Match(key) == (1u << way);
+    }
+
+    // Only the External bit tells these apart from ways 4 and 0.
+    const uSys internalWay = set.FindWay(TestSet::MakeKey(0x104, false));
+    const uSys externalWay = set.FindWay(TestSet::MakeKey(0x100, true));
+    const uSys missingWay = set.FindWay(TestSet::MakeKey(0x105, false));
+
+    // Way 4's dirty bit has to follow it through Modified, Owned and back to clean like any other way.
+    const bool modifiedDirty = set.SetState(4, MESI::Modified) && set.DirtyMask == 0x10;
+    const bool ownedDirty = set.SetState(4, MESI::Owned) && set.DirtyMask == 0x10;
+    const bool sharedClean = !set.SetState(4, MESI::Shared) && set.DirtyMask == 0 && set.States[4] == MESI::Shared;
+
+    if(!waysFound || internalWay != TestSet::NO_WAY || externalWay != TestSet::NO_WAY || missingWay != TestSet::NO_WAY)
+    {
+        ConPrinter::PrintLn("Every way found {}, the wrong External bit found ways {} and {}, a missing tag found way {}.", waysFound, internalWay, externalWay, missingWay);
+    }
+    else if(!modifiedDirty || !ownedDirty || !sharedClean)
+    {
+        ConPrinter::PrintLn("Way 4 was dirty {} when Modified, {} when Owned and clean {} when Shared, dirty mask 0x{X}.", modifiedDirty, ownedDirty, sharedClean, set.DirtyMask);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully matched every way of a set, including the way past the SIMD width.");
+    }
+}
+
+static void TestEveryWayHits() noexcept
+{
+    ResetCaches();
+
+    for(u64 i = 0; i < Topology.L0SetLineCount; ++i)
+    {
+        (void) CacheProcessor.Read(0, SetLineAddress(i));
+    }
+
+    bool everyWayHit = true;
+    bool valuesCorrect = true;
+
+    for(u64 i = 0; i < Topology.L0SetLineCount; ++i)
+    {
+        ECacheLevel servedBy;
+        valuesCorrect &= CacheProcessor.Read(0, SetLineAddress(i), false, false, &servedBy) == MemoryValue(SetLineAddress(i));
+        everyWayHit &= servedBy == ECacheLevel::L0;
+    }
+
+    // The last way is the one past the first 4 keys on the wide topologies, take it through a share and an invalidation.
+    const u64 lastAddress = SetLineAddress(Topology.L0SetLineCount - 1);
+
+    CacheProcessor.Write(0, lastAddress, 0xC0DE);
+    const u32 peerValue = CacheProcessor.Read(1, lastAddress);
+    const bool shared = CacheProcessor.CacheContains(0, lastAddress) && CacheProcessor.CacheContains(1, lastAddress);
+
+    CacheProcessor.Write(0, lastAddress, 0xBEEF);
+    const bool peerInvalidated = !CacheProcessor.CacheContains(1, lastAddress);
+
+    for(u64 i = 0; i < Topology.L0SetLineCount; ++i)
+    {
+        const u32 expected = i == Topology.L0SetLineCount - 1 ? 0xBEEF : MemoryValue(SetLineAddress(i));
+
+        ECacheLevel servedBy;
+        valuesCorrect &= CacheProcessor.Read(0, SetLineAddress(i), false, false, &servedBy) == expected;
+        everyWayHit &= servedBy == ECacheLevel::L0;
+    }
+
+    if(!everyWayHit || !valuesCorrect)
+    {
+        ConPrinter::PrintLn("Reading back a full L0 set: every way hit {}, values correct {}.", everyWayHit, valuesCorrect);
+    }
+    else if(peerValue != 0xC0DE || !shared || !peerInvalidated)
+    {
+        ConPrinter::PrintLn("The last way gave SM 1 0x{X}, was shared {} and then invalidated in SM 1 {}, expected 0xC0DE shared then invalidated.", peerValue, shared, peerInvalidated);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully hit all {} ways of an L0 set through a share and an invalidation.", Topology.L0SetLineCount);
+    }
+}
+
+static PageEntry* AllocatePageTable(void*) noexcept
+{
+    if(PageTableCount == sizeof(PageTables) / sizeof(PageTables[0]))
+    {
+        return nullptr;
+    }
+
+    void* const pageTable = ::operator new(GpuPageTableSize, ::std::align_val_t { GpuPageSize }, ::std::nothrow);
+
+    if(!pageTable)
+    {
+        return nullptr;
+    }
+
+    (void) ::std::memset(pageTable, 0, GpuPageTableSize);
+
+    PageTables[PageTableCount++] = static_cast<PageEntry*>(pageTable);
+    return static_cast<PageEntry*>(pageTable);
+}
+
+static void FreePageTables() noexcept
+{
+    for(u32 i = 0; i < PageTableCount; ++i)
+    {
+        ::operator delete(PageTables[i], ::std::align_val_t { GpuPageSize });
+    }
+
+    PageTableCount = 0;
+}
@@ -0,0 +1,179 @@
+#include <ConPrinter.hpp>
+
+#include <DecodedInstructionCache.hpp>
+#include <Processor.hpp>
+
+static void TestWriteThroughAlias() noexcept;
+static void TestWriteToOtherLine() noexcept;
+static void TestWriteAppliedOnSync() noexcept;
+static void TestWriteFromOtherSM() noexcept;
+
+static inline constexpr u32 PROGRAM_CYCLE_COUNT = 128;
+static inline constexpr u32 ORIGINAL_IMMEDIATE = 0x11111111;
+static inline constexpr u32 PATCHED_IMMEDIATE = 0x22222222;
+
+static DecodedInstructionCache DecodeCache;
+static Processor DecodeProcessor;
+// Nop, Nop, LoadImmediate r0, Hlt. The immediate is the second word so a single store can patch it.
+alignas(4) static u8 PatchedProgram[12];
+alignas(4) static u8 PatchingProgram[32];
+
+namespace tau::test::decoded_instruction_cache {
+
+void RunTests() noexcept
+{
+    TestWriteThroughAlias();
+    TestWriteToOtherLine();
+    TestWriteAppliedOnSync();
+    TestWriteFromOtherSM();
+}
+
+}
+
+// Fetches and decodes the instruction at virtualAddress, which is backed by the physical word physicalAddress.
+static void DecodeAt(const u64 virtualAddress, const u64 physicalAddress) noexcept
+{
+    DecodeCache.MarkCodeLine(physicalAddress);
+    DecodeCache.Insert(virtualAddress, virtualAddress + 1, EInstruction::Nop, { });
+}
+
+static void TestWriteThroughAlias() noexcept
+{
+    DecodeCache.Reset();
+
+    // The code is executed from one virtual page and written through another, only the physical line is shared.
+    DecodeAt(0x4000, 0x9000 >> 2);
+    DecodeCache.NotifyWrite(0x9004 >> 2);
+    DecodeCache.SyncPendingInvalidate();
+
+    if(DecodeCache.Lookup(0x4000))
+    {
+        ConPrinter::PrintLn("A write to the physical line of a decoded instruction did not invalidate it.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully invalidated a decoded instruction written through another virtual address.");
+    }
+}
+
+static void TestWriteToOtherLine() noexcept
+{
+    DecodeCache.Reset();
+
+    // The virtual address of the code is the physical address of the write, that must not matter.
+    DecodeAt(0x4000, 0x9000 >> 2);
+    DecodeCache.NotifyWrite(0x4000 >> 2);
+    DecodeCache.SyncPendingInvalidate();
+
+    if(!DecodeCache.Lookup(0x4000))
+    {
+        ConPrinter::PrintLn("A write to an unrelated physical line invalidated a decoded instruction.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully kept a decoded instruction over a write to another line.");
+    }
+}
+
+static void TestWriteAppliedOnSync() noexcept
+{
+    DecodeCache.Reset();
+
+    DecodeAt(0x4000, 0x9000 >> 2);
+
+    // Writes from other SMs and the host only flag the cache, the owning SM drops its entries when it syncs.
+    DecodeCache.NotifyWrite(0x9000 >> 2);
+
+    const bool visibleBeforeSync = DecodeCache.Lookup(0x4000) != nullptr;
+
+    DecodeCache.SyncPendingInvalidate();
+
+    const bool visibleAfterSync = DecodeCache.Lookup(0x4000) != nullptr;
+
+    DecodeAt(0x4000, 0x9000 >> 2);
+    DecodeCache.SyncPendingInvalidate();
+
+    const bool visibleAfterRedecode = DecodeCache.Lookup(0x4000) != nullptr;
+
+    if(!visibleBeforeSync || visibleAfterSync || !visibleAfterRedecode)
+    {
+        ConPrinter::PrintLn("A pending invalidation was applied wrong: before sync {}, after sync {}, after redecode {}.", visibleBeforeSync, visibleAfterSync, visibleAfterRedecode);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully applied a pending invalidation on sync.");
+    }
+}
+
+static u32 WriteLoadImmediate(u8* const program, const u32 offset, const u8 registerIndex, const u32 value) noexcept
+{
+    program[offset] = static_cast<u8>(EInstruction::LoadImmediate);
+    program[offset + 1] = registerIndex;
+    (void) ::std::memcpy(&program[offset + 2], &value, sizeof(value));
+    return offset + 6;
+}
+
+static void RunPrograms() noexcept
+{
+    for(u32 i = 0; i < PROGRAM_CYCLE_COUNT; ++i)
+    {
+        DecodeProcessor.Clock();
+    }
+}
+
+static void TestWriteFromOtherSM() noexcept
+{
+    PatchedProgram[0] = static_cast<u8>(EInstruction::Nop);
+    PatchedProgram[1] = static_cast<u8>(EInstruction::Nop);
+    (void) WriteLoadImmediate(PatchedProgram, 2, 0, ORIGINAL_IMMEDIATE);
+    PatchedProgram[8] = static_cast<u8>(EInstruction::Hlt);
+
+    // Stores r2 over the immediate of the patched program.
+    const u64 immediateAddress = (reinterpret_cast<uintptr_t>(PatchedProgram) >> 2) + 1;
+    u32 offset = 0;
+    offset = WriteLoadImmediate(PatchingProgram, offset, 0, static_cast<u32>(immediateAddress));
+    offset = WriteLoadImmediate(PatchingProgram, offset, 1, static_cast<u32>(immediateAddress >> 32));
+    offset = WriteLoadImmediate(PatchingProgram, offset, 2, PATCHED_IMMEDIATE);
+    PatchingProgram[offset++] = static_cast<u8>(EInstruction::LoadStore);
+    PatchingProgram[offset++] = 0x40 | (7 << 3);
+    PatchingProgram[offset++] = 0;
+    PatchingProgram[offset++] = 2;
+    PatchingProgram[offset++] = 0;
+    PatchingProgram[offset++] = 0;
+    PatchingProgram[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    DecodeProcessor.Reset();
+
+    // Both SMs decode the program, then SM 0 patches it.
+    DecodeProcessor.TestLoadProgram(0, 0, 0x1, PatchedProgram);
+    DecodeProcessor.TestLoadProgram(1, 0, 0x1, PatchedProgram);
+    RunPrograms();
+
+    const u32 epochBeforeWrite = DecodeProcessor.TestDecodeEpoch(1);
+
+    DecodeProcessor.TestLoadProgram(0, 0, 0x1, PatchingProgram);
+    RunPrograms();
+
+    // SM 0 invalidates its own cache on the store, SM 1 from the cycle after it.
+    DecodeProcessor.TestLoadProgram(0, 0, 0x1, PatchedProgram);
+    DecodeProcessor.TestLoadProgram(1, 0, 0x1, PatchedProgram);
+    RunPrograms();
+
+    const u32 writerRegister = DecodeProcessor.TestReadRegister(0, 0);
+    const u32 readerRegister = DecodeProcessor.TestReadRegister(1, 0);
+
+    if(DecodeProcessor.TestDecodeEpoch(1) == epochBeforeWrite)
+    {
+        ConPrinter::PrintLn("A store from SM 0 over code decoded by SM 1 did not invalidate the decode cache of SM 1.");
+    }
+    else if(writerRegister != PATCHED_IMMEDIATE || readerRegister != PATCHED_IMMEDIATE)
+    {
+        ConPrinter::PrintLn("The patched code loaded 0x{X} on SM 0 and 0x{X} on SM 1, expected 0x{X}.", writerRegister, readerRegister, PATCHED_IMMEDIATE);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully invalidated the decoded instructions of another SM on a store.");
+    }
+
+    DecodeProcessor.FlushCache(0);
+}
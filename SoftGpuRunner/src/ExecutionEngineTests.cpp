@@ -0,0 +1,166 @@
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+
+static void TestLoadStoreProgram() noexcept;
+
+static inline constexpr u32 DATA_WORD_COUNT = 64;
+static inline constexpr u32 COMPARED_REGISTER_COUNT = 32;
+// Plenty for the program to halt and every unit to drain on either engine.
+static inline constexpr u32 PROGRAM_CYCLE_COUNT = 256;
+
+static Processor EngineProcessor;
+alignas(64) static u32 Data[DATA_WORD_COUNT];
+alignas(4) static u8 Program[128];
+
+namespace tau::test::execution_engine {
+
+void RunTests() noexcept
+{
+    TestLoadStoreProgram();
+}
+
+}
+
+[[nodiscard]] static u32 FloatBits(const f32 value) noexcept
+{
+    u32 bits;
+    (void) ::std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static u32 WriteLoadImmediate(const u32 offset, const u8 registerIndex, const u32 value) noexcept
+{
+    Program[offset] = static_cast<u8>(EInstruction::LoadImmediate);
+    Program[offset + 1] = registerIndex;
+    (void) ::std::memcpy(&Program[offset + 2], &value, sizeof(value));
+    return offset + 6;
+}
+
+// Addresses are in words, the low and high halves go in consecutive registers.
+static u32 WriteLoadAddress(const u32 offset, const u8 registerIndex, const u64 address) noexcept
+{
+    const u32 next = WriteLoadImmediate(offset, registerIndex, static_cast<u32>(address));
+    return WriteLoadImmediate(next, registerIndex + 1, static_cast<u32>(address >> 32));
+}
+
+static u32 WriteLoadStore(const u32 offset, const bool store, const u32 indexExponent, const u32 registerCount, const u8 baseRegister, const u8 indexRegister, const u8 targetRegister, const i16 addressOffset) noexcept
+{
+    u32 next = offset;
+    Program[next++] = static_cast<u8>(EInstruction::LoadStore);
+    Program[next++] = static_cast<u8>((store ? 0x40 : 0x00) | (indexExponent << 3) | (registerCount - 1));
+    Program[next++] = baseRegister;
+
+    if(indexExponent != 7)
+    {
+        Program[next++] = indexRegister;
+    }
+
+    Program[next++] = targetRegister;
+    (void) ::std::memcpy(&Program[next], &addressOffset, sizeof(addressOffset));
+    return next + 2;
+}
+
+static u32 WriteBinOp(const u32 offset, const EInstruction instruction, const u8 registerA, const u8 registerB, const u8 storageRegister) noexcept
+{
+    Program[offset] = static_cast<u8>(instruction);
+    Program[offset + 1] = registerA;
+    Program[offset + 2] = registerB;
+    Program[offset + 3] = storageRegister;
+    return offset + 4;
+}
+
+static void BuildProgram() noexcept
+{
+    const u64 dataAddress = reinterpret_cast<uintptr_t>(Data) >> 2;
+
+    u32 offset = 0;
+    offset = WriteLoadAddress(offset, 0, dataAddress);
+    // An odd base register pair, pointing past the middle of the data.
+    offset = WriteLoadAddress(offset, 15, dataAddress + 40);
+    offset = WriteLoadImmediate(offset, 2, 3);
+    offset = WriteLoadImmediate(offset, 3, FloatBits(1.5f));
+    // r4..r5 = Data[3 * 2 + 2]
+    offset = WriteLoadStore(offset, false, 1, 2, 0, 2, 4, 2);
+    // r7..r9 = Data[12]
+    offset = WriteLoadStore(offset, false, 7, 3, 0, 0, 7, 12);
+    offset = WriteBinOp(offset, EInstruction::AddF, 4, 3, 10);
+    offset = WriteBinOp(offset, EInstruction::MulF, 7, 3, 11);
+    // Data[20] = r10..r11
+    offset = WriteLoadStore(offset, true, 7, 2, 0, 0, 10, 20);
+    // Data[40 - 8] = r7..r9
+    offset = WriteLoadStore(offset, true, 7, 3, 15, 0, 7, -8);
+    // Data[40 + 3 * 2 + 1] = r5
+    offset = WriteLoadStore(offset, true, 1, 1, 15, 2, 5, 1);
+    Program[offset++] = static_cast<u8>(EInstruction::FlushCache);
+    Program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+// Runs the program on SM 0 and returns its registers, the data is left in memory.
+static void RunProgram(const EExecutionMode executionMode, u32 registers[COMPARED_REGISTER_COUNT]) noexcept
+{
+    for(u32 i = 0; i < DATA_WORD_COUNT; ++i)
+    {
+        Data[i] = FloatBits(static_cast<f32>(i));
+    }
+
+    EngineProcessor.Reset();
+    EngineProcessor.SetExecutionMode(executionMode);
+    EngineProcessor.TestLoadProgram(0, 0, 0x1, Program);
+
+    for(u32 i = 0; i < PROGRAM_CYCLE_COUNT; ++i)
+    {
+        EngineProcessor.Clock();
+    }
+
+    // FlushCache doesn't wait for the stores still in the Ld/St units, flush again once they're done.
+    EngineProcessor.FlushCache(0);
+
+    for(u32 i = 0; i < COMPARED_REGISTER_COUNT; ++i)
+    {
+        registers[i] = EngineProcessor.TestReadRegister(0, i);
+    }
+}
+
+static void TestLoadStoreProgram() noexcept
+{
+    BuildProgram();
+
+    u32 cycleRegisters[COMPARED_REGISTER_COUNT];
+    u32 cycleData[DATA_WORD_COUNT];
+    RunProgram(EExecutionMode::Cycle, cycleRegisters);
+    (void) ::std::memcpy(cycleData, Data, sizeof(Data));
+
+    u32 functionalRegisters[COMPARED_REGISTER_COUNT];
+    RunProgram(EExecutionMode::Functional, functionalRegisters);
+
+    EngineProcessor.SetExecutionMode(EExecutionMode::Cycle);
+
+    for(u32 i = 0; i < COMPARED_REGISTER_COUNT; ++i)
+    {
+        if(cycleRegisters[i] != functionalRegisters[i])
+        {
+            ConPrinter::PrintLn("Register {} was 0x{X} on the cycle model and 0x{X} on the functional engine.", i, cycleRegisters[i], functionalRegisters[i]);
+            return;
+        }
+    }
+
+    for(u32 i = 0; i < DATA_WORD_COUNT; ++i)
+    {
+        if(cycleData[i] != Data[i])
+        {
+            ConPrinter::PrintLn("Data word {} was 0x{X} on the cycle model and 0x{X} on the functional engine.", i, cycleData[i], Data[i]);
+            return;
+        }
+    }
+
+    // Both engines agreeing on the wrong result doesn't count.
+    if(Data[20] != FloatBits(8.0f + 1.5f) || Data[21] != FloatBits(12.0f * 1.5f) || Data[32] != FloatBits(12.0f) || Data[34] != FloatBits(14.0f) || Data[47] != FloatBits(9.0f))
+    {
+        ConPrinter::PrintLn("The program stored 0x{X} 0x{X} 0x{X} 0x{X} 0x{X} on both engines.", Data[20], Data[21], Data[32], Data[34], Data[47]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully ran a Ld/St and FPU program to the same state on both engines.");
+    }
+}
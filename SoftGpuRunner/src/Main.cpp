@@ -4,6 +4,7 @@
 #include "InputAssembler.hpp"
 #include "PCIControlRegisters.hpp"
 #include "MMU.hpp"
+#include "PageTableBuilder.hpp"
 #include <allocator/PageAllocator.hpp>
 #include <vd/Window.hpp>
 #include <vd/VulkanManager.hpp>
@@ -36,6 +37,42 @@ namespace tau::test::register_allocator {
 extern void RunTests() noexcept;
 }
 
+namespace tau::test::processor_idle {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::processor_clock {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::page_table_builder {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::replacement_policy {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::cache {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::mshr {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::decoded_instruction_cache {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::execution_engine {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::mmu {
+extern void RunTests() noexcept;
+}
+
 static void FillFramebufferBlackMagenta(const Ref<::tau::vd::Window>& window, u8* const framebuffer) noexcept
 {
     for(uSys y = 0; y < window->FramebufferHeight(); ++y)
@@ -113,6 +150,15 @@ int main(int argCount, char* args[])
 
 #if 0
     ::tau::test::register_allocator::RunTests();
+    ::tau::test::processor_idle::RunTests();
+    ::tau::test::processor_clock::RunTests();
+    ::tau::test::page_table_builder::RunTests();
+    ::tau::test::decoded_instruction_cache::RunTests();
+    ::tau::test::mshr::RunTests();
+    ::tau::test::cache::RunTests();
+    ::tau::test::execution_engine::RunTests();
+    ::tau::test::mmu::RunTests();
+    ::tau::test::replacement_policy::RunTests();
 #endif
 
     Ref<tau::vd::Window> window = tau::vd::Window::CreateWindow();
@@ -579,6 +625,13 @@ static void TestMul2FReplicated() noexcept
 
 static void TestMul2FReplicatedDualDispatch() noexcept
 {
+    // This loads a program on both dispatch ports, which the smaller topologies don't have.
+    if constexpr(Topology.DispatchUnitCount < 2)
+    {
+        ConPrinter::PrintLn("Skipping TestMul2FReplicatedDualDispatch, the topology has only {} dispatch unit.", Topology.DispatchUnitCount);
+        return;
+    }
+
     processor.LoadPageDirectoryPointer(0, PageDirectory);
 
     struct InputData
@@ -843,38 +896,22 @@ static int InitMmu() noexcept
 
     (void) ::std::memset(GpuMemory, 0, sizeof(GpuPageSize) * 4);
 
-    PageTable0[0].Present = true;
-    PageTable0[0].ReadWrite = true;
-    PageTable0[0].Execute = false;
-    PageTable0[0].WriteThrough = false;
-    PageTable0[0].CacheDisable = false;
-    PageTable0[0].Accessed = false;
-    PageTable0[0].Dirty = false;
-    PageTable0[0].External = false;
-    PageTable0[0].PhysicalAddress = (gpuMemoryAddress >> 16) + 2;
-    PageTable0[0].Reserved1 = 0;
-
-    PageTable0[1].Present = true;
-    PageTable0[1].ReadWrite = false;
-    PageTable0[1].Execute = true;
-    PageTable0[1].WriteThrough = false;
-    PageTable0[1].CacheDisable = false;
-    PageTable0[1].Accessed = false;
-    PageTable0[1].Dirty = false;
-    PageTable0[1].External = false;
-    PageTable0[1].PhysicalAddress = (gpuMemoryAddress >> 16) + 3;
-    PageTable0[1].Reserved1 = 0;
-
-    PageDirectory[0].Present = true;
-    PageDirectory[0].ReadWrite = true;
-    PageDirectory[0].Execute = false;
-    PageDirectory[0].WriteThrough = false;
-    PageDirectory[0].CacheDisable = false;
-    PageDirectory[0].Accessed = false;
-    PageDirectory[0].Dirty = false;
-    PageDirectory[0].External = false;
-    PageDirectory[0].PhysicalAddress = (gpuMemoryAddress >> 16) + 1;
-    PageDirectory[0].Reserved1 = 0;
+    // There is only the one page table, which was committed along with everything else.
+    PageTableBuilder pageTableBuilder(PageDirectory, [](void* const userData) noexcept { return static_cast<PageEntry*>(userData); }, PageTable0);
+
+    PageEntry dataFlags;
+    dataFlags.Value = 0;
+    dataFlags.ReadWrite = true;
+
+    PageEntry executableFlags;
+    executableFlags.Value = 0;
+    executableFlags.Execute = true;
+
+    if(!pageTableBuilder.Map(0, (gpuMemoryAddress >> 16) + 2, 1, dataFlags) || !pageTableBuilder.Map(1, (gpuMemoryAddress >> 16) + 3, 1, executableFlags))
+    {
+        ConPrinter::PrintLn("Failed to build the page tables.");
+        return -203;
+    }
 
     return 0;
 }
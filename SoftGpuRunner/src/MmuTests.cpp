@@ -0,0 +1,687 @@
+#include <ConPrinter.hpp>
+
+#include <MMU.hpp>
+#include <PageTableBuilder.hpp>
+#include <Processor.hpp>
+
+#include <new>
+
+static void TestL1Hit() noexcept;
+static void TestL2Hit() noexcept;
+static void TestL2Miss() noexcept;
+static void TestMediumPageHit() noexcept;
+static void TestLargePageHit() noexcept;
+static void TestEvictedWriteback() noexcept;
+static void TestMergedWriteback() noexcept;
+static void TestHaltWriteback() noexcept;
+static void TestAsidSwitch() noexcept;
+static void TestInvalidateAsidRegister() noexcept;
+static void TestInvalidatePageRegister() noexcept;
+
+[[nodiscard]] static PageEntry* AllocatePageTable(void* userData) noexcept;
+static void FreePageTables() noexcept;
+[[nodiscard]] static PageEntry MakeFlags(bool readWrite) noexcept;
+[[nodiscard]] static PageEntry* MapPages(u64 virtualPage, u64 physicalPage, u64 pageCount, u64 pageStride) noexcept;
+[[nodiscard]] static PageEntry* BuildPageTables(u64 virtualPage, u64 physicalPage, u64 pageCount, u64 pageStride = 0) noexcept;
+[[nodiscard]] static PageEntry* PageTable(u64 virtualPage, const PageEntry* pageDirectory = nullptr) noexcept;
+static void WriteMmuRegister(u32 registerOffset, u32 value) noexcept;
+[[nodiscard]] static u32 ReadMmuRegister(u32 registerOffset) noexcept;
+static void LoadPageDirectoryRegisters(const PageEntry* pageDirectory, u16 asid) noexcept;
+[[nodiscard]] static u64 TranslatePage(u64 virtualPage, bool instruction = false, bool write = false) noexcept;
+[[nodiscard]] static u64 WordPage(const void* hostAddress) noexcept;
+
+// The page walker reads the page tables straight from host memory. A mapping edited behind the MMU's back shows whether a translation came from a TLB or from a walk.
+static Processor MmuProcessor;
+static Mmu& TestMmu = MmuProcessor.TestMmu(0);
+
+static PageEntry* PageTables[16];
+static u32 PageTableCount = 0;
+
+static inline constexpr u64 VIRTUAL_PAGE = (1ull << GpuLargePageShift) + 0x100;
+static inline constexpr u64 PHYSICAL_PAGE = 0x12000;
+// Where an edited mapping points, far from anything the tests map.
+static inline constexpr u64 REMAPPED_PHYSICAL_PAGE = 0x7F000;
+static inline constexpr u64 INVALID_ADDRESS = 0xFFFFFFFFFFFFFFFF;
+static inline constexpr u64 OTHER_PHYSICAL_PAGE = 0x34000;
+// Where BAR0 is placed for the register tests.
+static inline constexpr u32 BAR0_ADDRESS = 0x10000000;
+// A BAR0 access is handed from the PCI controller to the control registers over a bus, which takes a few cycles.
+static inline constexpr u32 PCI_ACCESS_CYCLE_COUNT = 8;
+// Plenty for the halt program to halt.
+static inline constexpr u32 PROGRAM_CYCLE_COUNT = 256;
+
+// The halt program runs with its code and data identity mapped.
+alignas(64) static u32 HaltData[16];
+alignas(4) static u8 HaltProgram[32];
+
+namespace tau::test::mmu {
+
+void RunTests() noexcept
+{
+    TestL1Hit();
+    TestL2Hit();
+    TestL2Miss();
+    TestMediumPageHit();
+    TestLargePageHit();
+    TestEvictedWriteback();
+    TestMergedWriteback();
+    TestHaltWriteback();
+    TestAsidSwitch();
+    TestInvalidateAsidRegister();
+    TestInvalidatePageRegister();
+}
+
+}
+
+static void TestL1Hit() noexcept
+{
+    if(!BuildPageTables(VIRTUAL_PAGE, PHYSICAL_PAGE, 2, 1))
+    {
+        return;
+    }
+
+    // The first translation walks, the second hits in the data L1 TLB.
+    const u64 walked = TranslatePage(VIRTUAL_PAGE);
+    PageTable(VIRTUAL_PAGE)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    const u64 hit = TranslatePage(VIRTUAL_PAGE);
+
+    // An untouched page still misses and walks.
+    PageTable(VIRTUAL_PAGE + 1)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    const u64 missed = TranslatePage(VIRTUAL_PAGE + 1);
+
+    if(walked != PHYSICAL_PAGE || hit != PHYSICAL_PAGE || missed != REMAPPED_PHYSICAL_PAGE)
+    {
+        ConPrinter::PrintLn("The L1 TLB walked to page 0x{X}, hit page 0x{X} and missed to page 0x{X}.", walked, hit, missed);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully missed, walked and hit in the L1 TLB.");
+    }
+
+    FreePageTables();
+}
+
+static void TestL2Hit() noexcept
+{
+    // The data L1 set of VIRTUAL_PAGE, and 8 more pages that share it.
+    constexpr u64 l1SetStride = 8;
+
+    if(!BuildPageTables(VIRTUAL_PAGE, PHYSICAL_PAGE, 9, l1SetStride))
+    {
+        return;
+    }
+
+    (void) TranslatePage(VIRTUAL_PAGE);
+    PageTable(VIRTUAL_PAGE)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+
+    // The instruction L1 TLB has never seen the page, it has to come from the L2 TLB the data side filled.
+    const u64 instructionHit = TranslatePage(VIRTUAL_PAGE, true);
+
+    // Push the page out of its 4 way data L1 set, the 8 pages are spread over the L2 sets.
+    for(u64 i = 1; i <= 8; ++i)
+    {
+        (void) TranslatePage(VIRTUAL_PAGE + i * l1SetStride);
+    }
+
+    const u64 dataHit = TranslatePage(VIRTUAL_PAGE);
+
+    if(instructionHit != PHYSICAL_PAGE || dataHit != PHYSICAL_PAGE)
+    {
+        ConPrinter::PrintLn("An L1 miss translated to page 0x{X} on the instruction side and 0x{X} on the data side, expected the L2 TLB's page 0x{X}.", instructionHit, dataHit, PHYSICAL_PAGE);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully filled both L1 TLBs from the L2 TLB.");
+    }
+
+    FreePageTables();
+}
+
+static void TestL2Miss() noexcept
+{
+    // The L2 set of VIRTUAL_PAGE, the pages also share its data L1 set.
+    constexpr u64 l2SetStride = 64;
+    constexpr u64 evictingPageCount = 16;
+
+    if(!BuildPageTables(VIRTUAL_PAGE, PHYSICAL_PAGE, evictingPageCount + 1, l2SetStride))
+    {
+        return;
+    }
+
+    (void) TranslatePage(VIRTUAL_PAGE);
+    PageTable(VIRTUAL_PAGE)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+
+    // Enough to cycle the rolling selector over all 8 ways of the L2 set.
+    for(u64 i = 1; i <= evictingPageCount; ++i)
+    {
+        (void) TranslatePage(VIRTUAL_PAGE + i * l2SetStride);
+    }
+
+    const u64 walked = TranslatePage(VIRTUAL_PAGE);
+    const u64 hit = TranslatePage(VIRTUAL_PAGE + evictingPageCount * l2SetStride);
+
+    if(walked != REMAPPED_PHYSICAL_PAGE || hit != PHYSICAL_PAGE + evictingPageCount * l2SetStride)
+    {
+        ConPrinter::PrintLn("A page evicted from the L2 TLB translated to page 0x{X}, expected a walk to page 0x{X}.", walked, REMAPPED_PHYSICAL_PAGE);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully walked a page evicted from the L2 TLB.");
+    }
+
+    FreePageTables();
+}
+
+static void TestMediumPageHit() noexcept
+{
+    constexpr u64 virtualPage = 1ull << GpuLargePageShift;
+    constexpr u64 mediumPagePageCount = 1ull << GpuMediumPageShift;
+
+    if(!BuildPageTables(virtualPage, PHYSICAL_PAGE, mediumPagePageCount))
+    {
+        return;
+    }
+
+    if(!PageTable(virtualPage)->LargePage)
+    {
+        ConPrinter::PrintLn("A medium page was not mapped as one.");
+        FreePageTables();
+        return;
+    }
+
+    // Walking one page of the run fills the medium page TLB, the rest of the run never walks again.
+    const u64 walked = TranslatePage(virtualPage + 3);
+    PageTable(virtualPage + 200)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    const u64 dataHit = TranslatePage(virtualPage + 200);
+    const u64 instructionHit = TranslatePage(virtualPage + 17, true);
+
+    if(walked != PHYSICAL_PAGE + 3 || dataHit != PHYSICAL_PAGE + 200 || instructionHit != PHYSICAL_PAGE + 17)
+    {
+        ConPrinter::PrintLn("A medium page walked to page 0x{X}, then hit pages 0x{X} and 0x{X}.", walked, dataHit, instructionHit);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully missed, walked and hit in the medium page TLB.");
+    }
+
+    FreePageTables();
+}
+
+static void TestLargePageHit() noexcept
+{
+    constexpr u64 virtualPage = 2ull << GpuLargePageShift;
+
+    PageEntry* const pageDirectory = BuildPageTables(virtualPage, PHYSICAL_PAGE, 1ull << GpuLargePageShift);
+
+    if(!pageDirectory)
+    {
+        return;
+    }
+
+    const u64 walked = TranslatePage(virtualPage + 0x10);
+    pageDirectory[2].PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    const u64 hit = TranslatePage(virtualPage + 0xFFF0);
+
+    // Another directory entry was never walked.
+    const u64 missed = TranslatePage(3ull << GpuLargePageShift);
+
+    if(walked != PHYSICAL_PAGE + 0x10 || hit != PHYSICAL_PAGE + 0xFFF0 || missed != INVALID_ADDRESS)
+    {
+        ConPrinter::PrintLn("A large page walked to page 0x{X} and hit page 0x{X}, an unmapped page translated to 0x{X}.", walked, hit, missed);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully missed, walked and hit in the large page TLB.");
+    }
+
+    FreePageTables();
+}
+
+static void TestEvictedWriteback() noexcept
+{
+    constexpr u64 l2SetStride = 64;
+    constexpr u64 evictingPageCount = 16;
+
+    if(!BuildPageTables(VIRTUAL_PAGE, PHYSICAL_PAGE, evictingPageCount + 1, l2SetStride))
+    {
+        return;
+    }
+
+    // The store dirties the page, the bits wait in the L2 TLB.
+    (void) TranslatePage(VIRTUAL_PAGE, false, true);
+
+    const bool pendingAfterStore = TestMmu.HasPendingWriteback();
+    const bool writtenBeforeEviction = PageTable(VIRTUAL_PAGE)->Accessed;
+
+    // Loads only, so nothing else becomes Dirty.
+    for(u64 i = 1; i <= evictingPageCount; ++i)
+    {
+        (void) TranslatePage(VIRTUAL_PAGE + i * l2SetStride);
+    }
+
+    const PageEntry& pageEntry = *PageTable(VIRTUAL_PAGE);
+
+    if(!pendingAfterStore || writtenBeforeEviction)
+    {
+        ConPrinter::PrintLn("A store was written back right away rather than marked pending.");
+    }
+    else if(!pageEntry.Accessed || !pageEntry.Dirty)
+    {
+        ConPrinter::PrintLn("An evicted L2 TLB entry was written back as Accessed {} Dirty {}.", pageEntry.Accessed, pageEntry.Dirty);
+    }
+    else if(PageTable(VIRTUAL_PAGE + l2SetStride)->Dirty)
+    {
+        ConPrinter::PrintLn("A load dirtied its page when it evicted a pending entry.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully wrote back the pending bits of an evicted L2 TLB entry.");
+    }
+
+    FreePageTables();
+}
+
+static void TestMergedWriteback() noexcept
+{
+    // Reaches into the high word of the entry, which the writeback never touches.
+    constexpr u64 editedPhysicalPage = 0x123457F000;
+
+    if(!BuildPageTables(VIRTUAL_PAGE, PHYSICAL_PAGE, 1, 1))
+    {
+        return;
+    }
+
+    (void) TranslatePage(VIRTUAL_PAGE, false, true);
+
+    // The host remaps the page and disables caching while the bits are still pending.
+    PageEntry& pageEntry = *PageTable(VIRTUAL_PAGE);
+    pageEntry.PhysicalAddress = editedPhysicalPage;
+    pageEntry.CacheDisable = true;
+
+    TestMmu.WriteBackPageEntries();
+
+    if(!pageEntry.Accessed || !pageEntry.Dirty)
+    {
+        ConPrinter::PrintLn("A pending entry was written back as Accessed {} Dirty {}.", pageEntry.Accessed, pageEntry.Dirty);
+    }
+    else if(pageEntry.PhysicalAddress != editedPhysicalPage || !pageEntry.CacheDisable || !pageEntry.Present || !pageEntry.ReadWrite)
+    {
+        ConPrinter::PrintLn("Writing back the flags lost the host's edit, the entry is 0x{X}.", pageEntry.Value);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully merged the pending flags into an entry the host edited.");
+    }
+
+    FreePageTables();
+}
+
+static void TestHaltWriteback() noexcept
+{
+    const u64 programPage = WordPage(HaltProgram);
+    const u64 dataPage = WordPage(HaltData);
+    const u64 dataAddress = reinterpret_cast<uintptr_t>(HaltData) >> 2;
+
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    if(!pageDirectory || !builder.Map(programPage, programPage, 1, MakeFlags(true)) || (dataPage != programPage && !builder.Map(dataPage, dataPage, 1, MakeFlags(true))))
+    {
+        ConPrinter::PrintLn("Failed to identity map the halt program.");
+        FreePageTables();
+        return;
+    }
+
+    // HaltData[0] = r2, then halt without a flush.
+    u32 offset = 0;
+    const auto writeLoadImmediate = [&offset](const u8 registerIndex, const u32 value)
+    {
+        HaltProgram[offset++] = static_cast<u8>(EInstruction::LoadImmediate);
+        HaltProgram[offset++] = registerIndex;
+        (void) ::std::memcpy(&HaltProgram[offset], &value, sizeof(value));
+        offset += sizeof(value);
+    };
+
+    writeLoadImmediate(0, static_cast<u32>(dataAddress));
+    writeLoadImmediate(1, static_cast<u32>(dataAddress >> 32));
+    writeLoadImmediate(2, 0x5A5A5A5A);
+    HaltProgram[offset++] = static_cast<u8>(EInstruction::LoadStore);
+    // A store of 1 register with no index register.
+    HaltProgram[offset++] = static_cast<u8>(0x40 | (7 << 3));
+    HaltProgram[offset++] = 0;
+    HaltProgram[offset++] = 2;
+    HaltProgram[offset++] = 0;
+    HaltProgram[offset++] = 0;
+    HaltProgram[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    MmuProcessor.Reset();
+    TestMmu.LoadPageDirectoryPointer(reinterpret_cast<u64>(pageDirectory) / GpuPageSize, 0);
+    MmuProcessor.TestLoadProgram(0, 0, 0x1, HaltProgram);
+
+    // The first fetch leaves the code page's Accessed bit pending, the host edits the entry meanwhile.
+    for(u32 i = 0; i < PROGRAM_CYCLE_COUNT && !TestMmu.HasPendingWriteback(); ++i)
+    {
+        MmuProcessor.Clock();
+    }
+
+    PageEntry& programEntry = *PageTable(programPage);
+    programEntry.CacheDisable = true;
+    const bool writtenBeforeHalt = programEntry.Accessed;
+
+    for(u32 i = 0; i < PROGRAM_CYCLE_COUNT; ++i)
+    {
+        MmuProcessor.Clock();
+    }
+
+    const PageEntry& dataEntry = *PageTable(dataPage);
+
+    if(writtenBeforeHalt)
+    {
+        ConPrinter::PrintLn("An instruction fetch was written back right away rather than marked pending.");
+    }
+    else if(TestMmu.HasPendingWriteback() || !programEntry.Accessed || !dataEntry.Accessed || !dataEntry.Dirty)
+    {
+        ConPrinter::PrintLn("After Hlt the code page was written back as Accessed {} and the data page as Accessed {} Dirty {}.", programEntry.Accessed, dataEntry.Accessed, dataEntry.Dirty);
+    }
+    else if(!programEntry.CacheDisable)
+    {
+        ConPrinter::PrintLn("Writing back the flags at Hlt lost the host's edit of the code page entry.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully wrote back the pending flags at Hlt.");
+    }
+
+    MmuProcessor.Reset();
+    FreePageTables();
+}
+
+static void TestAsidSwitch() noexcept
+{
+    // The same virtual page in 2 address spaces.
+    PageEntry* const firstDirectory = MapPages(VIRTUAL_PAGE, PHYSICAL_PAGE, 1, 1);
+    PageEntry* const secondDirectory = firstDirectory ? MapPages(VIRTUAL_PAGE, OTHER_PHYSICAL_PAGE, 1, 1) : nullptr;
+
+    if(!secondDirectory)
+    {
+        FreePageTables();
+        return;
+    }
+
+    TestMmu.Reset();
+
+    LoadPageDirectoryRegisters(firstDirectory, 1);
+    const u64 firstPage = TranslatePage(VIRTUAL_PAGE);
+
+    LoadPageDirectoryRegisters(secondDirectory, 2);
+    const u64 secondPage = TranslatePage(VIRTUAL_PAGE);
+    const u32 activeAsid = ReadMmuRegister(PciControlRegisters::OFFSET_REGISTER_MMU_ACTIVE_ASID);
+
+    // Switching back keeps the ASID 1 translation warm, the edit is only seen by a walk.
+    PageTable(VIRTUAL_PAGE, firstDirectory)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    LoadPageDirectoryRegisters(firstDirectory, 1);
+    const u64 firstPageAgain = TranslatePage(VIRTUAL_PAGE);
+
+    if(firstPage != PHYSICAL_PAGE || secondPage != OTHER_PHYSICAL_PAGE || activeAsid != 2)
+    {
+        ConPrinter::PrintLn("ASID 1 translated to page 0x{X} and ASID 2 to page 0x{X} with active ASID {}, expected 0x{X} and 0x{X}.", firstPage, secondPage, activeAsid, PHYSICAL_PAGE, OTHER_PHYSICAL_PAGE);
+    }
+    else if(firstPageAgain != PHYSICAL_PAGE)
+    {
+        ConPrinter::PrintLn("Switching back to ASID 1 translated to page 0x{X}, its translation was not kept.", firstPageAgain);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully isolated and kept the translations of 2 ASIDs through the MMU registers.");
+    }
+
+    FreePageTables();
+}
+
+static void TestInvalidateAsidRegister() noexcept
+{
+    PageEntry* const firstDirectory = MapPages(VIRTUAL_PAGE, PHYSICAL_PAGE, 1, 1);
+    PageEntry* const secondDirectory = firstDirectory ? MapPages(VIRTUAL_PAGE, OTHER_PHYSICAL_PAGE, 1, 1) : nullptr;
+
+    if(!secondDirectory)
+    {
+        FreePageTables();
+        return;
+    }
+
+    TestMmu.Reset();
+
+    LoadPageDirectoryRegisters(firstDirectory, 1);
+    (void) TranslatePage(VIRTUAL_PAGE);
+    LoadPageDirectoryRegisters(secondDirectory, 2);
+    (void) TranslatePage(VIRTUAL_PAGE);
+
+    PageTable(VIRTUAL_PAGE, firstDirectory)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    PageTable(VIRTUAL_PAGE, secondDirectory)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+
+    // Drop ASID 1 while ASID 2 is the active one.
+    WriteMmuRegister(PciControlRegisters::OFFSET_REGISTER_MMU_INVALIDATE_ASID, 1);
+
+    const u64 secondPage = TranslatePage(VIRTUAL_PAGE);
+    LoadPageDirectoryRegisters(firstDirectory, 1);
+    const u64 firstPage = TranslatePage(VIRTUAL_PAGE);
+
+    if(firstPage != REMAPPED_PHYSICAL_PAGE || secondPage != OTHER_PHYSICAL_PAGE)
+    {
+        ConPrinter::PrintLn("After invalidating ASID 1 it translated to page 0x{X} and ASID 2 to page 0x{X}, expected 0x{X} and 0x{X}.", firstPage, secondPage, REMAPPED_PHYSICAL_PAGE, OTHER_PHYSICAL_PAGE);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully invalidated a single ASID through the MMU registers.");
+    }
+
+    FreePageTables();
+}
+
+static void TestInvalidatePageRegister() noexcept
+{
+    PageEntry* const firstDirectory = MapPages(VIRTUAL_PAGE, PHYSICAL_PAGE, 2, 1);
+    PageEntry* const secondDirectory = firstDirectory ? MapPages(VIRTUAL_PAGE, OTHER_PHYSICAL_PAGE, 1, 1) : nullptr;
+
+    if(!secondDirectory)
+    {
+        FreePageTables();
+        return;
+    }
+
+    TestMmu.Reset();
+
+    LoadPageDirectoryRegisters(secondDirectory, 2);
+    (void) TranslatePage(VIRTUAL_PAGE);
+    LoadPageDirectoryRegisters(firstDirectory, 1);
+    (void) TranslatePage(VIRTUAL_PAGE);
+    (void) TranslatePage(VIRTUAL_PAGE + 1);
+
+    PageTable(VIRTUAL_PAGE, firstDirectory)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    PageTable(VIRTUAL_PAGE + 1, firstDirectory)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+    PageTable(VIRTUAL_PAGE, secondDirectory)->PhysicalAddress = REMAPPED_PHYSICAL_PAGE;
+
+    // The page is invalidated in the address space of the ASID register, the address is in words.
+    const u64 virtualAddress = VIRTUAL_PAGE << Mmu::PAGE_OFFSET_BITS;
+    WriteMmuRegister(PciControlRegisters::OFFSET_REGISTER_MMU_INVALIDATE_PAGE_LOW, static_cast<u32>(virtualAddress));
+    WriteMmuRegister(PciControlRegisters::OFFSET_REGISTER_MMU_INVALIDATE_PAGE_HIGH, static_cast<u32>(virtualAddress >> 32));
+
+    const u64 invalidatedPage = TranslatePage(VIRTUAL_PAGE);
+    const u64 nextPage = TranslatePage(VIRTUAL_PAGE + 1);
+    LoadPageDirectoryRegisters(secondDirectory, 2);
+    const u64 otherAsidPage = TranslatePage(VIRTUAL_PAGE);
+
+    if(invalidatedPage != REMAPPED_PHYSICAL_PAGE)
+    {
+        ConPrinter::PrintLn("An invalidated page translated to page 0x{X}, expected a walk to page 0x{X}.", invalidatedPage, REMAPPED_PHYSICAL_PAGE);
+    }
+    else if(nextPage != PHYSICAL_PAGE + 1 || otherAsidPage != OTHER_PHYSICAL_PAGE)
+    {
+        ConPrinter::PrintLn("Invalidating a page also dropped the next page, 0x{X}, or the page in ASID 2, 0x{X}.", nextPage, otherAsidPage);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully invalidated a single page through the MMU registers.");
+    }
+
+    FreePageTables();
+}
+
+static PageEntry* AllocatePageTable(void*) noexcept
+{
+    if(PageTableCount == sizeof(PageTables) / sizeof(PageTables[0]))
+    {
+        return nullptr;
+    }
+
+    void* const pageTable = ::operator new(GpuPageTableSize, ::std::align_val_t { GpuPageSize }, ::std::nothrow);
+
+    if(!pageTable)
+    {
+        return nullptr;
+    }
+
+    (void) ::std::memset(pageTable, 0, GpuPageTableSize);
+
+    PageTables[PageTableCount++] = static_cast<PageEntry*>(pageTable);
+    return static_cast<PageEntry*>(pageTable);
+}
+
+static void FreePageTables() noexcept
+{
+    for(u32 i = 0; i < PageTableCount; ++i)
+    {
+        ::operator delete(PageTables[i], ::std::align_val_t { GpuPageSize });
+    }
+
+    PageTableCount = 0;
+}
+
+static PageEntry MakeFlags(const bool readWrite) noexcept
+{
+    PageEntry flags;
+    flags.Value = 0;
+    flags.ReadWrite = readWrite;
+    return flags;
+}
+
+/**
+ * \brief Maps the pages into a new page directory.
+ *
+ *   With a page stride of 0 the pages are mapped as a single range, so
+ * the builder is free to use medium and large pages. Otherwise each of
+ * the pages is mapped on its own, pageStride pages apart.
+ *
+ * \return The page directory, or nullptr on failure.
+ */
+static PageEntry* MapPages(const u64 virtualPage, const u64 physicalPage, const u64 pageCount, const u64 pageStride) noexcept
+{
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    bool mapped = true;
+
+    if(pageStride == 0)
+    {
+        mapped = builder.Map(virtualPage, physicalPage, pageCount, MakeFlags(true));
+    }
+    else
+    {
+        for(u64 i = 0; i < pageCount && mapped; ++i)
+        {
+            mapped = builder.Map(virtualPage + i * pageStride, physicalPage + i * pageStride, 1, MakeFlags(true));
+        }
+    }
+
+    if(!mapped)
+    {
+        ConPrinter::PrintLn("Failed to map {} pages at page 0x{X}.", pageCount, virtualPage);
+        return nullptr;
+    }
+
+    return pageDirectory;
+}
+
+// Maps the pages and loads the directory into a cold MMU, returns the page directory or nullptr on failure.
+static PageEntry* BuildPageTables(const u64 virtualPage, const u64 physicalPage, const u64 pageCount, const u64 pageStride) noexcept
+{
+    PageEntry* const pageDirectory = MapPages(virtualPage, physicalPage, pageCount, pageStride);
+
+    if(!pageDirectory)
+    {
+        FreePageTables();
+        return nullptr;
+    }
+
+    TestMmu.Reset();
+    TestMmu.LoadPageDirectoryPointer(reinterpret_cast<u64>(pageDirectory) / GpuPageSize, 0);
+    return pageDirectory;
+}
+
+// The page table entry of a page, without a page directory the first allocation is used.
+static PageEntry* PageTable(const u64 virtualPage, const PageEntry* const pageDirectory) noexcept
+{
+    const PageEntry& pageDirectoryEntry = (pageDirectory ? pageDirectory : PageTables[0])[(virtualPage >> 16) & 0xFFFF];
+    return reinterpret_cast<PageEntry*>(pageDirectoryEntry.PhysicalAddress * GpuPageSize) + (virtualPage & 0xFFFF);
+}
+
+// Returns the physical page, or INVALID_ADDRESS if the translation failed.
+static u64 TranslatePage(const u64 virtualPage, const bool instruction, const bool write) noexcept
+{
+    const u64 virtualAddress = virtualPage << Mmu::PAGE_OFFSET_BITS;
+
+    bool success = false;
+    u64 physicalAddress;
+
+    if(instruction)
+    {
+        physicalAddress = TestMmu.TranslateInstructionAddress(virtualAddress, &success, nullptr, nullptr);
+    }
+    else if(write)
+    {
+        physicalAddress = TestMmu.TranslateWriteAddress(virtualAddress, &success, nullptr, nullptr, nullptr, nullptr, nullptr);
+    }
+    else
+    {
+        physicalAddress = TestMmu.TranslateAddress(virtualAddress, &success, nullptr, nullptr, nullptr, nullptr, nullptr);
+    }
+
+    return success ? physicalAddress >> Mmu::PAGE_OFFSET_BITS : INVALID_ADDRESS;
+}
+
+// The word page of a host address, which the halt program's pages are identity mapped at.
+static u64 WordPage(const void* const hostAddress) noexcept
+{
+    return (reinterpret_cast<uintptr_t>(hostAddress) >> 2) >> Mmu::PAGE_OFFSET_BITS;
+}
+
+// Writes a register of SM 0's MMU block through BAR0.
+static void WriteMmuRegister(const u32 registerOffset, const u32 value) noexcept
+{
+    MmuProcessor.PciConfigWrite(offsetof(PciConfigHeader, BAR0), 4, BAR0_ADDRESS);
+    MmuProcessor.PciConfigWrite(offsetof(PciConfigHeader, Command), 2, PciController::COMMAND_REGISTER_MEMORY_SPACE_BIT);
+
+    MmuProcessor.PciMemWriteSet(BAR0_ADDRESS + PciControlRegisters::BASE_REGISTER_MMU + registerOffset, sizeof(value), &value);
+    (void) MmuProcessor.ClockN(PCI_ACCESS_CYCLE_COUNT);
+}
+
+static u32 ReadMmuRegister(const u32 registerOffset) noexcept
+{
+    u32 value = 0;
+    u16 readCount = 0;
+
+    MmuProcessor.PciMemReadSet(BAR0_ADDRESS + PciControlRegisters::BASE_REGISTER_MMU + registerOffset, sizeof(value), &value, &readCount);
+    (void) MmuProcessor.ClockN(PCI_ACCESS_CYCLE_COUNT);
+
+    return readCount != 0 ? value : 0xFFFFFFFF;
+}
+
+// The directory is loaded when the high half of its address is written, tagged with the ASID register.
+static void LoadPageDirectoryRegisters(const PageEntry* const pageDirectory, const u16 asid) noexcept
+{
+    const u64 pageDirectoryPage = reinterpret_cast<u64>(pageDirectory) / GpuPageSize;
+
+    WriteMmuRegister(PciControlRegisters::OFFSET_REGISTER_MMU_ASID, asid);
+    WriteMmuRegister(PciControlRegisters::OFFSET_REGISTER_MMU_PAGE_DIRECTORY_LOW, static_cast<u32>(pageDirectoryPage));
+    WriteMmuRegister(PciControlRegisters::OFFSET_REGISTER_MMU_PAGE_DIRECTORY_HIGH, static_cast<u32>(pageDirectoryPage >> 32));
+}
@@ -0,0 +1,104 @@
+#include <ConPrinter.hpp>
+
+#include <StreamingMultiprocessor.hpp>
+
+using Mshrs = StreamingMultiprocessor::Mshrs;
+
+static void TestMissLatency() noexcept;
+static void TestMerge() noexcept;
+static void TestFullStall() noexcept;
+
+static Mshrs L0Mshrs;
+
+namespace tau::test::mshr {
+
+void RunTests() noexcept
+{
+    TestMissLatency();
+    TestMerge();
+    TestFullStall();
+}
+
+}
+
+static void TestMissLatency() noexcept
+{
+    if(Mshrs::MissLatency(ECacheLevel::L0) != 0 || Mshrs::MissLatency(ECacheLevel::L2) != Mshrs::L2_LATENCY || Mshrs::MissLatency(ECacheLevel::Memory) != Mshrs::MEMORY_LATENCY)
+    {
+        ConPrinter::PrintLn("MSHR miss latencies were L0 {}, L2 {}, memory {}.", Mshrs::MissLatency(ECacheLevel::L0), Mshrs::MissLatency(ECacheLevel::L2), Mshrs::MissLatency(ECacheLevel::Memory));
+        return;
+    }
+
+    L0Mshrs.Reset();
+
+    // A memory miss at cycle 10 holds its entry until it comes back, then retires on its own.
+    L0Mshrs.Allocate(0x100, false, 10 + Mshrs::MEMORY_LATENCY);
+
+    const u32 outstandingBefore = Topology.L0MshrCount - L0Mshrs.FreeCount(10 + Mshrs::MEMORY_LATENCY - 1);
+    const u32 outstandingAfter = Topology.L0MshrCount - L0Mshrs.FreeCount(10 + Mshrs::MEMORY_LATENCY);
+
+    if(outstandingBefore != 1 || outstandingAfter != 0)
+    {
+        ConPrinter::PrintLn("A memory miss was outstanding {} times the cycle before it came back and {} times the cycle it did.", outstandingBefore, outstandingAfter);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully retired a memory miss after {} cycles.", Mshrs::MEMORY_LATENCY);
+    }
+}
+
+static void TestMerge() noexcept
+{
+    L0Mshrs.Reset();
+
+    const u64 readyCycle = Mshrs::L2_LATENCY;
+    L0Mshrs.Allocate(0x200, false, readyCycle);
+
+    // A second load to the line waits on the same miss instead of taking another entry, an external line with the same address doesn't.
+    const u64 mergedCycle = L0Mshrs.Merge(0x200, false, 5);
+    const u64 externalCycle = L0Mshrs.Merge(0x200, true, 5);
+    const u64 otherLineCycle = L0Mshrs.Merge(0x201, false, 5);
+
+    const MshrStatistics& statistics = L0Mshrs.Statistics();
+
+    if(mergedCycle != readyCycle || externalCycle != 0 || otherLineCycle != 0)
+    {
+        ConPrinter::PrintLn("MSHR merges returned {}, {} for an external line and {} for another line, expected {}, 0 and 0.", mergedCycle, externalCycle, otherLineCycle, readyCycle);
+    }
+    else if(statistics.PrimaryMisses != 1 || statistics.SecondaryMisses != 1 || L0Mshrs.OutstandingCount() != 1)
+    {
+        ConPrinter::PrintLn("MSHR merge counted {} primary and {} secondary misses with {} outstanding.", statistics.PrimaryMisses, statistics.SecondaryMisses, L0Mshrs.OutstandingCount());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully merged a miss into an outstanding line.");
+    }
+}
+
+static void TestFullStall() noexcept
+{
+    L0Mshrs.Reset();
+
+    // Each miss comes back a cycle later than the one before, so the first one frees the first entry.
+    for(u32 i = 0; i < Topology.L0MshrCount; ++i)
+    {
+        L0Mshrs.Allocate(0x300 + i, false, Mshrs::MEMORY_LATENCY + i);
+    }
+
+    const bool fullWhileOutstanding = L0Mshrs.IsFull(1);
+    const u64 earliestReadyCycle = L0Mshrs.EarliestReadyCycle();
+    const bool fullOnceReady = L0Mshrs.IsFull(earliestReadyCycle);
+
+    if(!fullWhileOutstanding || earliestReadyCycle != Mshrs::MEMORY_LATENCY || fullOnceReady)
+    {
+        ConPrinter::PrintLn("Full MSHRs: full {}, earliest ready cycle {}, still full then {}.", fullWhileOutstanding, earliestReadyCycle, fullOnceReady);
+    }
+    else if(L0Mshrs.Statistics().FullStalls != 1)
+    {
+        ConPrinter::PrintLn("Full MSHRs counted {} stalls, expected 1.", L0Mshrs.Statistics().FullStalls);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully stalled {} full MSHRs until the first miss came back.", Topology.L0MshrCount);
+    }
+}
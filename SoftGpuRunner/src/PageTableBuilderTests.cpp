@@ -0,0 +1,309 @@
+#include <ConPrinter.hpp>
+
+#include <MMU.hpp>
+#include <PageTableBuilder.hpp>
+#include <Processor.hpp>
+
+#include <new>
+
+static void TestMediumPages() noexcept;
+static void TestLargePage() noexcept;
+static void TestLargePageOverPageTable() noexcept;
+static void TestPartialMediumPageRemap() noexcept;
+static void TestMediumPageAccessedDirty() noexcept;
+
+[[nodiscard]] static PageEntry* AllocatePageTable(void* userData) noexcept;
+static void FreePageTables() noexcept;
+[[nodiscard]] static PageEntry MakeFlags(bool readWrite) noexcept;
+static void LoadPageDirectory(PageEntry* pageDirectory) noexcept;
+[[nodiscard]] static bool CheckTranslation(u64 virtualPage, u64 expectedPhysicalPage) noexcept;
+
+// The walker reads the page tables straight from host memory, the Accessed and Dirty bits are written back through the SM.
+static Processor MmuProcessor;
+static Mmu& TestMmu = MmuProcessor.TestMmu(0);
+
+static PageEntry* PageTables[16];
+static u32 PageTableCount = 0;
+
+namespace tau::test::page_table_builder {
+
+void RunTests() noexcept
+{
+    TestMediumPages();
+    TestLargePage();
+    TestLargePageOverPageTable();
+    TestPartialMediumPageRemap();
+    TestMediumPageAccessedDirty();
+}
+
+}
+
+static void TestMediumPages() noexcept
+{
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    // 256 MiB and a bit, starting on a medium page boundary of directory entry 1, to a physical page that isn't aligned to anything.
+    constexpr u64 virtualPage = (1ull << GpuLargePageShift) + (1ull << GpuMediumPageShift);
+    constexpr u64 physicalPage = 0x12345;
+    constexpr u64 pageCount = 4096 + 100;
+
+    if(!builder.Map(virtualPage, physicalPage, pageCount, MakeFlags(true)))
+    {
+        ConPrinter::PrintLn("Failed to map 256 MiB with medium pages.");
+        FreePageTables();
+        return;
+    }
+
+    const PageEntry* const pageTable = reinterpret_cast<const PageEntry*>(pageDirectory[1].PhysicalAddress * GpuPageSize);
+
+    if(pageDirectory[1].LargePage || !pageTable[1ull << GpuMediumPageShift].LargePage || pageTable[(1ull << GpuMediumPageShift) + 4096 + 5].LargePage)
+    {
+        ConPrinter::PrintLn("256 MiB was not mapped with medium pages, and a regular page tail.");
+        FreePageTables();
+        return;
+    }
+
+    LoadPageDirectory(pageDirectory);
+
+    const u64 checkedPages[] = { 0, 1, 255, 256, 1000, 4095, 4096, 4096 + 99 };
+
+    for(const u64 page : checkedPages)
+    {
+        if(!CheckTranslation(virtualPage + page, physicalPage + page))
+        {
+            FreePageTables();
+            return;
+        }
+    }
+
+    ConPrinter::PrintLn("Successfully mapped and walked 256 MiB of medium pages.");
+    FreePageTables();
+}
+
+static void TestLargePage() noexcept
+{
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    constexpr u64 virtualPage = 2ull << GpuLargePageShift;
+    constexpr u64 physicalPage = 0x40007;
+
+    if(!builder.Map(virtualPage, physicalPage, 1ull << GpuLargePageShift, MakeFlags(true)))
+    {
+        ConPrinter::PrintLn("Failed to map a large page.");
+        FreePageTables();
+        return;
+    }
+
+    if(!pageDirectory[2].LargePage || PageTableCount != 1)
+    {
+        ConPrinter::PrintLn("A whole directory entry was not mapped with a large page.");
+        FreePageTables();
+        return;
+    }
+
+    LoadPageDirectory(pageDirectory);
+
+    if(!CheckTranslation(virtualPage, physicalPage) || !CheckTranslation(virtualPage + 0x1234, physicalPage + 0x1234) || !CheckTranslation(virtualPage + 0xFFFF, physicalPage + 0xFFFF))
+    {
+        FreePageTables();
+        return;
+    }
+
+    ConPrinter::PrintLn("Successfully mapped and walked a large page.");
+    FreePageTables();
+}
+
+static void TestLargePageOverPageTable() noexcept
+{
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    constexpr u64 virtualPage = 3ull << GpuLargePageShift;
+
+    if(!builder.Map(virtualPage + 5, 0x777, 1, MakeFlags(false)))
+    {
+        ConPrinter::PrintLn("Failed to map a single page.");
+        FreePageTables();
+        return;
+    }
+
+    const u64 pageTableAddress = pageDirectory[3].PhysicalAddress;
+
+    // A whole directory entry, but a page table is already there.
+    if(!builder.Map(virtualPage, 0x50000, 1ull << GpuLargePageShift, MakeFlags(true)))
+    {
+        ConPrinter::PrintLn("Failed to map a whole directory entry over a page table.");
+        FreePageTables();
+        return;
+    }
+
+    if(pageDirectory[3].LargePage || pageDirectory[3].PhysicalAddress != pageTableAddress || PageTableCount != 2)
+    {
+        ConPrinter::PrintLn("Mapping a whole directory entry replaced its page table.");
+        FreePageTables();
+        return;
+    }
+
+    LoadPageDirectory(pageDirectory);
+
+    if(!CheckTranslation(virtualPage + 5, 0x50005) || !CheckTranslation(virtualPage + 60000, 0x50000 + 60000))
+    {
+        FreePageTables();
+        return;
+    }
+
+    ConPrinter::PrintLn("Successfully mapped a whole directory entry over an existing page table.");
+    FreePageTables();
+}
+
+static void TestPartialMediumPageRemap() noexcept
+{
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    constexpr u64 virtualPage = 1ull << GpuLargePageShift;
+    constexpr u64 mediumPagePageCount = 1ull << GpuMediumPageShift;
+
+    if(!builder.Map(virtualPage, 0x20000, mediumPagePageCount * 2, MakeFlags(true)) || !builder.Map(virtualPage + 10, 0x99999, 1, MakeFlags(true)))
+    {
+        ConPrinter::PrintLn("Failed to remap part of a medium page.");
+        FreePageTables();
+        return;
+    }
+
+    const PageEntry* const pageTable = reinterpret_cast<const PageEntry*>(pageDirectory[1].PhysicalAddress * GpuPageSize);
+
+    if(pageTable[0].LargePage || pageTable[11].LargePage || !pageTable[mediumPagePageCount].LargePage)
+    {
+        ConPrinter::PrintLn("Remapping part of a medium page did not demote just that medium page.");
+        FreePageTables();
+        return;
+    }
+
+    LoadPageDirectory(pageDirectory);
+
+    if(!CheckTranslation(virtualPage + 10, 0x99999) || !CheckTranslation(virtualPage + 11, 0x20000 + 11) || !CheckTranslation(virtualPage + mediumPagePageCount + 3, 0x20000 + mediumPagePageCount + 3))
+    {
+        FreePageTables();
+        return;
+    }
+
+    ConPrinter::PrintLn("Successfully remapped part of a medium page.");
+    FreePageTables();
+}
+
+static void TestMediumPageAccessedDirty() noexcept
+{
+    PageEntry* const pageDirectory = AllocatePageTable(nullptr);
+    PageTableBuilder builder(pageDirectory, AllocatePageTable, nullptr);
+
+    constexpr u64 virtualPage = 1ull << GpuLargePageShift;
+    constexpr u64 mediumPagePageCount = 1ull << GpuMediumPageShift;
+    constexpr u64 physicalPage = 0x30000;
+
+    if(!builder.Map(virtualPage, physicalPage, mediumPagePageCount * 2, MakeFlags(true)))
+    {
+        ConPrinter::PrintLn("Failed to map 2 medium pages.");
+        FreePageTables();
+        return;
+    }
+
+    const PageEntry* const pageTable = reinterpret_cast<const PageEntry*>(pageDirectory[1].PhysicalAddress * GpuPageSize);
+
+    LoadPageDirectory(pageDirectory);
+
+    // Store to a page in the middle of the first run and read from one in the middle of the second.
+    bool success = false;
+    bool readWrite = false;
+    (void) TestMmu.TranslateWriteAddress((virtualPage + 5) << Mmu::PAGE_OFFSET_BITS, &success, &readWrite, nullptr, nullptr, nullptr, nullptr);
+    const bool writeSucceeded = success && readWrite;
+    (void) TestMmu.TranslateAddress((virtualPage + mediumPagePageCount + 7) << Mmu::PAGE_OFFSET_BITS, &success, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+    const bool pendingBeforeWriteback = TestMmu.HasPendingWriteback();
+    TestMmu.WriteBackPageEntries();
+
+    const PageEntry& firstRun = pageTable[0];
+    const PageEntry& secondRun = pageTable[mediumPagePageCount];
+
+    if(!writeSucceeded || !success || !pendingBeforeWriteback)
+    {
+        ConPrinter::PrintLn("Failed to translate into 2 medium pages.");
+    }
+    else if(!firstRun.Accessed || !firstRun.Dirty || !secondRun.Accessed || secondRun.Dirty)
+    {
+        ConPrinter::PrintLn("The first entries of the runs were written back as Accessed {} Dirty {} and Accessed {} Dirty {}.", firstRun.Accessed, firstRun.Dirty, secondRun.Accessed, secondRun.Dirty);
+    }
+    else if(pageTable[5].Accessed || pageTable[5].Dirty || pageTable[mediumPagePageCount + 7].Accessed)
+    {
+        ConPrinter::PrintLn("The Accessed and Dirty bits were written to the touched entries instead of the first entries of their runs.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully wrote back the Accessed and Dirty bits of medium pages to the first entries of their runs.");
+    }
+
+    FreePageTables();
+}
+
+static PageEntry* AllocatePageTable(void*) noexcept
+{
+    if(PageTableCount == sizeof(PageTables) / sizeof(PageTables[0]))
+    {
+        return nullptr;
+    }
+
+    void* const pageTable = ::operator new(GpuPageTableSize, ::std::align_val_t { GpuPageSize }, ::std::nothrow);
+
+    if(!pageTable)
+    {
+        return nullptr;
+    }
+
+    (void) ::std::memset(pageTable, 0, GpuPageTableSize);
+
+    PageTables[PageTableCount++] = static_cast<PageEntry*>(pageTable);
+    return static_cast<PageEntry*>(pageTable);
+}
+
+static void FreePageTables() noexcept
+{
+    for(u32 i = 0; i < PageTableCount; ++i)
+    {
+        ::operator delete(PageTables[i], ::std::align_val_t { GpuPageSize });
+    }
+
+    PageTableCount = 0;
+}
+
+static PageEntry MakeFlags(const bool readWrite) noexcept
+{
+    PageEntry flags;
+    flags.Value = 0;
+    flags.ReadWrite = readWrite;
+    return flags;
+}
+
+static void LoadPageDirectory(PageEntry* const pageDirectory) noexcept
+{
+    // Start cold so the first translation of each span walks the page tables, later ones come from the medium and large page TLBs.
+    TestMmu.Reset();
+    TestMmu.LoadPageDirectoryPointer(reinterpret_cast<u64>(pageDirectory) / GpuPageSize, 0);
+}
+
+static bool CheckTranslation(const u64 virtualPage, const u64 expectedPhysicalPage) noexcept
+{
+    constexpr u64 wordOffset = 0x123;
+
+    bool success = false;
+    const u64 physicalAddress = TestMmu.TranslateAddress((virtualPage << Mmu::PAGE_OFFSET_BITS) | wordOffset, &success, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+    if(!success || physicalAddress != ((expectedPhysicalPage << Mmu::PAGE_OFFSET_BITS) | wordOffset))
+    {
+        ConPrinter::PrintLn("Virtual page 0x{X} translated to 0x{X}, expected page 0x{X}.", virtualPage, physicalAddress, expectedPhysicalPage);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,300 @@
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+
+static void TestClockNFullBatch() noexcept;
+static void TestClockNBreakpoint() noexcept;
+static void TestClockNPastBreakpoint() noexcept;
+static void TestClockNMatchesClock() noexcept;
+static void TestThreadedCodeWrite() noexcept;
+
+// The largest start delay of the patched program, enough to decode before and after the patching store.
+static inline constexpr u32 CODE_WRITE_MAX_DELAY = 8;
+static inline constexpr u32 CODE_WRITE_CYCLE_COUNT = 128;
+static inline constexpr u32 ORIGINAL_IMMEDIATE = 0x11111111;
+static inline constexpr u32 PATCHED_IMMEDIATE = 0x22222222;
+
+// The ClockN program halts well within the cycle count, the breakpoint is while it is still loading registers and the rest is skipped as quiescent.
+static inline constexpr u32 CLOCK_N_CYCLE_COUNT = 128;
+static inline constexpr u32 CLOCK_N_BREAKPOINT_CYCLE = 21;
+static inline constexpr u32 CLOCK_N_REGISTER_COUNT = 16;
+static inline constexpr u32 CLOCK_N_LOAD_COUNT = CLOCK_N_REGISTER_COUNT * 8;
+
+static Processor ClockProcessor;
+// CLOCK_N_LOAD_COUNT LoadImmediates cycling through the first CLOCK_N_REGISTER_COUNT registers, then Hlt.
+alignas(4) static u8 ClockNProgram[CLOCK_N_LOAD_COUNT * 6 + 1];
+// Nop, Nop, LoadImmediate r0, Hlt. The immediate is the second word so a single store can patch it.
+alignas(4) static u8 PatchedProgram[12];
+alignas(4) static u8 PatchingProgram[32];
+
+namespace tau::test::processor_clock {
+
+void RunTests() noexcept
+{
+    TestClockNFullBatch();
+    TestClockNBreakpoint();
+    TestClockNPastBreakpoint();
+    TestClockNMatchesClock();
+    TestThreadedCodeWrite();
+}
+
+}
+
+static void TestClockNFullBatch() noexcept
+{
+    ClockProcessor.Reset();
+    ClockProcessor.SetCycleBreakpoint(0);
+
+    const u64 clocked = ClockProcessor.ClockN(Processor::CLOCK_BATCH_CYCLES);
+
+    if(clocked != Processor::CLOCK_BATCH_CYCLES || ClockProcessor.ClockCycle() != Processor::CLOCK_BATCH_CYCLES)
+    {
+        ConPrinter::PrintLn("ClockN clocked {} cycles to cycle {}, expected {}.", clocked, ClockProcessor.ClockCycle(), Processor::CLOCK_BATCH_CYCLES);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully clocked a full ClockN batch.");
+    }
+}
+
+static void TestClockNBreakpoint() noexcept
+{
+    ClockProcessor.Reset();
+    ClockProcessor.SetCycleBreakpoint(50);
+
+    const u64 clocked = ClockProcessor.ClockN(100);
+
+    if(clocked != 50 || ClockProcessor.ClockCycle() != 50)
+    {
+        ConPrinter::PrintLn("ClockN with a breakpoint at cycle 50 clocked {} cycles to cycle {}.", clocked, ClockProcessor.ClockCycle());
+    }
+    else if(ClockProcessor.CycleBreakpoint() != 0)
+    {
+        ConPrinter::PrintLn("ClockN did not clear the breakpoint at cycle 50 once it was hit.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully stopped ClockN at a cycle breakpoint.");
+    }
+}
+
+static void TestClockNPastBreakpoint() noexcept
+{
+    ClockProcessor.Reset();
+    ClockProcessor.SetCycleBreakpoint(0);
+
+    (void) ClockProcessor.ClockN(100);
+
+    // A breakpoint behind the current cycle must neither stop the batch nor wrap it around.
+    ClockProcessor.SetCycleBreakpoint(10);
+
+    const u64 clocked = ClockProcessor.ClockN(20);
+
+    if(clocked != 20 || ClockProcessor.ClockCycle() != 120)
+    {
+        ConPrinter::PrintLn("ClockN with a breakpoint in the past clocked {} cycles to cycle {}, expected 20 cycles to cycle 120.", clocked, ClockProcessor.ClockCycle());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully ignored a cycle breakpoint in the past.");
+    }
+
+    ClockProcessor.SetCycleBreakpoint(0);
+}
+
+static u32 WriteLoadImmediate(u8* program, u32 offset, u8 registerIndex, u32 value) noexcept;
+
+struct ClockState final
+{
+    u32 Cycle;
+    bool Quiescent;
+    u32 Registers[CLOCK_N_REGISTER_COUNT];
+};
+
+[[nodiscard]] static ClockState CaptureClockState() noexcept
+{
+    ClockState state { };
+    state.Cycle = ClockProcessor.ClockCycle();
+    state.Quiescent = ClockProcessor.IsQuiescent();
+
+    for(u32 i = 0; i < CLOCK_N_REGISTER_COUNT; ++i)
+    {
+        state.Registers[i] = ClockProcessor.TestReadRegister(0, i);
+    }
+
+    return state;
+}
+
+static void LoadClockNProgram() noexcept
+{
+    ClockProcessor.Reset();
+    ClockProcessor.SetCycleBreakpoint(0);
+    ClockProcessor.TestLoadProgram(0, 0, 0x1, ClockNProgram);
+}
+
+static void TestClockNMatchesClock() noexcept
+{
+    u32 offset = 0;
+
+    for(u32 i = 0; i < CLOCK_N_LOAD_COUNT; ++i)
+    {
+        offset = WriteLoadImmediate(ClockNProgram, offset, static_cast<u8>(i % CLOCK_N_REGISTER_COUNT), 0x1000 + i);
+    }
+
+    ClockNProgram[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LoadClockNProgram();
+
+    for(u32 i = 0; i < CLOCK_N_BREAKPOINT_CYCLE; ++i)
+    {
+        ClockProcessor.Clock();
+    }
+
+    const ClockState breakpointClock = CaptureClockState();
+
+    for(u32 i = CLOCK_N_BREAKPOINT_CYCLE; i < CLOCK_N_CYCLE_COUNT; ++i)
+    {
+        ClockProcessor.Clock();
+    }
+
+    const ClockState endClock = CaptureClockState();
+
+    // The same cycles as batches, the first stopping at the breakpoint part way through the program.
+    LoadClockNProgram();
+    ClockProcessor.SetCycleBreakpoint(CLOCK_N_BREAKPOINT_CYCLE);
+
+    const u64 breakpointClocked = ClockProcessor.ClockN(CLOCK_N_CYCLE_COUNT);
+    const ClockState breakpointClockN = CaptureClockState();
+    const u64 endClocked = ClockProcessor.ClockN(CLOCK_N_CYCLE_COUNT - breakpointClocked);
+    const ClockState endClockN = CaptureClockState();
+
+    if(breakpointClock.Quiescent || !endClock.Quiescent || endClock.Registers[CLOCK_N_REGISTER_COUNT - 1] != 0x1000 + CLOCK_N_LOAD_COUNT - 1)
+    {
+        ConPrinter::PrintLn("The ClockN program was not running at cycle {} or had not halted by cycle {}.", CLOCK_N_BREAKPOINT_CYCLE, CLOCK_N_CYCLE_COUNT);
+    }
+    else if(breakpointClocked != CLOCK_N_BREAKPOINT_CYCLE || ::std::memcmp(&breakpointClockN, &breakpointClock, sizeof(ClockState)) != 0)
+    {
+        ConPrinter::PrintLn("ClockN stopped after {} cycles at cycle {}, with a different state than {} calls to Clock.", breakpointClocked, breakpointClockN.Cycle, CLOCK_N_BREAKPOINT_CYCLE);
+    }
+    else if(endClocked != CLOCK_N_CYCLE_COUNT - CLOCK_N_BREAKPOINT_CYCLE || ::std::memcmp(&endClockN, &endClock, sizeof(ClockState)) != 0)
+    {
+        ConPrinter::PrintLn("ClockN resumed for {} cycles to cycle {}, with a different state than {} calls to Clock.", endClocked, endClockN.Cycle, CLOCK_N_CYCLE_COUNT);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully ran a program to the same state with ClockN as with Clock, through a breakpoint.");
+    }
+
+    ClockProcessor.SetCycleBreakpoint(0);
+}
+
+static u32 WriteLoadImmediate(u8* const program, const u32 offset, const u8 registerIndex, const u32 value) noexcept
+{
+    program[offset] = static_cast<u8>(EInstruction::LoadImmediate);
+    program[offset + 1] = registerIndex;
+    (void) ::std::memcpy(&program[offset + 2], &value, sizeof(value));
+    return offset + 6;
+}
+
+static void BuildCodeWritePrograms() noexcept
+{
+    PatchedProgram[0] = static_cast<u8>(EInstruction::Nop);
+    PatchedProgram[1] = static_cast<u8>(EInstruction::Nop);
+    (void) WriteLoadImmediate(PatchedProgram, 2, 0, ORIGINAL_IMMEDIATE);
+    PatchedProgram[8] = static_cast<u8>(EInstruction::Hlt);
+
+    // Stores r2 over the immediate of the patched program.
+    const u64 immediateAddress = (reinterpret_cast<uintptr_t>(PatchedProgram) >> 2) + 1;
+    u32 offset = 0;
+    offset = WriteLoadImmediate(PatchingProgram, offset, 0, static_cast<u32>(immediateAddress));
+    offset = WriteLoadImmediate(PatchingProgram, offset, 1, static_cast<u32>(immediateAddress >> 32));
+    offset = WriteLoadImmediate(PatchingProgram, offset, 2, PATCHED_IMMEDIATE);
+    PatchingProgram[offset++] = static_cast<u8>(EInstruction::LoadStore);
+    PatchingProgram[offset++] = 0x40 | (7 << 3);
+    PatchingProgram[offset++] = 0;
+    PatchingProgram[offset++] = 2;
+    PatchingProgram[offset++] = 0;
+    PatchingProgram[offset++] = 0;
+    PatchingProgram[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+struct CodeWriteResult final
+{
+    u32 PatchedRegister;
+    u32 PatchingRegister;
+    u32 Immediate;
+};
+
+// SM 1 decodes the patched program, then runs it again delay cycles after SM 0 starts patching it.
+[[nodiscard]] static CodeWriteResult RunCodeWrite(const u32 delay) noexcept
+{
+    (void) WriteLoadImmediate(PatchedProgram, 2, 0, ORIGINAL_IMMEDIATE);
+
+    ClockProcessor.Reset();
+    ClockProcessor.SetCycleBreakpoint(0);
+    ClockProcessor.TestLoadProgram(1, 0, 0x1, PatchedProgram);
+    (void) ClockProcessor.ClockN(CODE_WRITE_CYCLE_COUNT);
+
+    ClockProcessor.TestLoadProgram(0, 0, 0x1, PatchingProgram);
+    (void) ClockProcessor.ClockN(delay);
+    ClockProcessor.TestLoadProgram(1, 0, 0x1, PatchedProgram);
+    (void) ClockProcessor.ClockN(CODE_WRITE_CYCLE_COUNT);
+
+    ClockProcessor.FlushCache(0);
+
+    CodeWriteResult result;
+    result.PatchedRegister = ClockProcessor.TestReadRegister(1, 0);
+    result.PatchingRegister = ClockProcessor.TestReadRegister(0, 2);
+    (void) ::std::memcpy(&result.Immediate, &PatchedProgram[4], sizeof(result.Immediate));
+    return result;
+}
+
+static void TestThreadedCodeWrite() noexcept
+{
+    BuildCodeWritePrograms();
+
+    CodeWriteResult serialResults[CODE_WRITE_MAX_DELAY + 1];
+
+    for(u32 delay = 0; delay <= CODE_WRITE_MAX_DELAY; ++delay)
+    {
+        serialResults[delay] = RunCodeWrite(delay);
+    }
+
+    ClockProcessor.SetThreadedClock(true);
+
+    if(!ClockProcessor.ThreadedClock())
+    {
+        ConPrinter::PrintLn("The threaded clock could not start, the patched code was only run on the serial clock.");
+        return;
+    }
+
+    u32 firstMismatch = CODE_WRITE_MAX_DELAY + 1;
+    CodeWriteResult threadedResult { };
+
+    for(u32 delay = 0; delay <= CODE_WRITE_MAX_DELAY; ++delay)
+    {
+        threadedResult = RunCodeWrite(delay);
+
+        if(::std::memcmp(&threadedResult, &serialResults[delay], sizeof(threadedResult)) != 0)
+        {
+            firstMismatch = delay;
+            break;
+        }
+    }
+
+    ClockProcessor.SetThreadedClock(false);
+
+    // The sweep only means something if it crossed the store, the first run has to miss it and the last has to see it.
+    if(firstMismatch <= CODE_WRITE_MAX_DELAY)
+    {
+        ConPrinter::PrintLn("The threaded clock loaded 0x{X} over the patched code with a delay of {}, the serial clock loaded 0x{X}.", threadedResult.PatchedRegister, firstMismatch, serialResults[firstMismatch].PatchedRegister);
+    }
+    else if(serialResults[0].PatchedRegister != ORIGINAL_IMMEDIATE || serialResults[CODE_WRITE_MAX_DELAY].PatchedRegister != PATCHED_IMMEDIATE || serialResults[CODE_WRITE_MAX_DELAY].Immediate != PATCHED_IMMEDIATE)
+    {
+        ConPrinter::PrintLn("The patched code loaded 0x{X} with no delay and 0x{X} with a delay of {}.", serialResults[0].PatchedRegister, serialResults[CODE_WRITE_MAX_DELAY].PatchedRegister, CODE_WRITE_MAX_DELAY);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully ran code patched by another SM to the same state on the serial and threaded clocks.");
+    }
+}
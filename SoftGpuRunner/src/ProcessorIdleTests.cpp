@@ -0,0 +1,212 @@
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <Windows.h>
+
+static void StartProcessorThread() noexcept;
+static void StopProcessorThread() noexcept;
+[[nodiscard]] static bool WaitForPark() noexcept;
+[[nodiscard]] static bool WaitForWake() noexcept;
+[[nodiscard]] static u64 ProcessorThreadCpuTime100ns() noexcept;
+
+static void TestIdleCpuTime() noexcept;
+static void TestWakeLatency() noexcept;
+
+static Processor IdleProcessor;
+static ::std::atomic_bool ProcessorShouldExit(false);
+static ::std::thread ProcessorThread;
+
+// Far longer than parking or waking should ever take, so a failure is a hang rather than a slow host.
+static inline constexpr auto STATE_CHANGE_TIMEOUT = ::std::chrono::seconds(10);
+// A wake should be a few microseconds, these leave room for a busy host to deschedule the processor thread for a quantum or two.
+static inline constexpr u64 MAX_AVERAGE_WAKE_MICROSECONDS = 1000;
+static inline constexpr u64 MAX_WAKE_MICROSECONDS = 50000;
+
+namespace tau::test::processor_idle {
+
+void RunTests() noexcept
+{
+    StartProcessorThread();
+
+    TestIdleCpuTime();
+    TestWakeLatency();
+
+    StopProcessorThread();
+}
+
+}
+
+static void StartProcessorThread() noexcept
+{
+    ProcessorShouldExit = false;
+
+    // The same loop as the VirtualBox device.
+    ProcessorThread = ::std::thread([]()
+    {
+        while(!ProcessorShouldExit)
+        {
+            IdleProcessor.Clock();
+
+            if(!IdleProcessor.WaitForWork())
+            {
+                ::std::this_thread::yield();
+            }
+        }
+    });
+}
+
+static void StopProcessorThread() noexcept
+{
+    ProcessorShouldExit = true;
+    IdleProcessor.RingDoorbell();
+    ProcessorThread.join();
+}
+
+// Waits for the processor thread to run past Processor::PARK_AFTER_QUIESCENT_CYCLES and block in WaitForWork.
+static bool WaitForPark() noexcept
+{
+    const auto deadline = ::std::chrono::steady_clock::now() + STATE_CHANGE_TIMEOUT;
+
+    while(!IdleProcessor.IsParked())
+    {
+        if(::std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+
+        ::std::this_thread::sleep_for(::std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+static bool WaitForWake() noexcept
+{
+    const auto deadline = ::std::chrono::steady_clock::now() + STATE_CHANGE_TIMEOUT;
+
+    // Yield rather than spin so the processor thread isn't starved on a small host.
+    while(IdleProcessor.IsParked())
+    {
+        if(::std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+
+        ::std::this_thread::yield();
+    }
+
+    return true;
+}
+
+static u64 ProcessorThreadCpuTime100ns() noexcept
+{
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+
+    if(!GetThreadTimes(ProcessorThread.native_handle(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return 0;
+    }
+
+    const u64 kernel = (static_cast<u64>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    const u64 user = (static_cast<u64>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+
+    return kernel + user;
+}
+
+static void TestIdleCpuTime() noexcept
+{
+    if(!WaitForPark())
+    {
+        ConPrinter::PrintLn("The idle processor thread never parked in WaitForWork.");
+        return;
+    }
+
+    const u32 parkCount = IdleProcessor.ParkCount();
+    const u64 cpuStart = ProcessorThreadCpuTime100ns();
+    const auto wallStart = ::std::chrono::steady_clock::now();
+
+    ::std::this_thread::sleep_for(::std::chrono::seconds(1));
+
+    const u64 cpuEnd = ProcessorThreadCpuTime100ns();
+    const auto wallEnd = ::std::chrono::steady_clock::now();
+
+    const u64 cpuMicroseconds = (cpuEnd - cpuStart) / 10;
+    const u64 wallMicroseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::microseconds>(wallEnd - wallStart).count());
+
+    if(!IdleProcessor.IsParked() || IdleProcessor.ParkCount() != parkCount)
+    {
+        ConPrinter::PrintLn("The parked processor thread woke up {} times with nothing to do.", IdleProcessor.ParkCount() - parkCount);
+    }
+    // An idle processor should barely register, anything over 1% means it is still spinning.
+    else if(cpuMicroseconds * 100 > wallMicroseconds)
+    {
+        ConPrinter::PrintLn("Idle processor thread used {}us of CPU time over {}us.", cpuMicroseconds, wallMicroseconds);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully parked idle processor thread, used {}us of CPU time over {}us.", cpuMicroseconds, wallMicroseconds);
+    }
+}
+
+static void TestWakeLatency() noexcept
+{
+    constexpr u32 iterationCount = 100;
+
+    u64 totalMicroseconds = 0;
+    u64 maxMicroseconds = 0;
+
+    for(u32 i = 0; i < iterationCount; ++i)
+    {
+        if(!WaitForPark())
+        {
+            ConPrinter::PrintLn("The processor thread didn't park again after wake {}.", i);
+            return;
+        }
+
+        const auto start = ::std::chrono::steady_clock::now();
+
+        // A VSync is posted from the display thread in the device, it rings the doorbell and is consumed on the next clock.
+        IdleProcessor.GetDisplayManager().SetDisplayVSyncEvent(0);
+
+        if(!WaitForWake())
+        {
+            ConPrinter::PrintLn("The doorbell didn't wake the parked processor thread on wake {}.", i);
+            return;
+        }
+
+        while(IdleProcessor.GetDisplayManager().HasPendingWork())
+        {
+            ::std::this_thread::yield();
+        }
+
+        const auto end = ::std::chrono::steady_clock::now();
+
+        const u64 microseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::microseconds>(end - start).count());
+
+        totalMicroseconds += microseconds;
+
+        if(microseconds > maxMicroseconds)
+        {
+            maxMicroseconds = microseconds;
+        }
+    }
+
+    const u64 averageMicroseconds = totalMicroseconds / iterationCount;
+
+    if(averageMicroseconds > MAX_AVERAGE_WAKE_MICROSECONDS || maxMicroseconds > MAX_WAKE_MICROSECONDS)
+    {
+        ConPrinter::PrintLn("Processor wake up latency over {} wakes was too high: average {}us, max {}us.", iterationCount, averageMicroseconds, maxMicroseconds);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully woke the parked processor thread {} times: average {}us, max {}us.", iterationCount, averageMicroseconds, maxMicroseconds);
+    }
+}
@@ -0,0 +1,213 @@
+#include <ConPrinter.hpp>
+
+#include <ReplacementPolicy.hpp>
+
+static void TestLruVictims() noexcept;
+static void TestTreePlruVictims() noexcept;
+static void TestSrripVictims() noexcept;
+static void TestBrripVictims() noexcept;
+static void TestUnkeptVictim() noexcept;
+static void TestAllKeptVictim() noexcept;
+
+// Small enough to follow each policy's state by hand.
+static inline constexpr uSys WAY_COUNT = 4;
+static inline constexpr uSys VICTIM_COUNT = 4;
+
+namespace tau::test::replacement_policy {
+
+void RunTests() noexcept
+{
+    TestLruVictims();
+    TestTreePlruVictims();
+    TestSrripVictims();
+    TestBrripVictims();
+    TestUnkeptVictim();
+    TestAllKeptVictim();
+}
+
+}
+
+// Fills every way in order, the way a cold set is filled before the first eviction.
+template<typename Policy>
+static void FillSet(Policy& policy, typename Policy::SetState& state) noexcept
+{
+    policy.Reset();
+    Policy::ResetSet(state);
+
+    for(uSys way = 0; way < WAY_COUNT; ++way)
+    {
+        policy.OnFill(state, way);
+    }
+}
+
+// Evicts and refills VICTIM_COUNT times, returns whether the victims were the expected ones.
+template<typename Policy>
+[[nodiscard]] static bool EvictInOrder(Policy& policy, typename Policy::SetState& state, const uSys (&expected)[VICTIM_COUNT], uSys (&victims)[VICTIM_COUNT]) noexcept
+{
+    bool inOrder = true;
+
+    for(uSys i = 0; i < VICTIM_COUNT; ++i)
+    {
+        victims[i] = policy.SelectVictim(state);
+        policy.OnFill(state, victims[i]);
+        inOrder = inOrder && victims[i] == expected[i];
+    }
+
+    return inOrder;
+}
+
+static void TestLruVictims() noexcept
+{
+    LruReplacement<WAY_COUNT> policy;
+    LruReplacement<WAY_COUNT>::SetState state;
+
+    FillSet(policy, state);
+
+    // Leaves 1 least recently used, then 3, then the hit ways in hit order.
+    policy.OnHit(state, 0);
+    policy.OnHit(state, 2);
+
+    const uSys hitOrder[VICTIM_COUNT] = { 1, 3, 0, 2 };
+    uSys victims[VICTIM_COUNT];
+
+    if(!EvictInOrder(policy, state, hitOrder, victims))
+    {
+        ConPrinter::PrintLn("LRU evicted ways {} {} {} {} after hits on ways 0 and 2, expected 1 3 0 2.", victims[0], victims[1], victims[2], victims[3]);
+        return;
+    }
+
+    // A demoted way goes next whatever its rank was.
+    FillSet(policy, state);
+    policy.OnDemote(state, 3);
+
+    const uSys demotedOrder[VICTIM_COUNT] = { 3, 0, 1, 2 };
+
+    if(!EvictInOrder(policy, state, demotedOrder, victims))
+    {
+        ConPrinter::PrintLn("LRU evicted ways {} {} {} {} after demoting way 3, expected 3 0 1 2.", victims[0], victims[1], victims[2], victims[3]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully evicted in LRU order.");
+    }
+}
+
+static void TestTreePlruVictims() noexcept
+{
+    TreePlruReplacement<WAY_COUNT> policy;
+    TreePlruReplacement<WAY_COUNT>::SetState state;
+
+    FillSet(policy, state);
+
+    // Each fill points the root at the other half, so the victims alternate between the halves.
+    const uSys fillOrder[VICTIM_COUNT] = { 0, 2, 1, 3 };
+    uSys victims[VICTIM_COUNT];
+
+    if(!EvictInOrder(policy, state, fillOrder, victims))
+    {
+        ConPrinter::PrintLn("Tree PLRU evicted ways {} {} {} {}, expected 0 2 1 3.", victims[0], victims[1], victims[2], victims[3]);
+        return;
+    }
+
+    // A hit on 0 moves the victim to the other half, a demotion of 1 brings it straight back.
+    FillSet(policy, state);
+    policy.OnHit(state, 0);
+    const uSys afterHit = policy.SelectVictim(state);
+    policy.OnDemote(state, 1);
+    const uSys afterDemote = policy.SelectVictim(state);
+
+    if(afterHit != 2 || afterDemote != 1)
+    {
+        ConPrinter::PrintLn("Tree PLRU chose way {} after a hit on way 0 and way {} after demoting way 1, expected 2 and 1.", afterHit, afterDemote);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully evicted in tree PLRU order.");
+    }
+}
+
+static void TestSrripVictims() noexcept
+{
+    RripReplacement<WAY_COUNT, false> policy;
+    RripReplacement<WAY_COUNT, false>::SetState state;
+
+    FillSet(policy, state);
+
+    // Every way is inserted with a long prediction, the hit on 1 predicts it near so ageing reaches the others first.
+    policy.OnHit(state, 1);
+
+    const uSys hitOrder[VICTIM_COUNT] = { 0, 2, 3, 0 };
+    uSys victims[VICTIM_COUNT];
+
+    if(!EvictInOrder(policy, state, hitOrder, victims))
+    {
+        ConPrinter::PrintLn("SRRIP evicted ways {} {} {} {} after a hit on way 1, expected 0 2 3 0.", victims[0], victims[1], victims[2], victims[3]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully evicted in SRRIP order, keeping the re-referenced way.");
+    }
+}
+
+static void TestBrripVictims() noexcept
+{
+    RripReplacement<WAY_COUNT, true> policy;
+    RripReplacement<WAY_COUNT, true>::SetState state;
+
+    FillSet(policy, state);
+
+    // Only the first fill of the period gets a long prediction, the distant fills after it keep replacing each other.
+    const uSys streamingOrder[VICTIM_COUNT] = { 1, 1, 1, 1 };
+    uSys victims[VICTIM_COUNT];
+
+    if(!EvictInOrder(policy, state, streamingOrder, victims))
+    {
+        ConPrinter::PrintLn("BRRIP evicted ways {} {} {} {}, expected way 1 every time.", victims[0], victims[1], victims[2], victims[3]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully kept BRRIP streaming fills to a single way.");
+    }
+}
+
+static void TestUnkeptVictim() noexcept
+{
+    LruReplacement<WAY_COUNT> policy;
+    LruReplacement<WAY_COUNT>::SetState state;
+
+    FillSet(policy, state);
+
+    // 0 and 1 are the 2 least recently used ways, keeping them passes the choice on to 2.
+    const uSys victim = SelectUnkeptVictim<WAY_COUNT>(policy, state, 0b0011);
+
+    if(victim != 2)
+    {
+        ConPrinter::PrintLn("Keeping ways 0 and 1 evicted way {}, expected way 2.", victim);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully passed over kept ways.");
+    }
+}
+
+static void TestAllKeptVictim() noexcept
+{
+    RripReplacement<WAY_COUNT, false> policy;
+    RripReplacement<WAY_COUNT, false>::SetState state;
+
+    FillSet(policy, state);
+    policy.OnHit(state, 0);
+
+    // With every way kept the hint is ignored, the policy's own victim goes and nothing is promoted on the way.
+    const uSys victim = SelectUnkeptVictim<WAY_COUNT>(policy, state, 0b1111);
+    const uSys nextVictim = policy.SelectVictim(state);
+
+    if(victim != 1 || nextVictim != 1)
+    {
+        ConPrinter::PrintLn("With every way kept SRRIP evicted way {} and then chose way {}, expected way 1 both times.", victim, nextVictim);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully fell back to the policy's victim with every way kept.");
+    }
+}
@@ -92,9 +92,14 @@ static DECLCALLBACK(VBOXSTRICTRC) softGpuMMIORead(PPDMDEVINS pDevIns, void* pvUs
         if(pFun->Processor.GetPciController().GetBARFromAddress(off) == 1)
         {
             const u64 address = pFun->Processor.GetPciController().GetBAROffset(off, 1) + pFun->Processor.RamBaseAddress();
-            (void) ::std::memcpy(pv, reinterpret_cast<void*>(address), cb);
 
-            return VINF_SUCCESS;
+            // Memory is only current when no cache holds the range, otherwise the processor thread snoops it.
+            if(!pFun->Processor.HostRangeMayBeCached(address, cb))
+            {
+                (void) ::std::memcpy(pv, reinterpret_cast<void*>(address), cb);
+
+                return VINF_SUCCESS;
+            }
         }
     }
 
@@ -140,9 +145,19 @@ static DECLCALLBACK(VBOXSTRICTRC) softGpuMMIOWrite(PPDMDEVINS pDevIns, void* pvU
         if(pFun->Processor.GetPciController().GetBARFromAddress(off) == 1)
         {
             const u64 address = pFun->Processor.GetPciController().GetBAROffset(off, 1) + pFun->Processor.RamBaseAddress();
-            (void) ::std::memcpy(reinterpret_cast<void*>(address), pv, cb);
 
-            return VINF_SUCCESS;
+            if(!pFun->Processor.HostRangeMayBeCached(address, cb))
+            {
+                (void) ::std::memcpy(reinterpret_cast<void*>(address), pv, cb);
+
+                // A line filled while the copy was running may hold the old data, the processor thread redoes the write then.
+                if(!pFun->Processor.HostRangeMayBeCached(address, cb))
+                {
+                    pFun->Processor.NotifyHostMemoryWrite(address, cb);
+
+                    return VINF_SUCCESS;
+                }
+            }
         }
     }
 
@@ -413,8 +428,13 @@ void ProcessorThreadFunc(SoftGpuDeviceFunction* pciFunction) noexcept
     {
         // ConPrinter::PrintLn(u8"Clock {}", i++);
 
-        pciFunction->Processor.Clock();
-        ::std::this_thread::yield();
+        (void) pciFunction->Processor.ClockN(Processor::CLOCK_BATCH_CYCLES);
+
+        // Sleeps until the guest or the display thread rings the doorbell if the GPU has gone idle.
+        if(!pciFunction->Processor.WaitForWork())
+        {
+            ::std::this_thread::yield();
+        }
     }
 
     ConLogLn(u8"Processor Thread Exiting");
@@ -440,7 +460,7 @@ static DECLCALLBACK(int) softGpuConstruct(PPDMDEVINS deviceInstance, int instanc
     /*
      * Validate and read the configuration.
      */
-    PDMDEV_VALIDATE_CONFIG_RETURN(deviceInstance, "ConfigBAR0MB|FrameBufferBAR1GB", "");
+    PDMDEV_VALIDATE_CONFIG_RETURN(deviceInstance, "ConfigBAR0MB|FrameBufferBAR1GB|ThreadedClock|FunctionalExecution|BlockInterpreter", "");
 
     ConLogLn("VBoxSoftGpuEmulator::softGpuConstruct: Validated config.");
 
@@ -497,6 +517,30 @@ static DECLCALLBACK(int) softGpuConstruct(PPDMDEVINS deviceInstance, int instanc
     //     secondBAR = static_cast<RTGCPHYS>(frameBufferBAR1GB) * _1G64;
     // }
 
+    bool threadedClock;
+    rc = pdmDeviceApi->pfnCFGMQueryBoolDef(cfg, "ThreadedClock", &threadedClock, false);
+
+    if(RT_FAILURE(rc))
+    {
+        return PDMDEV_SET_ERROR(deviceInstance, rc, N_("Configuration error: Failed to query boolean value \"ThreadedClock\""));
+    }
+
+    bool functionalExecution;
+    rc = pdmDeviceApi->pfnCFGMQueryBoolDef(cfg, "FunctionalExecution", &functionalExecution, false);
+
+    if(RT_FAILURE(rc))
+    {
+        return PDMDEV_SET_ERROR(deviceInstance, rc, N_("Configuration error: Failed to query boolean value \"FunctionalExecution\""));
+    }
+
+    bool blockInterpreter;
+    rc = pdmDeviceApi->pfnCFGMQueryBoolDef(cfg, "BlockInterpreter", &blockInterpreter, false);
+
+    if(RT_FAILURE(rc))
+    {
+        return PDMDEV_SET_ERROR(deviceInstance, rc, N_("Configuration error: Failed to query boolean value \"BlockInterpreter\""));
+    }
+
     ConLogLn(u8"VBoxSoftGpuEmulator::softGpuConstruct: BAR0 Size: 0x{XP0}", firstBAR);
     ConLogLn(u8"VBoxSoftGpuEmulator::softGpuConstruct: BAR1 Size: 0x{XP0}", secondBAR);
 
@@ -516,6 +560,18 @@ static DECLCALLBACK(int) softGpuConstruct(PPDMDEVINS deviceInstance, int instanc
     pciFunction->Framebuffer = VirtualAlloc(nullptr, static_cast<uSys>(secondBAR), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
     pciFunction->Processor.TestSetRamBaseAddress(reinterpret_cast<uPtr>(pciFunction->Framebuffer), secondBAR);
 
+    // Clock each SM on its own host thread, this is cycle identical to the serial clock.
+    pciFunction->Processor.SetThreadedClock(threadedClock);
+
+    // Skip the execution unit timing model, useful for booting and long running kernels.
+    if(functionalExecution)
+    {
+        pciFunction->Processor.SetExecutionMode(EExecutionMode::Functional);
+    }
+
+    // Run straight line code through cached blocks of specialized handlers, only used by the functional mode.
+    pciFunction->Processor.SetBlockInterpreter(blockInterpreter);
+
     ::new(&pciFunction->ProcessorShouldExit) ::std::atomic_bool(false);
     pciFunction->ProcessorSyncEvent = CreateEventA(nullptr, FALSE, FALSE, "SoftGpuSync");
     pciFunction->Processor.GetPciController().SetSimulationSyncEvent(pciFunction->ProcessorSyncEvent);
@@ -690,6 +746,7 @@ static DECLCALLBACK(int) softGpuDestruct(PPDMDEVINS deviceInstance) noexcept
     ConLogLn(u8"VBoxSoftGpuEmulator::softGpuDestruct: Telling processor thread to exit.");
 
     pciFunction.ProcessorShouldExit = true;
+    pciFunction.Processor.RingDoorbell();
 
     ConLogLn(u8"VBoxSoftGpuEmulator::softGpuDestruct: Processor thread told to exit.");
 